@@ -44,6 +44,228 @@
 
 namespace plugin {
 
+// how interface stores implementation
+enum class PimplStorageKind {
+  // impl is stored inside interface,
+  // see ::basis::FastPimpl
+  kInline
+  // interface stores single pointer,
+  // impl is allocated from pool shared by size class,
+  // see ::flex_pimpl_plugin::PoolPimpl
+  , kPool
+  // resolved to |kInline| or |kPool|
+  // based on impl size and `inlineBudget`
+  , kAuto
+  // impl is stored inside interface,
+  // but constructed on first access,
+  // see ::flex_pimpl_plugin::LazyPimpl
+  , kLazy
+  // impl is one of several alternatives stored inside interface,
+  // forwarders dispatch on index of stored alternative,
+  // see ::flex_pimpl_plugin::VariantPimpl
+  , kVariant
+  // copies of interface share impl,
+  // impl is cloned before modification of shared impl,
+  // see ::flex_pimpl_plugin::CowPimpl
+  , kCow
+  // impl is immutable snapshot published atomically,
+  // const forwarders read it without locks, non-const forwarders
+  // modify and publish clone of impl,
+  // see ::flex_pimpl_plugin::RcuPimpl
+  , kRcu
+};
+
+// based on profile summary (see `Settings::profileFile`)
+enum class PimplMethodHotness {
+  // profile not loaded or method is neither hot nor cold
+  kUnknown
+  // forwarder gets `[[gnu::hot]]` and can be inlined
+  // via `inline_forwarders`
+  , kHot
+  // method has no samples in profile, forwarder gets
+  // `[[gnu::cold]]` and `[[gnu::noinline]]`
+  , kCold
+};
+
+// see `forwarding` of `_pimplPolicy`
+enum class PimplForwarding {
+  // out-of-line forwarder, inline forwarder is generated
+  // by `inline_forwarders` (only for hot methods if profile is loaded)
+  kDefault
+  // inline forwarder is always generated by `inline_forwarders`
+  , kInline
+  // inline forwarder is never generated
+  , kOutOfLine
+};
+
+// see `locking` of `_pimplPolicy`,
+/// \note ordered by strength, interface stores mutex
+/// of strongest locking used by its methods
+enum class PimplLocking {
+  kNone
+  // forwarder holds mutex of interface while impl is called
+  , kExclusive
+  // interface stores ::std::shared_mutex, forwarders
+  // of const methods hold it shared (readers run concurrently),
+  // forwarders of non-const methods hold it exclusively
+  , kShared
+};
+
+// result cache of method with `memoize` policy,
+// stored by interface (see ::flex_pimpl_plugin::pimpl::MemoCache)
+struct PimplMemoCache {
+  // example: `bazMemo_`
+  std::string name;
+
+  // decayed parameter types, example: `::std::tuple<int>`
+  std::string keyType;
+
+  // example: `::std::string`
+  std::string valueType;
+
+  size_t capacity = 0;
+
+  // key and value can be moved without exceptions
+  bool isNothrowMovable = false;
+};
+
+// field of impl, used to generate `snapshot` and `restore`
+// (see `snapshot` argument of `_injectPimplMethodCalls`)
+struct PimplFieldInfo {
+  // example: `data_`
+  std::string name;
+
+  // fully qualified type, example: `::std::string`
+  std::string type;
+};
+
+// entry of table of forwarders generated for `storage = variant`
+// with `isa_1`, `isa_2`, etc. (see ::flex_pimpl_plugin::CpuDispatchPimpl)
+// or for `hot_swap` (see ::flex_pimpl_plugin::pimpl::HotSwapSlot)
+struct PimplDispatchEntry {
+  // name of function pointer, unique for overloads
+  // example: `foo`, `foo_1`
+  std::string name;
+
+  // fully qualified, example: `::std::string`
+  std::string returnType;
+
+  // example: `int && arg1, const int & arg2`
+  std::string paramDecls;
+
+  // example: `foo(::std::move(arg1), arg2)`
+  std::string methodCall;
+
+  bool isConst = false;
+};
+
+// method that can be called by name,
+// see `by_name` argument of `_injectPimplMethodCalls`
+struct PimplNamedMethod {
+  // example: `foo`
+  std::string name;
+
+  // arguments of forwarder extracted from `void* const* args`,
+  // example: `::std::move(*static_cast<int*>(args[0]))`
+  std::string invokerArgs;
+
+  size_t arity = 0;
+
+  // type of value constructed in `result`,
+  // empty if method returns void, example: `::std::string`
+  std::string resultType;
+
+  bool isConst = false;
+};
+
+// how C facade returns result of method,
+// see `c_api` argument of `_injectPimplMethodCalls`
+enum class PimplCApiResult {
+  kVoid
+  // arithmetic type or enum, returned by value
+  , kScalar
+  // `flex_pimpl_string_view` that points to string owned by impl,
+  // used for `const ::std::string&` and `::std::string_view`
+  , kStringView
+  // `::std::string` returned by value is copied into buffer of caller
+  , kStringCopy
+};
+
+// signature of function of C facade
+/// \note strings and spans are passed as pointer and size,
+/// so facade does not build temporary objects
+/// if impl accepts `::std::string_view` or `::base::span`
+struct PimplCApiSignature {
+  // false if some type has no C equivalent,
+  // such method is not exported
+  bool isSupported = false;
+
+  // parameters without handle,
+  // example: `const char* name_data, size_t name_size, int id`
+  std::string paramDecls;
+
+  // arguments passed to interface,
+  // example: `::std::string_view(name_data, name_size), id`
+  std::string forwardedArgs;
+
+  PimplCApiResult result = PimplCApiResult::kVoid;
+
+  // C type of `kScalar` result, example: `unsigned long`
+  std::string resultType;
+};
+
+// function of C facade,
+// see `c_api` argument of `_injectPimplMethodCalls`
+struct PimplCApiFunction {
+  // example: `example_interface_Foo_baz`
+  std::string name;
+
+  // method of interface, empty for constructor
+  std::string methodName;
+
+  bool isConst = false;
+
+  PimplCApiSignature signature;
+};
+
+// explicit instantiation of forwarder of method template,
+// see `_pimplInstantiate`
+struct PimplMethodInstantiation {
+  // as written in annotation, example: `::std::string, 4`
+  std::string templateArgs;
+
+  // see `substituteTemplateParams`,
+  // example: `::std::enable_if_t<true, ::std::string>`
+  std::string returnType;
+
+  // example: `(const ::std::enable_if_t<true, ::std::string> &)`
+  std::string paramTypes;
+
+  // example: ` const noexcept`
+  std::string trailing;
+};
+
+// method of impl that is called for each object
+// by static batch forwarder (see `_pimplBatch`)
+struct PimplBatchMethod {
+  // example: `foo`
+  std::string name;
+
+  // example: `const int & arg2`
+  std::string paramDecls;
+
+  // example: `arg2`
+  std::string paramNames;
+
+  // type of element in output array,
+  // empty if method returns void
+  // example: `int`
+  std::string resultType;
+
+  // batch forwarder accepts span of const objects
+  bool isConst = false;
+};
+
 // input: vector<a, b, c>
 // output: "a, b, c"
 std::string expandTemplateNames(
@@ -54,6 +276,677 @@ std::string expandTemplateNames(
 std::string methodParamDecls(
   const std::vector<reflection::MethodParamInfo>& params);
 
+// generates code similar to:
+//  ::basis::FastPimpl<FooImpl, /*Size*/ 64, /*Alignment*/ 8, ...>
+std::string printInlinePimplStorageType(
+  const std::string& implType
+  , uint64_t typeSize
+  , unsigned typeAlignment);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::PoolPimpl<FooImpl>
+std::string printPoolPimplStorageType(
+  const std::string& implType);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::LazyPimpl<FooImpl, /*Size*/ 64, /*Alignment*/ 8>
+std::string printLazyPimplStorageType(
+  const std::string& implType
+  , uint64_t typeSize
+  , unsigned typeAlignment);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::VariantPimpl<
+//    /*Size*/ 64, /*Alignment*/ 8, FooImpl, FooFastImpl>
+std::string printVariantPimplStorageType(
+  const std::vector<std::string>& implTypes
+  , uint64_t typeSize
+  , unsigned typeAlignment);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::CpuDispatchPimpl<
+//    ::flex_pimpl_plugin::pimpl::CpuFeatureList<
+//      ::flex_pimpl_plugin::pimpl::kCpuBaseline
+//      , ::flex_pimpl_plugin::pimpl::kCpuAvx2>
+//    , /*Size*/ 64, /*Alignment*/ 8, FooImpl, FooAvx2Impl>
+/// \note |cpuFeatures| has expression for each impl type,
+/// see `printCpuFeatures`
+std::string printCpuDispatchPimplStorageType(
+  const std::vector<std::string>& implTypes
+  , const std::vector<std::string>& cpuFeatures
+  , uint64_t typeSize
+  , unsigned typeAlignment);
+
+// input: {`avx2`, `fma`}
+// output: `::flex_pimpl_plugin::pimpl::kCpuAvx2
+//   | ::flex_pimpl_plugin::pimpl::kCpuFma`
+/// \note empty input is `kCpuBaseline`
+std::string printCpuFeatures(
+  const std::vector<std::string>& isaNames);
+
+// generates code similar to:
+//  struct ImplDispatch;
+/// \note table is defined in .cc file of interface,
+/// see `printCpuDispatchTable`
+std::string printCpuDispatchDecl();
+
+// generates code similar to:
+//  struct Foo::ImplDispatch {
+//    static const ImplDispatch kTables[2];
+//    int (*foo)(const Foo& self, int arg1);
+//  };
+//  const Foo::ImplDispatch Foo::ImplDispatch::kTables[2] = {
+//    {
+//      [](const Foo& self, int arg1) -> int {
+//        return self.impl_.get<0>().foo(arg1);
+//      }
+//    }
+//    , { ... }
+//  };
+std::string printCpuDispatchTable(
+  const std::string& interfaceType
+  , size_t alternativesCount
+  , const std::vector<PimplDispatchEntry>& entries);
+
+// generates code similar to:
+//  return ImplDispatch::kTables[impl_.index()].foo(*this, arg1);
+/// \note forwarder calls impl without switch on stored alternative
+std::string printCpuDispatchCall(
+  const std::string& entryName
+  , const std::string& forwardedParams);
+
+// generates code similar to:
+//  public:
+//   struct ImplTable;
+//   static const ImplTable* builtinImplTable() noexcept;
+//   static bool swapImplTable(const ImplTable* table);
+/// \note see `hot_swap` argument of `_injectPimplMethodCalls`
+std::string printHotSwapDecls();
+
+// generates code similar to:
+//  struct Foo::ImplTable {
+//    static const ImplTable kBuiltin;
+//    static ::flex_pimpl_plugin::pimpl::HotSwapSlot<ImplTable> current;
+//    ::flex_pimpl_plugin::pimpl::ImplLayout layout;
+//    int (*foo)(const Foo& self, int arg1);
+//  };
+//  const Foo::ImplTable Foo::ImplTable::kBuiltin = {
+//    ::flex_pimpl_plugin::pimpl::ImplLayout{sizeof(FooImpl), ...}
+//    , [](const Foo& self, int arg1) -> int {
+//      return self.impl_->foo(arg1);
+//    }
+//  };
+//  ... definitions of `builtinImplTable` and `swapImplTable`
+/// \note |fieldsSignature| describes fields of impl,
+/// table of new build is rejected if its hash differs
+std::string printHotSwapTable(
+  const std::string& interfaceType
+  , const std::string& implType
+  , PimplStorageKind storageKind
+  , size_t alternativesCount
+  , const std::string& fieldsSignature
+  , const std::vector<PimplDispatchEntry>& entries);
+
+// generates code similar to:
+//  return ImplTable::current.get().foo(*this, arg1);
+std::string printHotSwapCall(
+  const std::string& entryName
+  , const std::string& forwardedParams);
+
+// generates code similar to:
+//  static const ::flex_pimpl_plugin::pimpl::MethodEntry*
+//    findMethod(::std::string_view name) noexcept;
+std::string printMethodTableDecl();
+
+// generates code similar to:
+//  const ::flex_pimpl_plugin::pimpl::MethodEntry*
+//    Foo::findMethod(::std::string_view name) noexcept
+//  {
+//    static constexpr ::std::array<
+//      ::flex_pimpl_plugin::pimpl::MethodEntry, 2> kMethods{{
+//      {"baz", [](void* object, void* const*, void* result) {
+//        ::new (result) ::std::string(
+//          static_cast<Foo*>(object)->baz());
+//      }, 0, false}
+//      , {}
+//    }};
+//    return ::flex_pimpl_plugin::pimpl::findMethodEntry(
+//      kMethods, /*seed*/ 1, name);
+//  }
+/// \note seed and size of table are selected so that
+/// every method has own slot (perfect hash),
+/// see ::flex_pimpl_plugin::pimpl::methodNameHash
+std::string printMethodTableDef(
+  const std::string& interfaceType
+  , const std::vector<PimplNamedMethod>& methods);
+
+// generates code similar to:
+//  size_t snapshotSize() const;
+//  size_t snapshot(char* out) const;
+//  size_t restore(const char* in, size_t size);
+//  static size_t snapshotSize(::base::span<const Foo> objects);
+//  static size_t snapshot(::base::span<const Foo> objects, char* out);
+//  static size_t restore(
+//    ::base::span<Foo> objects, const char* in, size_t size);
+/// \note see `snapshot` argument of `_injectPimplMethodCalls`
+std::string printSnapshotDecls(
+  const std::string& interfaceName);
+
+// generates code similar to:
+//  size_t Foo::snapshot(char* out) const {
+//    const auto& impl = (*impl_);
+//    char* pos = out;
+//    pos = ::flex_pimpl_plugin::pimpl::writeSnapshot(impl.data_, pos);
+//    return pos - out;
+//  }
+//  ...
+/// \note trivially copyable impl is copied via single `memcpy`,
+/// otherwise fields are written one by one
+/// (see ::flex_pimpl_plugin::pimpl::SnapshotTraits),
+/// so interface must be friend of impl.
+/// `restore` returns 0 if input is shorter than snapshot.
+/// |readLock| and |writeLock| are placed before access to impl
+/// (see `printForwarderLock`), |memoInvalidation| is placed
+/// before `restore` modifies impl
+std::string printSnapshotDefs(
+  PimplStorageKind storageKind
+  , const std::string& interfaceType
+  , const std::string& implType
+  , const std::vector<PimplFieldInfo>& fields
+  , bool isTriviallyCopyable
+  , const std::string& readLock
+  , const std::string& writeLock
+  , const std::string& memoInvalidation);
+
+// input: `::example_interface::Foo`
+// output: `example_interface_Foo`
+/// \note used as name of opaque handle and as prefix
+/// of functions of C facade
+std::string printCApiPrefix(
+  const std::string& interfaceType);
+
+// generates C header similar to:
+//  typedef struct example_interface_Foo example_interface_Foo;
+//  example_interface_Foo* example_interface_Foo_create(void);
+//  void example_interface_Foo_destroy(example_interface_Foo* self);
+//  flex_pimpl_string_view example_interface_Foo_baz(
+//    const example_interface_Foo* self);
+/// \note see <flex_pimpl_plugin/pimpl/CApi.h>
+std::string printCApiHeader(
+  const std::string& interfaceType
+  , const std::vector<PimplCApiFunction>& functions);
+
+// generates code similar to:
+//  } // namespace example_interface
+//  #include "example_interface_Foo_c_api.h"
+//  extern "C" {
+//  example_interface_Foo* example_interface_Foo_create(void) noexcept {
+//    return reinterpret_cast<example_interface_Foo*>(
+//      new ::example_interface::Foo());
+//  }
+//  flex_pimpl_string_view example_interface_Foo_baz(
+//    const example_interface_Foo* self) noexcept {
+//    const auto& result
+//      = reinterpret_cast<const ::example_interface::Foo*>(self)->baz();
+//    return flex_pimpl_string_view{result.data(), result.size()};
+//  }
+//  } // extern "C"
+//  namespace example_interface {
+/// \note |enclosingNamespaces| (outermost first, empty name
+/// for anonymous namespace) are closed and reopened,
+/// so C header declares opaque struct in global namespace.
+/// Functions are `noexcept`: exception that escapes impl method
+/// terminates program instead of unwinding through C caller.
+std::string printCApiDefs(
+  const std::string& interfaceType
+  , const std::vector<std::string>& enclosingNamespaces
+  , const std::vector<PimplCApiFunction>& functions);
+
+// generates code similar to:
+//  switch(impl_.index()) {
+//    case 0: return impl_.get<0>().foo(arg1);
+//    default: return impl_.get<1>().foo(arg1);
+//  }
+/// \note |methodCall| is call expression without object,
+/// example: `foo(arg1)`
+/// |implMember| is expression that refers to storage,
+/// example: `impl_` or `self.impl_`
+std::string printVariantMethodCall(
+  size_t alternativesCount
+  , const std::string& implMember
+  , const std::string& methodCall);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::CowPimpl<FooImpl>
+std::string printCowPimplStorageType(
+  const std::string& implType);
+
+// generates code similar to:
+//  ::flex_pimpl_plugin::RcuPimpl<FooImpl>
+std::string printRcuPimplStorageType(
+  const std::string& implType);
+
+// input: ::basis::FastPimpl<FooImpl, ...>
+// output: "::basis::FastPimpl<FooImpl, ...> impl_;"
+std::string printStorageMember(
+  const std::string& storageType);
+
+// generates explicit instantiations of special members of storage
+// (or declarations of them if |isExternDecl|) similar to:
+//  template ::flex_pimpl_plugin::PoolPimpl<::FooImpl>::PoolPimpl(
+//    ::flex_pimpl_plugin::PoolPimpl<::FooImpl>&&);
+//  template ::flex_pimpl_plugin::PoolPimpl<::FooImpl>&
+//    ::flex_pimpl_plugin::PoolPimpl<::FooImpl>::operator=(
+//      ::flex_pimpl_plugin::PoolPimpl<::FooImpl>&&);
+//  template ::flex_pimpl_plugin::PoolPimpl<::FooImpl>::~PoolPimpl();
+/// \note unlike `template class`, copy operations are instantiated
+/// only if |isCopyable|, so storage of move-only impl is supported
+/// \note constructors of inline storage are not instantiated,
+/// because they are ambiguous with its forwarding constructor;
+/// members of `CpuDispatchPimpl` are defaulted, so members
+/// of its base `VariantPimpl` are instantiated instead
+/// \note definitions must be placed where impl is complete type
+std::string printStorageMemberInstantiations(
+  PimplStorageKind kind
+  , const std::string& storageType
+  , bool isCpuDispatch
+  , bool isCopyable
+  , bool isExternDecl);
+
+// replaces names of template parameters in |type|,
+// type arguments are wrapped into `::std::enable_if_t<true, ...>`,
+// so `const T &` with `T = int*` means `int* const &`
+// input: `const T &`, {`T`}, {`int*`}, {true}
+// output: `const ::std::enable_if_t<true, int*> &`
+/// \note |isTypeParam| is false for non-type parameters,
+/// their arguments are placed in parentheses
+std::string substituteTemplateParams(
+  const std::string& type
+  , const std::vector<std::string>& paramNames
+  , const std::vector<std::string>& args
+  , const std::vector<bool>& isTypeParam);
+
+// generates code similar to:
+//  template ::size_t example_interface::Foo::describe<int>(
+//    const ::std::enable_if_t<true, int> &) const;
+/// \note |isExternDecl| generates `extern template` declaration
+/// that must be placed after interface,
+/// explicit instantiation must be placed after forwarder definition
+std::string printMethodInstantiation(
+  const std::string& interfaceType
+  , const std::string& methodName
+  , const PimplMethodInstantiation& instantiation
+  , bool isExternDecl);
+
+// generates code similar to:
+//  static_assert(sizeof(::FooImpl) <= 64, "...");
+//  static_assert(8 % alignof(::FooImpl) == 0, "...");
+/// \note does nothing for storage that allocates impl on heap
+std::string printStorageLayoutAsserts(
+  PimplStorageKind storageKind
+  , const std::vector<std::string>& implTypes
+  , uint64_t typeSize
+  , unsigned typeAlignment);
+
+// generates body of forwarder similar to:
+//  return impl_->foo(arg1);
+/// \note |alternativesCount| is number of impls except first one
+/// (used by `storage = variant`)
+/// |object| is prefix of storage, example: `self.`
+std::string printForwarderBody(
+  PimplStorageKind storageKind
+  , bool isConstMethod
+  , size_t alternativesCount
+  , const std::string& object
+  , const std::string& methodCall);
+
+// returns expression used by forwarders to access impl,
+// example: `impl_->`
+/// \note |isConstMethod| matters for copy-on-write storage:
+/// non-const methods must detach shared impl before modification
+std::string printImplAccess(
+  PimplStorageKind storageKind
+  , bool isConstMethod);
+
+// input: clang::AS_private
+// output: "private:"
+std::string printAccessSpecifier(
+  clang::AccessSpecifier access);
+
+// returns true if |decl| has annotation attribute
+// that starts with |annotation|
+bool hasAnnotation(
+  const clang::Decl* decl
+  , const std::string& annotation);
+
+// returns true if object of type |type| can be moved
+// to new address via memcpy (without calling move constructor
+// and destructor).
+/// \note uses conservative rules: trivially copyable types,
+/// smart pointers, std::vector and classes without user-provided
+/// copy or move constructors composed of such types.
+/// Classes annotated with `pimpl_trivially_relocatable`
+/// are always treated as trivially relocatable.
+bool isTriviallyRelocatableType(
+  clang::QualType type
+  , clang::ASTContext& context);
+
+// returns true if all bases and fields of |record|
+// can be relocated via memcpy
+/// \note ignores constructors of |record|,
+/// used to check interface that stores impl
+bool areMembersTriviallyRelocatable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context);
+
+// returns true if move constructor and move assignment
+// of |type| can not throw.
+/// \note uses conservative rules: declared exception specification,
+/// defaulted and implicit members are checked recursively
+/// (bases and fields), types with reference or const fields
+/// are not movable
+bool isNothrowMovableType(
+  clang::QualType type
+  , clang::ASTContext& context);
+
+// maps parameters and result of |function| to C types,
+// see `c_api` argument of `_injectPimplMethodCalls`
+/// \note supports arithmetic types, enums,
+/// `::std::string`, `::std::string_view` and `::base::span`
+/// of arithmetic types. Non-const lvalue reference
+/// to arithmetic type becomes pointer (output parameter).
+PimplCApiSignature reflectCApiSignature(
+  const clang::FunctionDecl* function
+  , const clang::ASTContext& context);
+
+// returns true if all bases and fields of |record|
+// can be moved without exceptions
+/// \note used to check interface that stores impl
+bool areMembersNothrowMovable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context);
+
+// returns true if value of |type| may refer to memory owned
+// by other object: reference, pointer, `::std::string_view`,
+// `::std::span`, `::base::span` or `::base::StringPiece`
+bool isViewType(
+  clang::QualType type);
+
+// returns true if |type| stores pointer (or reference) directly,
+// in array, in field of trivially copyable class (copied via memcpy)
+// or in template type argument (example: `::std::vector<int*>`)
+/// \note used by `snapshot`, address is not valid
+/// after snapshot is restored in other process
+bool hasPointerMembers(
+  clang::QualType type
+  , clang::ASTContext& context);
+
+// returns true if copy constructor and copy assignment
+// of |type| are not deleted
+bool isCopyableType(
+  clang::QualType type
+  , clang::ASTContext& context);
+
+bool areMembersCopyable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context);
+
+// generates code similar to:
+//  Foo(const Foo& other);
+//  Foo& operator=(const Foo& other);
+//  Foo(Foo&& other) noexcept;
+//  Foo& operator=(Foo&& other) noexcept;
+//  void swap(Foo& other) noexcept;
+//  friend void swap(Foo& lhs, Foo& rhs) noexcept { lhs.swap(rhs); }
+/// \note copy operations are declared only if |isCopyable|
+std::string printSpecialMemberDecls(
+  const std::string& interfaceName
+  , bool isNothrowMovable
+  , bool isCopyable);
+
+// generates code similar to:
+//  Foo::Foo(Foo&& other) noexcept = default;
+//  Foo& Foo::operator=(Foo&& other) noexcept = default;
+//  void Foo::swap(Foo& other) noexcept { ... }
+//  static_assert(::std::is_nothrow_move_constructible_v<Foo>, "...");
+/// \note definitions must be placed where impl is complete type
+/// \note with |locking| copy and move constructors copy or move impl
+/// while mutex of |other| is locked (see `copyLocked`),
+/// assignments and swap lock both mutexes via `::std::scoped_lock`
+/// and clear caches (|memoInvalidation| of this object,
+/// |otherMemoInvalidation| of |other|, see `printMemoCacheInvalidation`)
+std::string printSpecialMemberDefs(
+  const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::string& storageType
+  , bool isNothrowMovable
+  , bool isCopyable
+  , PimplLocking locking
+  , const std::string& memoInvalidation
+  , const std::string& otherMemoInvalidation);
+
+// returns argument expression used by forwarder to pass |param|:
+//  by-value and rvalue reference parameters: `::std::move(arg)`
+//  forwarding references: `::std::forward<T>(arg)`
+//  other parameters: `arg`
+/// \note parameter packs are expanded, example: `::std::move(args)...`
+std::string printForwardedParam(
+  const clang::ParmVarDecl* param
+  , const clang::FunctionTemplateDecl* functionTemplate);
+
+// returns return type, name, parameter types and qualifiers of method,
+// used to find same method in different impls
+// example: `int foo(int &&, const int &) const`
+std::string printMethodSignature(
+  const clang::FunctionDecl* decl);
+
+// returns true if impl can be constructed with pmr allocator:
+//  using allocator_type = std::pmr::polymorphic_allocator<...>;
+//  explicit FooImpl(const allocator_type& alloc);
+//  allocator_type get_allocator() const;
+bool isPmrAllocatorAwareType(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context);
+
+// generates code similar to:
+//  using allocator_type = ::std::pmr::polymorphic_allocator<::std::byte>;
+//  explicit Foo(::std::pmr::memory_resource* resource);
+//  Foo(::std::allocator_arg_t, const allocator_type& alloc);
+//  Foo(::std::allocator_arg_t, const allocator_type& alloc,
+//    const Foo& other);
+//  Foo(::std::allocator_arg_t, const allocator_type& alloc,
+//    Foo&& other);
+//  allocator_type get_allocator() const noexcept;
+/// \note allocator-extended copy constructor
+/// is declared only if |isCopyable|
+std::string printPmrInterfaceDecls(
+  const std::string& interfaceName
+  , bool isCopyable);
+
+// generates definitions of code from |printPmrInterfaceDecls|,
+// impl is constructed with allocator of interface
+/// \note allocator-extended copy and move constructors
+/// construct impl with allocator and assign impl of |other|,
+/// so containers of impl keep allocator of new object
+/// (`propagate_on_container_*_assignment` is false for pmr)
+/// \note |interfaceType| is qualified name, example: `::Foo`
+/// |interfaceName| is name of constructor, example: `Foo`
+/// \note impl of |other| is read under its mutex if |locking| is set
+std::string printPmrInterfaceDefs(
+  const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::string& implAccess
+  , bool isCopyable
+  , PimplLocking locking);
+
+// returns fully qualified type,
+// example: `::std::vector<::example::Bar>`
+std::string printFullyQualifiedType(
+  clang::QualType type
+  , const clang::ASTContext& context);
+
+// public constructor of impl, interface gets constructor
+// and `emplace` with same parameters
+struct PimplConstructorInfo {
+  // fully qualified parameter types,
+  // example: `int id, const ::std::string & name`
+  std::string paramDecls;
+
+  // see `printForwardedParam`, example: `id, name`
+  std::string forwardedParams;
+
+  // canonical parameter types, used to find constructor
+  // that is already declared by interface
+  // example: `(int, const std::string &)`
+  std::string paramTypes;
+
+  bool isExplicit = false;
+
+  // see `c_api` argument of `_injectPimplMethodCalls`
+  PimplCApiSignature cApi;
+};
+
+// generates code similar to:
+//  explicit Foo(int id, const ::std::string & name);
+//  void emplace(int id, const ::std::string & name);
+std::string printForwardingConstructorDecls(
+  const std::string& interfaceName
+  , const std::vector<PimplConstructorInfo>& constructors);
+
+// generates code similar to:
+//  Foo::Foo(int id, const ::std::string & name)
+//    : impl_(id, name)
+//  {}
+//  void Foo::emplace(int id, const ::std::string & name) {
+//    ::flex_pimpl_plugin::pimpl::reconstruct(*impl_, id, name);
+//  }
+/// \note impl is constructed in place, without default construction
+/// followed by assignment. `emplace` reuses storage of impl
+/// (see ::flex_pimpl_plugin::pimpl::reconstruct),
+/// variant storage switches to first alternative.
+/// \note |lock| is placed before |memoInvalidation|,
+/// see `printForwarderLock`
+/// \note |memoInvalidation| is placed before re-initialization of impl,
+/// see `printMemoCacheInvalidation`
+/// |isCpuDispatch| means that variant storage
+/// selects alternative itself, see `printCpuDispatchPimplStorageType`
+std::string printForwardingConstructorDefs(
+  PimplStorageKind kind
+  , const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::vector<PimplConstructorInfo>& constructors
+  , const std::string& lock
+  , const std::string& memoInvalidation
+  , bool isCpuDispatch);
+
+// generates code similar to:
+//  mutable ::flex_pimpl_plugin::pimpl::ForwardingMutex<::std::mutex>
+//    implMutex_;
+std::string printForwardingMutexMember(
+  PimplLocking locking);
+
+// generates code similar to:
+//  ::std::lock_guard implLock(implMutex_);
+// or (for |isReadOnly| forwarder with `locking = shared`):
+//  ::std::shared_lock implLock(implMutex_);
+/// \note |object| is prefix of mutex, example: `self.`
+/// \note forwarder is read-only if it does not modify
+/// interface or impl (memoized const forwarder modifies cache)
+std::string printForwarderLock(
+  PimplLocking locking
+  , bool isReadOnly
+  , const std::string& object);
+
+// generates code similar to:
+//  mutable ::flex_pimpl_plugin::pimpl::MemoCache<
+//    ::std::tuple<int>, ::std::string, 8> bazMemo_;
+std::string printMemoCacheMember(
+  const PimplMemoCache& cache);
+
+// generates code similar to:
+//  bazMemo_.clear();
+/// \note used by non-const forwarders, because impl may change
+/// |object| is prefix of caches, example: `self.`
+std::string printMemoCacheInvalidation(
+  const std::vector<PimplMemoCache>& caches
+  , const std::string& object);
+
+// generates body of memoized forwarder similar to:
+//  const auto memoKey = ::std::forward_as_tuple(arg);
+//  if(const auto* cached = bazMemo_.find(memoKey)) {
+//    return *cached;
+//  }
+//  return bazMemo_.insert(memoKey, [&]() {
+//    return impl_->baz(arg);
+//  }());
+/// \note |forwarderBody| is result of `printForwarderBody`
+std::string printMemoizedForwarderBody(
+  const std::string& cacheName
+  , const std::string& object
+  , const std::string& paramNames
+  , const std::string& forwarderBody);
+
+// returns `foo_async` for method `foo`
+std::string printAsyncForwarderName(
+  const std::string& methodName);
+
+// generates declaration of async forwarder similar to:
+//  ::std::future<int> foo_async(int arg) const;
+/// \note |resultType| is empty if method returns void
+std::string printAsyncForwarderDecl(
+  const std::string& methodName
+  , const std::string& paramDecls
+  , const std::string& resultType
+  , bool isConstMethod);
+
+// generates definition of async forwarder similar to:
+//  ::std::future<int> Foo::foo_async(int arg) const {
+//    return ::std::async(::std::launch::async,
+//      [this, arg = ::std::move(arg)]() mutable { return foo(arg); });
+//  }
+/// \note calls synchronous forwarder, so locking policy is respected.
+/// Caller must keep interface alive until future is ready.
+std::string printAsyncForwarderDef(
+  const std::string& interfaceType
+  , const std::string& methodName
+  , const std::string& paramDecls
+  , const std::vector<std::string>& paramNames
+  , const std::string& forwardedParams
+  , const std::string& resultType
+  , bool isConstMethod);
+
+// returns `[[gnu::hot]] ` or `[[gnu::cold]] [[gnu::noinline]] `,
+// empty string if |hotness| is unknown
+std::string printHotnessAttributes(
+  PimplMethodHotness hotness);
+
+// returns `foo_batch` for method `foo`
+std::string printBatchForwarderName(
+  const std::string& methodName);
+
+// generates declaration of static batch forwarder similar to:
+//  static void foo_batch(
+//    ::base::span<const Foo> objects, int arg, int* out);
+/// \note |out| is added only if method returns value,
+/// it must point to array of |objects.size()| elements
+std::string printBatchForwarderDecl(
+  const std::string& interfaceName
+  , const PimplBatchMethod& method);
+
+// generates definition of static batch forwarder similar to:
+//  void Foo::foo_batch(
+//    ::base::span<const Foo> objects, int arg, int* out) {
+//    for(size_t i = 0; i < objects.size(); i++) {
+//      out[i] = objects[i].foo(arg);
+//    }
+//  }
+/// \note loop calls forwarders defined in same translation unit,
+/// so compiler is able to inline them (and impl methods
+/// if they are visible)
+std::string printBatchForwarderDef(
+  const std::string& interfaceType
+  , const PimplBatchMethod& method);
+
 // used to prohibit Ctor/Dtor/etc. generation in typeclass
 // based on provided interface
 bool isPimplMethod(
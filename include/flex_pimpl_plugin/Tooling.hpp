@@ -15,12 +15,18 @@
 #include <base/sequenced_task_runner.h>
 #include <base/files/file_path.h>
 
+#include <set>
+
 namespace flex_pimpl_plugin {
 
 // Declaration must match plugin version.
 struct Settings {
   // output directory for generated files
   std::string outDir;
+
+  // profile summary, each line is `<impl method> <sample count>`
+  // example: `example_impl::FooImpl::baz 1234`
+  std::string profileFile;
 };
 
 } // namespace flex_pimpl_plugin
@@ -39,6 +45,209 @@ struct ReflectForPimplSettings {
   std::string interfaceParameterQualType;
 
   clang::QualType interfaceArgQualType;
+
+  // other impls that can be stored by interface
+  // (`impl_1`, `impl_2`, etc.), used by `storage = variant`
+  // example: namespace::FooFastImpl
+  std::vector<std::string> alternativeParameterQualTypes;
+
+  std::vector<clang::QualType> alternativeArgQualTypes;
+};
+
+// storage settings of interface,
+// populated by `injectPimplStorage`
+// and used by `injectPimplMethodCalls`
+struct PimplStorageSettings {
+  PimplStorageKind kind = PimplStorageKind::kInline;
+
+  // impl types except first one, used by `storage = variant`
+  std::vector<std::string> alternatives;
+
+  // required ISA extensions of impl and each alternative
+  // (`isa_1`, `isa_2`, etc.), empty if alternatives are not
+  // selected by host CPU, see `printCpuFeatures`
+  std::vector<std::string> cpuFeatures;
+
+  // `allocator = pmr`: interface can be constructed
+  // with std::pmr::memory_resource that is passed to impl
+  bool isPmrAllocatorAware = false;
+
+  // name of class that stores impl, example: `Foo`
+  std::string interfaceName;
+
+  // type of `impl_` member,
+  // example: `::basis::FastPimpl<::FooImpl, 64, 8, ...>`
+  std::string storageType;
+
+  // fully qualified impl and alternatives,
+  // example: `::example_impl::FooImpl`
+  std::vector<std::string> implTypes;
+
+  // size and alignment of inline storage
+  // (not used by pool and copy-on-write storage)
+  uint64_t typeSize = 0;
+
+  unsigned typeAlignment = 0;
+
+  // copy, move and swap of interface are generated
+  // (interface does not declare them manually)
+  bool hasSpecialMembers = false;
+
+  // generated move operations and swap are `noexcept`
+  bool isNothrowMovable = false;
+
+  // generated copy operations, see `isCopyableType`
+  bool isCopyable = false;
+
+  // impl (and every alternative) is copyable,
+  // so copy operations of storage are explicitly instantiated
+  // (see `injectPimplExternTemplates`)
+  bool isImplCopyable = false;
+};
+
+// parsed from `_pimplPolicy` annotation of impl method
+/// \note methods without annotation use default policy
+struct PimplMethodPolicy {
+  // `forwarding = inline` or `forwarding = out_of_line`
+  PimplForwarding forwarding = PimplForwarding::kDefault;
+
+  // `section = hot` or `section = cold`,
+  // overrides hotness from profile
+  PimplMethodHotness section = PimplMethodHotness::kUnknown;
+
+  // `memoize`: const method is pure function of arguments and impl
+  bool isMemoized = false;
+
+  // `memoize = 16`: max. number of cached results per object
+  size_t memoCapacity = 0;
+
+  // `batch`: same as `_pimplBatch()`
+  bool isBatched = false;
+
+  // `locking = exclusive` or `locking = shared`,
+  // default is `locking` argument of `_reflectForPimpl`
+  PimplLocking locking = PimplLocking::kNone;
+
+  // `async`: interface gets `foo_async` returning ::std::future
+  bool isAsync = false;
+};
+
+// data computed from AST of impl method during `reflectForPimpl`
+struct PimplMethodTraits {
+  // example: `int foo(int &&, const int &) const`
+  std::string signature;
+
+  bool isConst = false;
+
+  // result may refer to impl (see `isViewType`),
+  // so it can not outlive read or write section of `storage = rcu`
+  bool returnsView = false;
+
+  // method can be called for each object by batch forwarder
+  // (non-static, not template, without rvalue reference parameters)
+  bool isBatchable = false;
+
+  // see `_pimplPolicy`
+  PimplMethodPolicy policy;
+
+  // see `Settings::profileFile` and `section` of `_pimplPolicy`
+  PimplMethodHotness hotness = PimplMethodHotness::kUnknown;
+
+  // method annotated with `_pimplBatch()`,
+  // interface gets static forwarder `foo_batch`
+  bool hasBatchForwarder = false;
+
+  // example: `arg1, arg2`
+  std::string paramNames;
+
+  // example: {`arg1`, `arg2`}
+  std::vector<std::string> paramNameList;
+
+  // arguments passed by forwarder to impl,
+  // see `printForwardedParam`
+  // example: `::std::move(arg1), arg2`
+  std::string forwardedParams;
+
+  // result cache of method with `memoize` policy,
+  // see `PimplImplTraits::memoCaches`
+  PimplMemoCache memoCache;
+
+  // fully qualified, example: `const ::std::string`
+  std::string returnType;
+
+  // arguments extracted from `void* const* args`
+  // by invoker of `by_name` table, see `PimplNamedMethod`
+  std::string invokerArgs;
+
+  // function of extern "C" facade, see `c_api` argument
+  // of `_injectPimplMethodCalls`
+  PimplCApiSignature cApi;
+
+  // template arguments from `_pimplInstantiate` annotations,
+  // forwarder of method template is explicitly instantiated
+  // for each of them
+  std::vector<PimplMethodInstantiation> instantiations;
+
+  // type of element in output array of batch method,
+  // empty if method returns void
+  // example: `::std::string`
+  std::string batchResultType;
+};
+
+// data computed from AST of impl during `reflectForPimpl`
+/// \note AST of impl may be not available
+/// when annotations from other files are processed
+struct PimplImplTraits {
+  // impl can be moved to new address via memcpy,
+  // see ::flex_pimpl_plugin::pimpl::IsTriviallyRelocatable
+  bool isTriviallyRelocatable = false;
+
+  // impl can be constructed with std::pmr::polymorphic_allocator,
+  // see `isPmrAllocatorAwareType`
+  bool isPmrAllocatorAware = false;
+
+  // non-static fields in declaration order
+  std::vector<PimplFieldInfo> fields;
+
+  // fields can be assigned one by one by `restore` of snapshot
+  // (no references, const fields or bit-fields)
+  bool areFieldsAssignable = false;
+
+  // some field stores address that is not valid
+  // after snapshot is restored, see `hasPointerMembers`
+  bool hasPointerFields = false;
+
+  bool isDefaultConstructible = false;
+
+  // see `isNothrowMovableType`
+  bool isNothrowMovable = false;
+
+  // see `isCopyableType`
+  bool isCopyable = false;
+
+  // impl can be saved via single `memcpy`,
+  // see `snapshot` argument of `_injectPimplMethodCalls`
+  bool isTriviallyCopyable = false;
+
+  // fields of bases are not listed in |fields|
+  bool hasBases = false;
+
+  // strongest locking policy of methods,
+  // interface stores mutex if it is not `kNone`
+  PimplLocking locking = PimplLocking::kNone;
+
+  // caches of methods with `memoize` policy in declaration order,
+  // cleared by forwarders of non-const methods
+  std::vector<PimplMemoCache> memoCaches;
+
+  // public constructors with parameters (except copy and move)
+  std::vector<PimplConstructorInfo> constructors;
+
+  // key is method from reflection cache
+  std::map<
+    const reflection::MethodInfo*
+    , PimplMethodTraits
+  > methods;
 };
 
 /// \note class name must not collide with
@@ -62,6 +271,10 @@ public:
     injectPimplMethodCalls(
       const clang_utils::SourceTransformOptions& sourceTransformOptions);
 
+  clang_utils::SourceTransformResult
+    injectPimplExternTemplates(
+      const clang_utils::SourceTransformOptions& sourceTransformOptions);
+
   clang_utils::SourceTransformResult
     reflectForPimpl(
       const clang_utils::SourceTransformOptions& sourceTransformOptions);
@@ -78,6 +291,35 @@ private:
     reflectFromCache(
       ReflectForPimplSettings& reflectForPimplSettings);
 
+  reflection::ClassInfoPtr
+    reflectFromCache(
+      const std::string& implParameterQualType);
+
+  const PimplImplTraits&
+    getImplTraits(
+      const ReflectForPimplSettings& reflectForPimplSettings);
+
+  const PimplImplTraits&
+    getImplTraits(
+      const std::string& implParameterQualType);
+
+  // returns `kUnknown` if profile is not loaded
+  PimplMethodHotness getMethodHotness(
+    const std::string& implParameterQualType
+    , const std::string& methodName) const;
+
+  // true if profile has samples of at least one method of impl,
+  // methods of other classes are not classified by profile
+  bool isProfiledClass(
+    const std::string& implParameterQualType) const;
+
+  // returns false if one of |alternatives|
+  // does not have method with same signature
+  bool isImplementedByAlternatives(
+    const reflection::MethodInfo* method
+    , const PimplImplTraits& implTraits
+    , const std::vector<std::string>& alternatives);
+
 private:
   ::clang_utils::SourceTransformRules* sourceTransformRules_;
 
@@ -96,11 +338,43 @@ private:
 
   flex_pimpl_plugin::Settings settings_{};
 
+  // loaded from `Settings::profileFile`,
+  // key is impl method, example: example_impl::FooImpl::baz
+  std::map<
+    std::string
+    , uint64_t
+  > profileSamples_{};
+
+  uint64_t profileTotalSamples_ = 0;
+
+  // impl classes listed in profile, example: example_impl::FooImpl
+  std::set<std::string> profiledClasses_{};
+
   std::map<
     std::string
     , reflection::ClassInfoPtr
   > reflectionCache_{};
 
+  // key is impl type, example: namespace::FooImpl
+  std::map<
+    std::string
+    , PimplStorageSettings
+  > storageCache_{};
+
+  // key is impl type, example: namespace::FooImpl
+  std::map<
+    std::string
+    , PimplImplTraits
+  > implTraitsCache_{};
+
+  // constructors generated in header of interface
+  // (constructors declared manually are skipped),
+  // key is impl type, example: namespace::FooImpl
+  std::map<
+    std::string
+    , std::vector<PimplConstructorInfo>
+  > constructorsCache_{};
+
   DISALLOW_COPY_AND_ASSIGN(pimplTooling);
 };
 
@@ -0,0 +1,60 @@
+#pragma once
+
+/// \note C header, included by facades generated
+/// for `c_api` argument of `_injectPimplMethodCalls`
+
+#include <stddef.h>
+
+// Functions of facade do not throw (exception that escapes
+// impl method terminates program), so C++ callers
+// and definitions see them as `noexcept`.
+#ifdef __cplusplus
+#define FLEX_PIMPL_C_NOEXCEPT noexcept
+#else
+#define FLEX_PIMPL_C_NOEXCEPT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// String owned by object of interface (not copied),
+// valid until next non-const call or destruction of object.
+typedef struct flex_pimpl_string_view {
+  const char* data;
+  size_t size;
+} flex_pimpl_string_view;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Copies up to |capacity| bytes of |value| into buffer of caller.
+// Returns size of |value|, so caller can retry with larger buffer.
+inline size_t copyToBuffer(
+  std::string_view value
+  , char* out
+  , size_t capacity) noexcept
+{
+  const size_t count = std::min(value.size(), capacity);
+  if(count) {
+    std::memcpy(out, value.data(), count);
+  }
+  return value.size();
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
+
+#endif // __cplusplus
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <base/compiler_specific.h>
+#include <base/logging.h>
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+// Storage used by PImpl.
+// Copies of interface share same reference-counted impl,
+// impl is cloned only before first modification of shared impl
+// (copy-on-write).
+// Generated forwarders call |read()| from const methods
+// and |write()| from non-const methods.
+//
+/// \note |T| may be incomplete type at the point of declaration,
+/// but must be complete in the place where constructors
+/// and destructor of the interface are defined (usually .cc file).
+/// \note reference counter is atomic, so copies can be used
+/// from different threads. Same object must not be modified
+/// concurrently, same as any other non-const access to impl.
+template <typename T>
+class CowPimpl {
+public:
+  // storage is single pointer, so it can be relocated via memcpy
+  // regardless of |T|, see ::flex_pimpl_plugin::pimpl::IsTriviallyRelocatable
+  using IsRelocatable = std::true_type;
+
+  template <
+    typename... Args
+    , typename = std::enable_if_t<
+        !(sizeof...(Args) == 1
+          && (std::is_same_v<std::decay_t<Args>, CowPimpl> || ...))>
+  >
+  explicit CowPimpl(Args&&... args)
+    : shared_(new Shared(std::forward<Args>(args)...))
+  {}
+
+  // shares impl, does not copy it
+  CowPimpl(const CowPimpl& other) noexcept
+    : shared_(other.shared_)
+  {
+    DCHECK(shared_) << "copy of moved-from pimpl";
+    shared_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  CowPimpl(CowPimpl&& other) noexcept
+    : shared_(other.shared_)
+  {
+    other.shared_ = nullptr;
+  }
+
+  CowPimpl& operator=(const CowPimpl& other) noexcept
+  {
+    CowPimpl tmp(other);
+    swap(tmp);
+    return *this;
+  }
+
+  CowPimpl& operator=(CowPimpl&& other) noexcept
+  {
+    CowPimpl tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  ~CowPimpl()
+  {
+    release();
+  }
+
+  void swap(CowPimpl& other) noexcept
+  {
+    std::swap(shared_, other.shared_);
+  }
+
+  // used by const methods of interface, never copies impl
+  const T& read() const noexcept
+  {
+    DCHECK(shared_) << "use of moved-from pimpl";
+    return shared_->value;
+  }
+
+  // used by non-const methods of interface,
+  // clones impl if it is shared with other copies
+  T& write()
+  {
+    DCHECK(shared_) << "use of moved-from pimpl";
+    if(shared_->refs.load(std::memory_order_acquire) != 1) {
+      detach();
+    }
+    return shared_->value;
+  }
+
+  // Replaces impl with new object, other copies keep old impl.
+  /// \note shared impl is not cloned before replacement
+  template <typename... Args>
+  void emplace(Args&&... args)
+  {
+    Shared* replacement = new Shared(std::forward<Args>(args)...);
+    release();
+    shared_ = replacement;
+  }
+
+  const T* operator->() const noexcept { return &read(); }
+
+  const T& operator*() const noexcept { return read(); }
+
+  // number of interface objects that share impl
+  size_t useCount() const noexcept
+  {
+    return shared_
+      ? shared_->refs.load(std::memory_order_acquire)
+      : 0;
+  }
+
+  bool isShared() const noexcept
+  {
+    return useCount() > 1;
+  }
+
+private:
+  struct Shared {
+    template <typename... Args>
+    explicit Shared(Args&&... args)
+      : value(std::forward<Args>(args)...)
+    {}
+
+    std::atomic<size_t> refs{1};
+
+    T value;
+  };
+
+  // copies impl shared with other objects
+  NOINLINE void detach()
+  {
+    Shared* copy = new Shared(static_cast<const T&>(shared_->value));
+    release();
+    shared_ = copy;
+  }
+
+  void release() noexcept
+  {
+    if(shared_
+       && shared_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete shared_;
+    }
+    shared_ = nullptr;
+  }
+
+private:
+  Shared* shared_ = nullptr;
+};
+
+} // namespace flex_pimpl_plugin
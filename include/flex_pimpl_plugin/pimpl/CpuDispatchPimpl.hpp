@@ -0,0 +1,162 @@
+#pragma once
+
+#include <flex_pimpl_plugin/pimpl/VariantPimpl.hpp>
+
+#include <base/cpu.h>
+#include <base/logging.h>
+
+#include <build/build_config.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// ISA extensions required by alternative impl,
+// see `isa_1`, `isa_2`, etc. of `storage = variant`
+enum CpuFeature : uint32_t {
+  // alternative runs on any host
+  kCpuBaseline = 0
+  , kCpuSse3 = 1u << 0
+  , kCpuSsse3 = 1u << 1
+  , kCpuSse41 = 1u << 2
+  , kCpuSse42 = 1u << 3
+  , kCpuPopcnt = 1u << 4
+  , kCpuAvx = 1u << 5
+  , kCpuAvx2 = 1u << 6
+  , kCpuAesni = 1u << 7
+  , kCpuAvx512f = 1u << 8
+};
+
+// required features of each alternative, in order of alternatives
+template <uint32_t... Features>
+struct CpuFeatureList {};
+
+// Features supported by host (and enabled by OS),
+// detected once per process.
+inline uint32_t hostCpuFeatures()
+{
+  static const uint32_t features = []() {
+    const base::CPU cpu;
+    uint32_t result = kCpuBaseline;
+    result |= cpu.has_sse3() ? static_cast<uint32_t>(kCpuSse3) : 0u;
+    result |= cpu.has_ssse3() ? static_cast<uint32_t>(kCpuSsse3) : 0u;
+    result |= cpu.has_sse41() ? static_cast<uint32_t>(kCpuSse41) : 0u;
+    result |= cpu.has_sse42() ? static_cast<uint32_t>(kCpuSse42) : 0u;
+    result |= cpu.has_popcnt() ? static_cast<uint32_t>(kCpuPopcnt) : 0u;
+    result |= cpu.has_avx() ? static_cast<uint32_t>(kCpuAvx) : 0u;
+    result |= cpu.has_avx2() ? static_cast<uint32_t>(kCpuAvx2) : 0u;
+    result |= cpu.has_aesni() ? static_cast<uint32_t>(kCpuAesni) : 0u;
+#if defined(ARCH_CPU_X86_FAMILY) && defined(COMPILER_GCC)
+    // base::CPU does not report AVX-512,
+    // builtin also checks that OS saves state of ZMM registers
+    result |= __builtin_cpu_supports("avx512f")
+      ? static_cast<uint32_t>(kCpuAvx512f) : 0u;
+#endif
+    return result;
+  }();
+  return features;
+}
+
+// Returns index of last alternative whose |required| features
+// are supported by |host|, so alternatives must be ordered
+// from baseline to best.
+/// \note returns 0 (baseline) if no alternative is supported
+inline size_t selectCpuAlternative(
+  std::initializer_list<uint32_t> required
+  , uint32_t host = hostCpuFeatures())
+{
+  size_t selected = 0;
+  size_t index = 0;
+  for(const uint32_t features : required) {
+    if((features & host) == features) {
+      selected = index;
+    }
+    index++;
+  }
+  return selected;
+}
+
+} // namespace pimpl
+
+template <typename Features
+  , size_t Size
+  , size_t Alignment
+  , typename... Alternatives>
+class CpuDispatchPimpl;
+
+// Storage used by PImpl if alternatives are builds of same impl
+// for different ISA extensions (see `isa_1`, `isa_2`, etc.).
+// Constructors select best alternative supported by host CPU,
+// so choice is made once per object (not per call).
+// Generated forwarders call impl via table of function pointers
+// indexed by |index()| (without switch or virtual call).
+//
+/// \note copies keep alternative of source object.
+/// \note same requirements for |Alternatives| as for VariantPimpl.
+template <uint32_t... Features
+  , size_t Size
+  , size_t Alignment
+  , typename... Alternatives>
+class CpuDispatchPimpl<
+  pimpl::CpuFeatureList<Features...>
+  , Size
+  , Alignment
+  , Alternatives...>
+  : public VariantPimpl<Size, Alignment, Alternatives...>
+{
+public:
+  static_assert(sizeof...(Features) == sizeof...(Alternatives),
+    "expected required features for each alternative");
+
+  using Base = VariantPimpl<Size, Alignment, Alternatives...>;
+
+  // constructs alternative selected for host,
+  // every alternative must be constructible from |args|
+  template <
+    typename... Args
+    , typename = std::enable_if_t<
+        !(sizeof...(Args) == 1
+          && (std::is_same_v<std::decay_t<Args>, CpuDispatchPimpl> || ...))>
+  >
+  explicit CpuDispatchPimpl(Args&&... args)
+    : Base(
+        pimpl::RuntimeIndex{selectedIndex()}
+        , std::forward<Args>(args)...)
+  {}
+
+  CpuDispatchPimpl(const CpuDispatchPimpl& other) = default;
+
+  CpuDispatchPimpl(CpuDispatchPimpl&& other) = default;
+
+  CpuDispatchPimpl& operator=(const CpuDispatchPimpl& other) = default;
+
+  CpuDispatchPimpl& operator=(CpuDispatchPimpl&& other) = default;
+
+  // Destroys stored alternative and constructs
+  // alternative selected for host.
+  template <typename... Args>
+  void emplaceSelected(Args&&... args)
+  {
+    Base::emplace(
+      pimpl::RuntimeIndex{selectedIndex()}
+      , std::forward<Args>(args)...);
+  }
+
+  // index of best alternative supported by host,
+  // selected once per process
+  static size_t selectedIndex()
+  {
+    static const size_t index
+      = pimpl::selectCpuAlternative({Features...});
+    DCHECK_LT(index, sizeof...(Alternatives));
+    return index;
+  }
+};
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Mutex stored by interface if some methods of impl
+// use `locking` policy (see `_pimplPolicy`).
+// Generated forwarders lock it before calling impl.
+// With `locking = shared` |Mutex| is ::std::shared_mutex
+// and forwarders of const methods lock it shared.
+//
+/// \note copy or move of interface does not copy mutex,
+/// each object gets own unlocked mutex.
+/// Generated copy and move of interface lock mutex
+/// of other object, see `copyLocked` and `moveLocked`.
+template <typename Mutex>
+class ForwardingMutex {
+public:
+  // mutex can not be moved via memcpy
+  using IsRelocatable = std::false_type;
+
+  ForwardingMutex() = default;
+
+  ForwardingMutex(const ForwardingMutex&) noexcept
+  {}
+
+  ForwardingMutex(ForwardingMutex&&) noexcept
+  {}
+
+  ForwardingMutex& operator=(const ForwardingMutex&) noexcept
+  {
+    return *this;
+  }
+
+  ForwardingMutex& operator=(ForwardingMutex&&) noexcept
+  {
+    return *this;
+  }
+
+  void lock()
+  {
+    mutex_.lock();
+  }
+
+  bool try_lock()
+  {
+    return mutex_.try_lock();
+  }
+
+  void unlock()
+  {
+    mutex_.unlock();
+  }
+
+  // used only if |Mutex| is shared mutex
+
+  void lock_shared()
+  {
+    mutex_.lock_shared();
+  }
+
+  bool try_lock_shared()
+  {
+    return mutex_.try_lock_shared();
+  }
+
+  void unlock_shared()
+  {
+    mutex_.unlock_shared();
+  }
+
+private:
+  Mutex mutex_;
+};
+
+// returns copy of |storage| made while |mutex| is locked
+// (shared if |Mutex| is shared mutex),
+// used by generated copy constructor of interface:
+//  Foo::Foo(const Foo& other)
+//    : impl_(copyLocked(other.impl_, other.implMutex_))
+//  {}
+/// \note result initializes member directly (no extra move),
+/// lock is released after copy is made
+template <typename Storage, typename Mutex>
+Storage copyLocked(const Storage& storage, ForwardingMutex<Mutex>& mutex)
+{
+  if constexpr (std::is_same<Mutex, std::shared_mutex>::value) {
+    std::shared_lock<ForwardingMutex<Mutex>> lock(mutex);
+    return storage;
+  } else {
+    std::lock_guard<ForwardingMutex<Mutex>> lock(mutex);
+    return storage;
+  }
+}
+
+// same as `copyLocked`, but moves from |storage|
+// under exclusive lock, used by generated move constructor
+template <typename Storage, typename Mutex>
+Storage moveLocked(Storage& storage, ForwardingMutex<Mutex>& mutex)
+{
+  std::lock_guard<ForwardingMutex<Mutex>> lock(mutex);
+  return std::move(storage);
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
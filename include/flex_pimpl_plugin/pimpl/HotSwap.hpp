@@ -0,0 +1,100 @@
+#pragma once
+
+#include <base/logging.h>
+#include <base/macros.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Describes impl that table of forwarders was compiled with.
+// Objects of interface are constructed by code of old build,
+// so table of new build can be used only if layout is same.
+struct ImplLayout {
+  size_t size;
+
+  size_t alignment;
+
+  // hash of types and names of impl fields
+  uint64_t fieldsHash;
+
+  // hash of signatures of forwarded methods
+  uint64_t methodsHash;
+};
+
+constexpr bool operator==(const ImplLayout& lhs, const ImplLayout& rhs)
+{
+  return lhs.size == rhs.size
+    && lhs.alignment == rhs.alignment
+    && lhs.fieldsHash == rhs.fieldsHash
+    && lhs.methodsHash == rhs.methodsHash;
+}
+
+constexpr bool operator!=(const ImplLayout& lhs, const ImplLayout& rhs)
+{
+  return !(lhs == rhs);
+}
+
+// Stores table of forwarders used by all objects of interface
+// (see `hot_swap` argument of `_injectPimplMethodCalls`).
+// |Table| must have `layout` member of type |ImplLayout|.
+//
+/// \note replaced tables are never freed, because other threads
+/// may still call them, so shared object that provides table
+/// must not be unloaded.
+/// \note constructors, destructor, copy and move of interface
+/// always use impl compiled into binary.
+template <typename Table>
+class HotSwapSlot {
+public:
+  // constexpr, so slot is constant-initialized
+  constexpr explicit HotSwapSlot(const Table* table) noexcept
+    : table_(table)
+  {}
+
+  // used by every forwarder, single load without locks
+  const Table& get() const noexcept
+  {
+    return *table_.load(std::memory_order_acquire);
+  }
+
+  // Replaces table used by forwarders of all objects.
+  // Returns false (and keeps current table)
+  // if layout of |table| differs.
+  bool swap(const Table* table)
+  {
+    DCHECK(table);
+
+    const Table* current = table_.load(std::memory_order_acquire);
+    while(table->layout == current->layout) {
+      if(table_.compare_exchange_weak(
+           current
+           , table
+           , std::memory_order_acq_rel
+           , std::memory_order_acquire))
+      {
+        return true;
+      }
+    }
+
+    LOG(ERROR)
+      << "(pimpl) layout of impl changed, table not replaced: size "
+      << table->layout.size
+      << " vs "
+      << current->layout.size;
+    return false;
+  }
+
+private:
+  std::atomic<const Table*> table_;
+
+  DISALLOW_COPY_AND_ASSIGN(HotSwapSlot);
+};
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
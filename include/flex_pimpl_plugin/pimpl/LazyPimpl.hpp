@@ -0,0 +1,178 @@
+#pragma once
+
+#include <base/compiler_specific.h>
+#include <base/logging.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+// Storage used by PImpl.
+// Impl is stored inline (like ::basis::FastPimpl),
+// but constructed in place on first access.
+// Interface objects that are never used
+// do not pay for construction of impl.
+//
+/// \note |T| may be incomplete type at the point of declaration,
+/// but must be complete in the place where constructors
+/// and destructor of the interface are defined (usually .cc file).
+/// \note lazy construction is not thread-safe,
+/// same as any other non-const access to impl.
+/// Const access also constructs impl, so first const calls
+/// from several threads race unless impl is constructed
+/// beforehand (see |get() const|).
+template <typename T, size_t Size, size_t Alignment>
+class LazyPimpl {
+public:
+  LazyPimpl() noexcept = default;
+
+  LazyPimpl(const LazyPimpl& other)
+  {
+    if(other.constructed_) {
+      emplace(*other.ptr());
+    }
+  }
+
+  LazyPimpl(LazyPimpl&& other)
+    noexcept(std::is_nothrow_move_constructible<T>::value)
+  {
+    if(other.constructed_) {
+      emplace(std::move(*other.ptr()));
+    }
+  }
+
+  LazyPimpl& operator=(const LazyPimpl& other)
+  {
+    if(this != &other) {
+      if(!other.constructed_) {
+        reset();
+      } else if(constructed_) {
+        *ptr() = *other.ptr();
+      } else {
+        emplace(*other.ptr());
+      }
+    }
+    return *this;
+  }
+
+  LazyPimpl& operator=(LazyPimpl&& other)
+    noexcept(std::is_nothrow_move_assignable<T>::value
+             && std::is_nothrow_move_constructible<T>::value)
+  {
+    if(this != &other) {
+      if(!other.constructed_) {
+        reset();
+      } else if(constructed_) {
+        *ptr() = std::move(*other.ptr());
+      } else {
+        emplace(std::move(*other.ptr()));
+      }
+    }
+    return *this;
+  }
+
+  ~LazyPimpl()
+  {
+    validate<sizeof(T), alignof(T)>();
+    reset();
+  }
+
+  // Constructs impl (if not constructed yet) and returns it.
+  ALWAYS_INLINE T& get()
+  {
+    if(UNLIKELY(!constructed_)) {
+      constructSlow();
+    }
+    return *ptr();
+  }
+
+  /// \note const methods of interface also construct impl,
+  /// so storage behaves as if impl was constructed eagerly.
+  /// \note construction on first const access modifies |mutable| storage,
+  /// so concurrent first const calls are a data race.
+  /// Call non-const method (or |emplace|) before sharing object
+  /// between threads.
+  ALWAYS_INLINE const T& get() const
+  {
+    if(UNLIKELY(!constructed_)) {
+      constructSlow();
+    }
+    return *ptr();
+  }
+
+  T* operator->() { return &get(); }
+
+  const T* operator->() const { return &get(); }
+
+  T& operator*() { return get(); }
+
+  const T& operator*() const { return get(); }
+
+  bool isConstructed() const noexcept
+  {
+    return constructed_;
+  }
+
+  // Constructs impl with custom arguments
+  // (destroys previously constructed impl).
+  template <typename... Args>
+  T& emplace(Args&&... args)
+  {
+    validate<sizeof(T), alignof(T)>();
+    reset();
+    ::new (static_cast<void*>(&storage_)) T(std::forward<Args>(args)...);
+    constructed_ = true;
+    return *ptr();
+  }
+
+  void reset() noexcept
+  {
+    if(constructed_) {
+      ptr()->~T();
+      constructed_ = false;
+    }
+  }
+
+private:
+  template <size_t ActualSize, size_t ActualAlignment>
+  static void validate() noexcept
+  {
+    static_assert(Size >= ActualSize,
+      "invalid Size: Size >= sizeof(T) failed");
+    static_assert(Alignment % ActualAlignment == 0,
+      "invalid Alignment: Alignment % alignof(T) == 0 failed");
+  }
+
+  // const because impl is logically part of interface object
+  // even if not constructed yet
+  NOINLINE void constructSlow() const
+  {
+    validate<sizeof(T), alignof(T)>();
+    DCHECK(!constructed_);
+    ::new (static_cast<void*>(&storage_)) T();
+    constructed_ = true;
+  }
+
+  T* ptr() noexcept
+  {
+    DCHECK(constructed_);
+    return std::launder(reinterpret_cast<T*>(&storage_));
+  }
+
+  const T* ptr() const noexcept
+  {
+    DCHECK(constructed_);
+    return std::launder(reinterpret_cast<const T*>(&storage_));
+  }
+
+private:
+  // |mutable| because const access constructs impl
+  mutable std::aligned_storage_t<Size, Alignment> storage_;
+
+  mutable bool constructed_ = false;
+};
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// number of cached results per memoized method
+// if `memoize` policy is used without capacity
+constexpr size_t kDefaultMemoCapacity = 8;
+
+// combines std::hash of all elements of |args|
+template <typename... Args>
+size_t hashArgs(const std::tuple<Args...>& args)
+{
+  size_t seed = sizeof...(Args);
+  std::apply([&seed](const auto&... arg) {
+    // same mixing as boost::hash_combine
+    ((seed ^= std::hash<std::decay_t<decltype(arg)>>{}(arg)
+        + 0x9e3779b9 + (seed << 6) + (seed >> 2)), ...);
+  }, args);
+  return seed;
+}
+
+// Bounded cache of results of memoized method (see `memoize` policy).
+// Interface stores one cache per memoized method,
+// generated forwarders of non-const methods |clear()| all caches
+// because impl may change.
+//
+/// \note cache is not thread-safe: const methods of interface
+/// modify it, use `locking = exclusive` policy if interface
+/// is used from multiple threads.
+/// \note entries are replaced in round-robin order,
+/// so lookup is linear scan of |Capacity| hashes.
+template <typename Key, typename Value, size_t Capacity>
+class MemoCache {
+public:
+  static_assert(Capacity > 0, "expected non-empty cache");
+
+  MemoCache() = default;
+
+  MemoCache(const MemoCache& other) = default;
+
+  // moved-from interface has moved-from impl,
+  // so its results are not valid anymore
+  MemoCache(MemoCache&& other) noexcept(
+    std::is_nothrow_move_constructible<Key>::value
+    && std::is_nothrow_move_constructible<Value>::value)
+    : entries_(std::move(other.entries_))
+    , next_(other.next_)
+  {
+    other.clear();
+  }
+
+  MemoCache& operator=(const MemoCache& other) = default;
+
+  MemoCache& operator=(MemoCache&& other) noexcept(
+    std::is_nothrow_move_assignable<Key>::value
+    && std::is_nothrow_move_assignable<Value>::value
+    && std::is_nothrow_move_constructible<Key>::value
+    && std::is_nothrow_move_constructible<Value>::value)
+  {
+    if(this != &other) {
+      entries_ = std::move(other.entries_);
+      next_ = other.next_;
+      other.clear();
+    }
+    return *this;
+  }
+
+  // |key| is tuple of references to arguments,
+  // example: std::forward_as_tuple(arg1, arg2)
+  template <typename... Args>
+  const Value* find(const std::tuple<Args...>& key) const
+  {
+    const size_t hash = hashArgs(key);
+    for(const std::optional<Entry>& entry : entries_) {
+      if(entry && entry->hash == hash && entry->key == key) {
+        hits_++;
+        return &entry->value;
+      }
+    }
+    misses_++;
+    return nullptr;
+  }
+
+  // replaces oldest entry, returns cached |value|
+  template <typename... Args>
+  const Value& insert(const std::tuple<Args...>& key, Value value)
+  {
+    std::optional<Entry>& entry = entries_[next_];
+    next_ = (next_ + 1) % Capacity;
+    entry.emplace(Entry{hashArgs(key), Key(key), std::move(value)});
+    return entry->value;
+  }
+
+  void clear() noexcept
+  {
+    for(std::optional<Entry>& entry : entries_) {
+      entry.reset();
+    }
+    next_ = 0;
+  }
+
+  size_t hits() const noexcept
+  {
+    return hits_;
+  }
+
+  size_t misses() const noexcept
+  {
+    return misses_;
+  }
+
+private:
+  struct Entry {
+    size_t hash;
+    Key key;
+    Value value;
+  };
+
+  std::array<std::optional<Entry>, Capacity> entries_{};
+
+  // index of entry that will be replaced by next insertion
+  size_t next_ = 0;
+
+  // statistics, used by benchmarks
+  mutable size_t hits_ = 0;
+
+  mutable size_t misses_ = 0;
+};
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
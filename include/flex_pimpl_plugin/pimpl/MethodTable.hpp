@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+/// \note header is also used by code generator,
+/// so it depends only on standard library.
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Type-erased call of forwarder by name
+// (see `by_name` argument of `_injectPimplMethodCalls`).
+// |object| points to interface,
+// |args| point to arguments of parameter types without reference
+// (argument is moved if parameter is passed by value
+// or by rvalue reference),
+// |result| points to uninitialized storage for return value
+// without reference (ignored if method returns void).
+using MethodInvoker = void (*)(
+  void* object, void* const* args, void* result);
+
+struct MethodEntry {
+  std::string_view name;
+
+  // nullptr in empty slots of table
+  MethodInvoker invoke = nullptr;
+
+  // number of elements in |args|
+  size_t arity = 0;
+
+  bool isConst = false;
+};
+
+// FNV-1a with seed, code generator selects seed
+// that maps each method name to own slot (perfect hash)
+constexpr uint64_t methodNameHash(std::string_view name, uint64_t seed)
+{
+  uint64_t hash = 0xcbf29ce484222325ull ^ (seed * 0x9e3779b97f4a7c15ull);
+  for(const char c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// single hash and single string comparison,
+// returns nullptr if interface has no method |name|
+template <size_t N>
+constexpr const MethodEntry* findMethodEntry(
+  const std::array<MethodEntry, N>& table
+  , uint64_t seed
+  , std::string_view name) noexcept
+{
+  if constexpr (N == 0) {
+    return nullptr;
+  } else {
+    const MethodEntry& entry = table[methodNameHash(name, seed) % N];
+    return entry.invoke && entry.name == name
+      ? &entry
+      : nullptr;
+  }
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
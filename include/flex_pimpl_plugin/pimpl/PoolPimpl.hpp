@@ -0,0 +1,357 @@
+#pragma once
+
+#include <base/logging.h>
+#include <base/macros.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Snapshot of |SlabPool| counters.
+struct PoolStats {
+  // size of single slot (impl size rounded up to size class)
+  size_t slotSize = 0;
+
+  size_t slotAlignment = 0;
+
+  // number of slabs requested from system allocator
+  size_t slabCount = 0;
+
+  // number of slots carved from all slabs
+  size_t capacity = 0;
+
+  // number of slots used by alive objects
+  size_t liveSlots = 0;
+
+  size_t peakLiveSlots = 0;
+
+  size_t allocations = 0;
+
+  size_t deallocations = 0;
+
+  // allocations served from free list (without touching fresh memory)
+  size_t reusedSlots = 0;
+};
+
+enum class PoolEvent {
+  // not reported to hook
+  kNone,
+  // pool requested new slab from system allocator
+  kSlabAllocated,
+  // pool served allocation from free list
+  kSlotReused,
+};
+
+// Statistics hook, called after pool lock is released
+// with copy of counters, so it may use the same pool.
+using PoolStatsHook = void (*)(
+  PoolEvent event, const PoolStats& stats, void* context);
+
+// Rounds impl size up, so impls of similar size share same pool.
+constexpr size_t kPoolSizeClassGranularity = 16;
+
+constexpr size_t poolSlotAlignment(size_t alignment)
+{
+  return alignment < alignof(void*) ? alignof(void*) : alignment;
+}
+
+constexpr size_t poolSizeClass(size_t size, size_t alignment)
+{
+  const size_t granularity
+    = alignment > kPoolSizeClassGranularity
+      ? alignment
+      : kPoolSizeClassGranularity;
+  return ((size + granularity - 1) / granularity) * granularity;
+}
+
+/// \note Slabs are never returned to system allocator,
+/// freed slots are reused by next allocations.
+/// Pool is thread-safe.
+template <size_t SlotSize, size_t SlotAlignment>
+class SlabPool {
+public:
+  static_assert(SlotSize >= sizeof(void*),
+    "slot must be able to store free list link");
+  static_assert(SlotSize % SlotAlignment == 0,
+    "slots in slab must stay aligned");
+
+  // approximate size of memory block requested from system allocator
+  static constexpr size_t kSlabBytes = 64 * 1024;
+
+  static constexpr size_t kSlotsPerSlab
+    = kSlabBytes / SlotSize > 0 ? kSlabBytes / SlotSize : 1;
+
+  // Pool is shared by all impl types of same size class.
+  /// \note intentionally leaked to avoid destruction order issues
+  /// with objects that are destroyed at exit.
+  static SlabPool& Get()
+  {
+    static SlabPool* instance = new SlabPool();
+    return *instance;
+  }
+
+  void* Allocate()
+  {
+    void* slot = nullptr;
+    PoolEvent event = PoolEvent::kSlotReused;
+    PoolStats statsCopy;
+    PoolStatsHook hook = nullptr;
+    void* hookContext = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if(freeList_) {
+        FreeSlot* freeSlot = freeList_;
+        freeList_ = freeSlot->next;
+        slot = freeSlot;
+        stats_.reusedSlots++;
+      } else {
+        if(!bumpCursor_ || bumpCursor_ == bumpEnd_) {
+          // may throw |std::bad_alloc|, counters stay unchanged
+          allocateSlab();
+          event = PoolEvent::kSlabAllocated;
+        } else {
+          // slot carved from already allocated slab is not reported
+          event = PoolEvent::kNone;
+        }
+        slot = bumpCursor_;
+        bumpCursor_ += SlotSize;
+      }
+
+      stats_.allocations++;
+      stats_.liveSlots++;
+      if(stats_.liveSlots > stats_.peakLiveSlots) {
+        stats_.peakLiveSlots = stats_.liveSlots;
+      }
+
+      if(statsHook_ && event != PoolEvent::kNone) {
+        hook = statsHook_;
+        hookContext = statsHookContext_;
+        statsCopy = stats_;
+      }
+    }
+
+    if(hook) {
+      hook(event, statsCopy, hookContext);
+    }
+    return slot;
+  }
+
+  void Deallocate(void* ptr)
+  {
+    DCHECK(ptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    DCHECK_GT(stats_.liveSlots, 0u);
+    stats_.liveSlots--;
+    stats_.deallocations++;
+
+    FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+    slot->next = freeList_;
+    freeList_ = slot;
+  }
+
+  PoolStats stats() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  // Pass nullptr to remove hook.
+  void setStatsHook(PoolStatsHook hook, void* context)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statsHook_ = hook;
+    statsHookContext_ = context;
+  }
+
+private:
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  SlabPool()
+  {
+    stats_.slotSize = SlotSize;
+    stats_.slotAlignment = SlotAlignment;
+  }
+
+  ~SlabPool() = delete;
+
+  void allocateSlab()
+  {
+    bumpCursor_ = static_cast<uint8_t*>(
+      ::operator new(
+        SlotSize * kSlotsPerSlab
+        , std::align_val_t{SlotAlignment}));
+    bumpEnd_ = bumpCursor_ + SlotSize * kSlotsPerSlab;
+    stats_.slabCount++;
+    stats_.capacity += kSlotsPerSlab;
+  }
+
+private:
+  mutable std::mutex mutex_;
+
+  FreeSlot* freeList_ = nullptr;
+
+  // not yet used part of last slab
+  uint8_t* bumpCursor_ = nullptr;
+
+  uint8_t* bumpEnd_ = nullptr;
+
+  PoolStats stats_{};
+
+  PoolStatsHook statsHook_ = nullptr;
+
+  void* statsHookContext_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(SlabPool);
+};
+
+// Pool used to allocate objects of type |T|.
+/// \note |T| must be complete type.
+template <typename T>
+using PoolFor = SlabPool<
+  poolSizeClass(sizeof(T), poolSlotAlignment(alignof(T)))
+  , poolSlotAlignment(alignof(T))>;
+
+} // namespace pimpl
+
+// Storage used by PImpl.
+// Interface stores single pointer, impl is allocated
+// from size-class pool (see |pimpl::SlabPool|)
+// shared by all impl types of similar size.
+//
+/// \note moved-from storage holds nullptr, it may only be
+/// destroyed or assigned to (same as moved-from |std::unique_ptr|),
+/// calling methods of moved-from interface is undefined behavior
+/// (checked by DCHECK in debug builds).
+//
+/// \note |T| may be incomplete type at the point of declaration,
+/// but must be complete in the place where constructors
+/// and destructor of the interface are defined (usually .cc file).
+/// Same requirement as for |std::unique_ptr|.
+template <typename T>
+class PoolPimpl {
+public:
+  // storage is single pointer, so it can be relocated via memcpy
+  // regardless of |T|, see ::flex_pimpl_plugin::pimpl::IsTriviallyRelocatable
+  using IsRelocatable = std::true_type;
+
+  template <
+    typename... Args
+    , typename = std::enable_if_t<
+        !(sizeof...(Args) == 1
+          && (std::is_same_v<std::decay_t<Args>, PoolPimpl> || ...))>
+  >
+  explicit PoolPimpl(Args&&... args)
+  {
+    // returns slot back to pool if constructor of |T| throws
+    struct SlotGuard {
+      ~SlotGuard() {
+        if(slot) {
+          pimpl::PoolFor<T>::Get().Deallocate(slot);
+        }
+      }
+      void* slot;
+    } guard{pimpl::PoolFor<T>::Get().Allocate()};
+
+    ptr_ = new (guard.slot) T(std::forward<Args>(args)...);
+    guard.slot = nullptr;
+  }
+
+  PoolPimpl(const PoolPimpl& other)
+    : PoolPimpl(*other)
+  {}
+
+  PoolPimpl(PoolPimpl&& other) noexcept
+    : ptr_(other.ptr_)
+  {
+    other.ptr_ = nullptr;
+  }
+
+  PoolPimpl& operator=(const PoolPimpl& other)
+  {
+    if(this != &other) {
+      PoolPimpl tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  PoolPimpl& operator=(PoolPimpl&& other) noexcept
+  {
+    PoolPimpl tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  ~PoolPimpl()
+  {
+    reset();
+  }
+
+  void swap(PoolPimpl& other) noexcept
+  {
+    std::swap(ptr_, other.ptr_);
+  }
+
+  T* operator->() noexcept
+  {
+    DCHECK(ptr_) << "use of moved-from pimpl";
+    return ptr_;
+  }
+
+  const T* operator->() const noexcept
+  {
+    DCHECK(ptr_) << "use of moved-from pimpl";
+    return ptr_;
+  }
+
+  T& operator*() noexcept
+  {
+    DCHECK(ptr_) << "use of moved-from pimpl";
+    return *ptr_;
+  }
+
+  const T& operator*() const noexcept
+  {
+    DCHECK(ptr_) << "use of moved-from pimpl";
+    return *ptr_;
+  }
+
+  static pimpl::PoolStats stats()
+  {
+    return pimpl::PoolFor<T>::Get().stats();
+  }
+
+  /// \note hook is shared by all types of same size class
+  static void setStatsHook(pimpl::PoolStatsHook hook, void* context)
+  {
+    pimpl::PoolFor<T>::Get().setStatsHook(hook, context);
+  }
+
+private:
+  void reset() noexcept
+  {
+    if(ptr_) {
+      ptr_->~T();
+      pimpl::PoolFor<T>::Get().Deallocate(ptr_);
+      ptr_ = nullptr;
+    }
+  }
+
+private:
+  T* ptr_ = nullptr;
+};
+
+} // namespace flex_pimpl_plugin
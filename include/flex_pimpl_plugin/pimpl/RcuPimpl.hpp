@@ -0,0 +1,419 @@
+#pragma once
+
+#include <base/compiler_specific.h>
+#include <base/logging.h>
+#include <base/macros.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// slots of different threads must not share cache line
+static constexpr size_t kRcuCacheLineSize = 64;
+
+// State of thread that reads impl of `storage = rcu`.
+// Written only by owning thread (and read by writers),
+// so readers do not write cache lines of other readers.
+struct alignas(kRcuCacheLineSize) RcuReaderSlot {
+  // epoch observed when outermost read section started,
+  // 0 if thread does not read
+  std::atomic<uint64_t> epoch{0};
+
+  // slot of exited thread is reused by new thread
+  std::atomic<bool> isUsed{true};
+
+  // slots are never freed
+  RcuReaderSlot* next = nullptr;
+};
+
+// Epoch-based reclamation shared by all objects with `storage = rcu`.
+// Reader stores current epoch into slot of its thread,
+// writer advances epoch after publishing new impl
+// and frees old impl when every reading thread observed later epoch.
+//
+/// \note read sections never wait, writers never wait for readers
+/// (old impl that is still read is freed by later write).
+class RcuDomain {
+public:
+  static RcuDomain& get() noexcept
+  {
+    static RcuDomain domain;
+    return domain;
+  }
+
+  // read sections may be nested (forwarder of other interface
+  // called by impl), only outermost section stores epoch
+  void enterRead()
+  {
+    ReaderState& state = readerState();
+    if(state.depth++ == 0) {
+      if(UNLIKELY(!state.slot)) {
+        state.slot = acquireSlot();
+      }
+      // store must be visible to writers before
+      // reader loads impl pointer (store-load order)
+      state.slot->epoch.store(
+        epoch_.load(std::memory_order_relaxed)
+        , std::memory_order_seq_cst);
+    }
+  }
+
+  void exitRead() noexcept
+  {
+    ReaderState& state = readerState();
+    DCHECK(state.depth > 0);
+    if(--state.depth == 0) {
+      state.slot->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  // Called after new impl was published.
+  // Returns epoch that readers of old impl may have observed.
+  uint64_t advance() noexcept
+  {
+    return epoch_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  // Impl retired at epoch that is less than result can be freed,
+  // max. value if no thread reads
+  uint64_t oldestReaderEpoch() const noexcept
+  {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for(const RcuReaderSlot* slot = slots_.load(std::memory_order_acquire)
+        ; slot
+        ; slot = slot->next)
+    {
+      const uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+      if(epoch != 0 && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+    return oldest;
+  }
+
+private:
+  struct ReaderState {
+    ~ReaderState()
+    {
+      if(slot) {
+        DCHECK_EQ(depth, 0u);
+        slot->isUsed.store(false, std::memory_order_release);
+      }
+    }
+
+    RcuReaderSlot* slot = nullptr;
+
+    size_t depth = 0;
+  };
+
+  RcuDomain() = default;
+
+  static ReaderState& readerState() noexcept
+  {
+    static thread_local ReaderState state;
+    return state;
+  }
+
+  // called once per thread
+  NOINLINE RcuReaderSlot* acquireSlot()
+  {
+    for(RcuReaderSlot* slot = slots_.load(std::memory_order_acquire)
+        ; slot
+        ; slot = slot->next)
+    {
+      bool isUsed = false;
+      if(!slot->isUsed.load(std::memory_order_relaxed)
+         && slot->isUsed.compare_exchange_strong(
+              isUsed
+              , true
+              , std::memory_order_acquire))
+      {
+        return slot;
+      }
+    }
+
+    RcuReaderSlot* slot = new RcuReaderSlot;
+    slot->next = slots_.load(std::memory_order_relaxed);
+    while(!slots_.compare_exchange_weak(
+            slot->next
+            , slot
+            , std::memory_order_release
+            , std::memory_order_relaxed))
+    {}
+    return slot;
+  }
+
+private:
+  // 0 is reserved for threads that do not read
+  std::atomic<uint64_t> epoch_{1};
+
+  std::atomic<RcuReaderSlot*> slots_{nullptr};
+
+  DISALLOW_COPY_AND_ASSIGN(RcuDomain);
+};
+
+} // namespace pimpl
+
+// Storage used by PImpl for read-mostly objects
+// (configuration, routing tables).
+// Interface holds atomically published immutable impl.
+// Generated forwarders of const methods call |read()|
+// that loads impl without locks (readers do not write
+// shared memory), forwarders of non-const methods call |write()|
+// that clones impl, modifies clone and publishes it.
+// Old impl is freed when no thread can read it
+// (see ::flex_pimpl_plugin::pimpl::RcuDomain).
+//
+/// \note non-const calls of same object are serialized by mutex
+/// and copy impl, so use it only if writes are rare.
+/// \note reference, pointer or view (`::std::string_view`, span)
+/// returned by method of impl may refer to impl that is freed
+/// after forwarder returns, so code generator rejects such methods.
+/// \note |T| may be incomplete type at the point of declaration,
+/// but must be complete in the place where constructors
+/// and destructor of the interface are defined (usually .cc file).
+template <typename T>
+class RcuPimpl {
+private:
+  struct Node {
+    template <typename... Args>
+    explicit Node(Args&&... args)
+      : value(std::forward<Args>(args)...)
+    {}
+
+    T value;
+
+    // epoch returned by |RcuDomain::advance| when node was replaced
+    uint64_t retiredEpoch = 0;
+
+    Node* nextRetired = nullptr;
+  };
+
+public:
+  // keeps impl alive while const method of impl is called
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const RcuPimpl& owner)
+    {
+      pimpl::RcuDomain::get().enterRead();
+      node_ = owner.current_.load(std::memory_order_seq_cst);
+      DCHECK(node_) << "use of moved-from pimpl";
+    }
+
+    ~ReadGuard()
+    {
+      pimpl::RcuDomain::get().exitRead();
+    }
+
+    const T* operator->() const noexcept { return &node_->value; }
+
+    const T& operator*() const noexcept { return node_->value; }
+
+  private:
+    const Node* node_;
+
+    DISALLOW_COPY_AND_ASSIGN(ReadGuard);
+  };
+
+  // Clone of impl modified by non-const method of impl,
+  // published when guard is destroyed
+  // (discarded if method throws).
+  class WriteGuard {
+  public:
+    explicit WriteGuard(RcuPimpl& owner)
+      : owner_(owner)
+      , lock_(owner.writeMutex_)
+      , exceptions_(std::uncaught_exceptions())
+    {
+      const Node* current = owner.current_.load(std::memory_order_acquire);
+      DCHECK(current) << "use of moved-from pimpl";
+      clone_ = new Node(static_cast<const T&>(current->value));
+    }
+
+    ~WriteGuard()
+    {
+      if(UNLIKELY(std::uncaught_exceptions() > exceptions_)) {
+        delete clone_;
+        return;
+      }
+      owner_.publishLocked(clone_);
+    }
+
+    T* operator->() const noexcept { return &clone_->value; }
+
+    T& operator*() const noexcept { return clone_->value; }
+
+  private:
+    RcuPimpl& owner_;
+
+    std::lock_guard<std::mutex> lock_;
+
+    const int exceptions_;
+
+    Node* clone_;
+
+    DISALLOW_COPY_AND_ASSIGN(WriteGuard);
+  };
+
+  template <
+    typename... Args
+    , typename = std::enable_if_t<
+        !(sizeof...(Args) == 1
+          && (std::is_same_v<std::decay_t<Args>, RcuPimpl> || ...))>
+  >
+  explicit RcuPimpl(Args&&... args)
+    : current_(new Node(std::forward<Args>(args)...))
+  {}
+
+  // copies impl that is published by |other|
+  RcuPimpl(const RcuPimpl& other)
+    : current_(new Node(*other.read()))
+  {}
+
+  // |other| must not be used concurrently
+  RcuPimpl(RcuPimpl&& other) noexcept
+    : current_(other.current_.exchange(nullptr, std::memory_order_relaxed))
+    , retired_(std::exchange(other.retired_, nullptr))
+  {}
+
+  RcuPimpl& operator=(const RcuPimpl& other)
+  {
+    if(this != &other) {
+      Node* copy = new Node(*other.read());
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      publishLocked(copy);
+    }
+    return *this;
+  }
+
+  // readers of this object may still read old impl,
+  // |other| must not be used concurrently
+  RcuPimpl& operator=(RcuPimpl&& other) noexcept
+  {
+    if(this != &other) {
+      Node* node = other.current_.exchange(nullptr, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(writeMutex_);
+      // retired impls of |other| are not read by anyone
+      appendRetired(std::exchange(other.retired_, nullptr));
+      publishLocked(node);
+    }
+    return *this;
+  }
+
+  // no thread may read object that is destroyed,
+  // so retired impls are freed immediately
+  ~RcuPimpl()
+  {
+    delete current_.load(std::memory_order_relaxed);
+    freeRetired(retired_);
+  }
+
+  // used by const methods of interface, never copies impl
+  ReadGuard read() const
+  {
+    return ReadGuard(*this);
+  }
+
+  // used by non-const methods of interface
+  WriteGuard write()
+  {
+    return WriteGuard(*this);
+  }
+
+  // replaces impl without copy of current impl
+  template <typename... Args>
+  void emplace(Args&&... args)
+  {
+    Node* node = new Node(std::forward<Args>(args)...);
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    publishLocked(node);
+  }
+
+  // Frees retired impls that are not read anymore.
+  // Called by every write, call it if object
+  // is not modified for long time after burst of writes.
+  void reclaim()
+  {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    reclaimLocked();
+  }
+
+  // number of replaced impls that are not freed yet
+  size_t retiredCount() const
+  {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    size_t count = 0;
+    for(const Node* node = retired_; node; node = node->nextRetired) {
+      count++;
+    }
+    return count;
+  }
+
+private:
+  void publishLocked(Node* node) noexcept
+  {
+    DCHECK(node);
+    Node* old = current_.exchange(node, std::memory_order_seq_cst);
+    if(old) {
+      old->retiredEpoch = pimpl::RcuDomain::get().advance();
+      old->nextRetired = retired_;
+      retired_ = old;
+    }
+    reclaimLocked();
+  }
+
+  void reclaimLocked() noexcept
+  {
+    if(!retired_) {
+      return;
+    }
+    const uint64_t oldestReaderEpoch
+      = pimpl::RcuDomain::get().oldestReaderEpoch();
+    Node** link = &retired_;
+    while(Node* node = *link) {
+      if(node->retiredEpoch < oldestReaderEpoch) {
+        *link = node->nextRetired;
+        delete node;
+      } else {
+        link = &node->nextRetired;
+      }
+    }
+  }
+
+  void appendRetired(Node* nodes) noexcept
+  {
+    Node** link = &retired_;
+    while(*link) {
+      link = &(*link)->nextRetired;
+    }
+    *link = nodes;
+  }
+
+  static void freeRetired(Node* node) noexcept
+  {
+    while(node) {
+      delete std::exchange(node, node->nextRetired);
+    }
+  }
+
+private:
+  std::atomic<Node*> current_;
+
+  // replaced impls that may be read by other threads,
+  // guarded by |writeMutex_|
+  Node* retired_ = nullptr;
+
+  // serializes non-const calls, each object gets own mutex
+  mutable std::mutex writeMutex_;
+};
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Replaces |object| with object constructed from |args|
+// in memory of |object| (without deallocation and allocation).
+// Used by generated `Foo::emplace`.
+//
+/// \note if constructor of |T| may throw, new object is constructed
+/// as temporary and move-assigned, so |object| stays valid
+/// if constructor throws.
+/// \note |T| must not have const or reference members,
+/// storage accesses new object via old pointer.
+template <typename T, typename... Args>
+void reconstruct(T& object, Args&&... args)
+{
+  if constexpr (std::is_nothrow_constructible<T, Args&&...>::value) {
+    T* ptr = std::addressof(object);
+    ptr->~T();
+    ::new (static_cast<void*>(ptr)) T(std::forward<Args>(args)...);
+  } else {
+    object = T(std::forward<Args>(args)...);
+  }
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Object is trivially relocatable if moving it to new address
+// and destroying old object is same as copying its bytes
+// (old object must be treated as destroyed after copying).
+//
+// Code generator marks interface as trivially relocatable with
+//   using IsRelocatable = std::true_type;
+// (same convention as used by folly::IsRelocatable).
+template <typename T, typename = void>
+struct IsTriviallyRelocatable
+  : std::is_trivially_copyable<T>
+{};
+
+template <typename T>
+struct IsTriviallyRelocatable<T, std::void_t<typename T::IsRelocatable>>
+  : std::integral_constant<bool, T::IsRelocatable::value>
+{};
+
+template <typename T>
+inline constexpr bool kIsTriviallyRelocatable
+  = IsTriviallyRelocatable<T>::value;
+
+// Moves |count| objects from |src| into uninitialized memory |dst|
+// and ends lifetime of objects in |src|.
+//
+/// \note |src| and |dst| must not overlap.
+template <typename T>
+void relocate(T* src, size_t count, T* dst)
+  noexcept(kIsTriviallyRelocatable<T>
+           || std::is_nothrow_move_constructible<T>::value)
+{
+  if constexpr (kIsTriviallyRelocatable<T>) {
+    if(count) {
+      std::memcpy(
+        static_cast<void*>(dst)
+        , static_cast<const void*>(src)
+        , count * sizeof(T));
+    }
+  } else {
+    for(size_t i = 0; i < count; i++) {
+      ::new (static_cast<void*>(dst + i)) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// Binary format of field of impl, used by forwarders generated
+// for `snapshot` argument of `_injectPimplMethodCalls`.
+// Trivially copyable types are copied as is,
+// specialize for other types of fields.
+//
+/// \note format uses native byte order and sizes,
+/// so snapshot can be restored only by same build of impl
+/// (crash recovery, checkpoints), it is not a wire format.
+/// \note pointers are rejected, restored address would point
+/// into memory of other process (plugin also rejects
+/// pointers inside of fields of trivially copyable class).
+/// \note |read| must not access memory at or after |end|
+/// and returns nullptr if input is too short (truncated file),
+/// value may be partially modified in that case.
+template <typename T, typename = void>
+struct SnapshotTraits {
+  static_assert(std::is_trivially_copyable<T>::value,
+    "specialize ::flex_pimpl_plugin::pimpl::SnapshotTraits for type of field");
+  static_assert(!std::is_pointer<T>::value
+      && !std::is_member_pointer<T>::value
+      && !std::is_null_pointer<T>::value,
+    "snapshot can not store pointer");
+
+  static size_t size(const T&) noexcept
+  {
+    return sizeof(T);
+  }
+
+  // returns position after written value
+  static char* write(const T& value, char* out) noexcept
+  {
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+  }
+
+  // returns position after read value
+  static const char* read(T& value, const char* in, const char* end) noexcept
+  {
+    if(static_cast<size_t>(end - in) < sizeof(T)) {
+      return nullptr;
+    }
+    std::memcpy(&value, in, sizeof(T));
+    return in + sizeof(T);
+  }
+};
+
+// number of characters, then characters
+template <typename CharT, typename Traits, typename Allocator>
+struct SnapshotTraits<std::basic_string<CharT, Traits, Allocator>> {
+  using String = std::basic_string<CharT, Traits, Allocator>;
+
+  static size_t size(const String& value) noexcept
+  {
+    return sizeof(uint64_t) + value.size() * sizeof(CharT);
+  }
+
+  static char* write(const String& value, char* out) noexcept
+  {
+    out = SnapshotTraits<uint64_t>::write(value.size(), out);
+    std::memcpy(out, value.data(), value.size() * sizeof(CharT));
+    return out + value.size() * sizeof(CharT);
+  }
+
+  static const char* read(String& value, const char* in, const char* end)
+  {
+    uint64_t count = 0;
+    in = SnapshotTraits<uint64_t>::read(count, in, end);
+    // checked before allocation, |count| may be garbage
+    if(!in || count > static_cast<size_t>(end - in) / sizeof(CharT)) {
+      return nullptr;
+    }
+    // reuses capacity of |value|
+    value.resize(count);
+    if(count) {
+      std::memcpy(&value[0], in, count * sizeof(CharT));
+    }
+    return in + count * sizeof(CharT);
+  }
+};
+
+// number of elements, then elements
+// (single memcpy if elements are trivially copyable)
+template <typename T, typename Allocator>
+struct SnapshotTraits<std::vector<T, Allocator>> {
+  using Vector = std::vector<T, Allocator>;
+
+  // elements bypass |SnapshotTraits<T>| if copied via memcpy
+  static_assert(!std::is_pointer<T>::value
+      && !std::is_member_pointer<T>::value
+      && !std::is_null_pointer<T>::value,
+    "snapshot can not store pointer");
+
+  static size_t size(const Vector& value) noexcept
+  {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      return sizeof(uint64_t) + value.size() * sizeof(T);
+    } else {
+      size_t result = sizeof(uint64_t);
+      for(const T& element : value) {
+        result += SnapshotTraits<T>::size(element);
+      }
+      return result;
+    }
+  }
+
+  static char* write(const Vector& value, char* out) noexcept
+  {
+    out = SnapshotTraits<uint64_t>::write(value.size(), out);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if(!value.empty()) {
+        std::memcpy(out, value.data(), value.size() * sizeof(T));
+      }
+      return out + value.size() * sizeof(T);
+    } else {
+      for(const T& element : value) {
+        out = SnapshotTraits<T>::write(element, out);
+      }
+      return out;
+    }
+  }
+
+  static const char* read(Vector& value, const char* in, const char* end)
+  {
+    uint64_t count = 0;
+    in = SnapshotTraits<uint64_t>::read(count, in, end);
+    if(!in) {
+      return nullptr;
+    }
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      // checked before allocation, |count| may be garbage
+      if(count > static_cast<size_t>(end - in) / sizeof(T)) {
+        return nullptr;
+      }
+      value.resize(count);
+      if(count) {
+        std::memcpy(value.data(), in, count * sizeof(T));
+      }
+      return in + count * sizeof(T);
+    } else {
+      // size of element is unknown until it is read,
+      // so vector grows only while input has elements
+      // (existing elements are reused)
+      for(uint64_t i = 0; i < count; i++) {
+        if(i == value.size()) {
+          value.emplace_back();
+        }
+        in = SnapshotTraits<T>::read(value[i], in, end);
+        if(!in) {
+          return nullptr;
+        }
+      }
+      value.resize(count);
+      return in;
+    }
+  }
+};
+
+template <typename T>
+size_t snapshotSize(const T& value)
+{
+  return SnapshotTraits<T>::size(value);
+}
+
+template <typename T>
+char* writeSnapshot(const T& value, char* out)
+{
+  return SnapshotTraits<T>::write(value, out);
+}
+
+// returns nullptr if input is too short
+// or if |in| is nullptr (result of failed previous read),
+// so reads of fields can be chained
+template <typename T>
+const char* readSnapshot(T& value, const char* in, const char* end)
+{
+  if(!in) {
+    return nullptr;
+  }
+  return SnapshotTraits<T>::read(value, in, end);
+}
+
+} // namespace pimpl
+
+} // namespace flex_pimpl_plugin
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <base/logging.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace flex_pimpl_plugin {
+
+namespace pimpl {
+
+// index of |T| in |Alternatives|
+template <typename T, typename... Alternatives>
+constexpr size_t alternativeIndex()
+{
+  constexpr bool matches[] = {std::is_same_v<T, Alternatives>...};
+  for(size_t i = 0; i < sizeof...(Alternatives); i++) {
+    if(matches[i]) {
+      return i;
+    }
+  }
+  return sizeof...(Alternatives);
+}
+
+// index of alternative selected at runtime,
+// see ::flex_pimpl_plugin::CpuDispatchPimpl
+struct RuntimeIndex {
+  size_t value;
+};
+
+} // namespace pimpl
+
+// Storage used by PImpl if interface selects one of
+// several impls at runtime.
+// Impl is stored inline (like ::basis::FastPimpl),
+// storage is large enough for any alternative.
+// Generated forwarders dispatch on |index()| via switch,
+// so there is neither heap allocation nor virtual call.
+//
+/// \note |Alternatives| may be incomplete types at the point
+/// of declaration, but must be complete in the place where constructors
+/// and destructor of the interface are defined (usually .cc file).
+template <size_t Size, size_t Alignment, typename... Alternatives>
+class VariantPimpl {
+public:
+  static_assert(sizeof...(Alternatives) > 0,
+    "expected at least one alternative");
+  static_assert(sizeof...(Alternatives) < 255,
+    "index must fit into uint8_t");
+
+  template <size_t I>
+  using AlternativeAt
+    = std::tuple_element_t<I, std::tuple<Alternatives...>>;
+
+  // constructs first alternative
+  VariantPimpl()
+  {
+    construct<0>();
+  }
+
+  template <size_t I, typename... Args>
+  explicit VariantPimpl(std::in_place_index_t<I>, Args&&... args)
+  {
+    construct<I>(std::forward<Args>(args)...);
+  }
+
+  template <typename T, typename... Args>
+  explicit VariantPimpl(std::in_place_type_t<T>, Args&&... args)
+  {
+    construct<indexOf<T>()>(std::forward<Args>(args)...);
+  }
+
+  // every alternative must be constructible from |args|
+  template <typename... Args>
+  VariantPimpl(pimpl::RuntimeIndex index, Args&&... args)
+  {
+    constructAt(index.value, std::forward<Args>(args)...);
+  }
+
+  VariantPimpl(const VariantPimpl& other)
+  {
+    dispatch(other.index_, [this, &other](auto tag) {
+      constexpr size_t I = decltype(tag)::value;
+      construct<I>(other.template get<I>());
+    });
+  }
+
+  VariantPimpl(VariantPimpl&& other)
+    noexcept((std::is_nothrow_move_constructible<Alternatives>::value && ...))
+  {
+    dispatch(other.index_, [this, &other](auto tag) {
+      constexpr size_t I = decltype(tag)::value;
+      construct<I>(std::move(other.template get<I>()));
+    });
+  }
+
+  VariantPimpl& operator=(const VariantPimpl& other)
+  {
+    if(this != &other) {
+      dispatch(other.index_, [this, &other](auto tag) {
+        constexpr size_t I = decltype(tag)::value;
+        if(index_ == I) {
+          get<I>() = other.template get<I>();
+        } else {
+          emplace<I>(other.template get<I>());
+        }
+      });
+    }
+    return *this;
+  }
+
+  VariantPimpl& operator=(VariantPimpl&& other)
+    noexcept((std::is_nothrow_move_constructible<Alternatives>::value && ...)
+             && (std::is_nothrow_move_assignable<Alternatives>::value && ...))
+  {
+    if(this != &other) {
+      dispatch(other.index_, [this, &other](auto tag) {
+        constexpr size_t I = decltype(tag)::value;
+        if(index_ == I) {
+          get<I>() = std::move(other.template get<I>());
+        } else {
+          emplace<I>(std::move(other.template get<I>()));
+        }
+      });
+    }
+    return *this;
+  }
+
+  ~VariantPimpl()
+  {
+    validate();
+    destroy();
+  }
+
+  // index of stored alternative,
+  // used by generated forwarders
+  size_t index() const noexcept
+  {
+    DCHECK_NE(index_, kValueless)
+      << "constructor of alternative has thrown";
+    return index_;
+  }
+
+  template <typename T>
+  bool holds() const noexcept
+  {
+    return index_ == indexOf<T>();
+  }
+
+  /// \note does not check stored alternative in release builds,
+  /// caller must check |index()|
+  template <size_t I>
+  AlternativeAt<I>& get() noexcept
+  {
+    DCHECK_EQ(index_, I);
+    return *std::launder(reinterpret_cast<AlternativeAt<I>*>(&storage_));
+  }
+
+  template <size_t I>
+  const AlternativeAt<I>& get() const noexcept
+  {
+    DCHECK_EQ(index_, I);
+    return *std::launder(
+      reinterpret_cast<const AlternativeAt<I>*>(&storage_));
+  }
+
+  template <typename T>
+  T& get() noexcept
+  {
+    return get<indexOf<T>()>();
+  }
+
+  template <typename T>
+  const T& get() const noexcept
+  {
+    return get<indexOf<T>()>();
+  }
+
+  // Destroys stored alternative and constructs alternative |I|.
+  template <size_t I, typename... Args>
+  AlternativeAt<I>& emplace(Args&&... args)
+  {
+    destroy();
+    construct<I>(std::forward<Args>(args)...);
+    return get<I>();
+  }
+
+  template <typename T, typename... Args>
+  T& emplace(Args&&... args)
+  {
+    return emplace<indexOf<T>()>(std::forward<Args>(args)...);
+  }
+
+  // Destroys stored alternative and constructs alternative |index|,
+  // every alternative must be constructible from |args|.
+  template <typename... Args>
+  void emplace(pimpl::RuntimeIndex index, Args&&... args)
+  {
+    destroy();
+    constructAt(index.value, std::forward<Args>(args)...);
+  }
+
+private:
+  // set while alternative is being constructed,
+  // so failed constructor does not lead to double destruction
+  static constexpr uint8_t kValueless = 255;
+
+  template <typename T>
+  static constexpr size_t indexOf()
+  {
+    constexpr size_t index
+      = pimpl::alternativeIndex<T, Alternatives...>();
+    static_assert(index < sizeof...(Alternatives),
+      "type is not alternative of VariantPimpl");
+    return index;
+  }
+
+  static void validate() noexcept
+  {
+    static_assert(((Size >= sizeof(Alternatives)) && ...),
+      "invalid Size: Size >= sizeof(T) failed");
+    static_assert(((Alignment % alignof(Alternatives) == 0) && ...),
+      "invalid Alignment: Alignment % alignof(T) == 0 failed");
+  }
+
+  template <size_t I, typename... Args>
+  void construct(Args&&... args)
+  {
+    validate();
+    index_ = kValueless;
+    ::new (static_cast<void*>(&storage_))
+      AlternativeAt<I>(std::forward<Args>(args)...);
+    index_ = static_cast<uint8_t>(I);
+  }
+
+  template <typename... Args>
+  void constructAt(size_t index, Args&&... args)
+  {
+    DCHECK_LT(index, sizeof...(Alternatives));
+    dispatch(index, [&](auto tag) {
+      constexpr size_t I = decltype(tag)::value;
+      construct<I>(std::forward<Args>(args)...);
+    });
+  }
+
+  void destroy() noexcept
+  {
+    dispatch(index_, [this](auto tag) {
+      constexpr size_t I = decltype(tag)::value;
+      using T = AlternativeAt<I>;
+      get<I>().~T();
+    });
+    index_ = kValueless;
+  }
+
+  // calls |func| with std::integral_constant<size_t, index>,
+  // does nothing if |index| is |kValueless|
+  template <typename Func>
+  static void dispatch(size_t index, Func&& func)
+  {
+    dispatchImpl(
+      index
+      , std::forward<Func>(func)
+      , std::index_sequence_for<Alternatives...>{});
+  }
+
+  template <typename Func, size_t... Is>
+  static void dispatchImpl(
+    size_t index, Func&& func, std::index_sequence<Is...>)
+  {
+    ((index == Is
+      ? (func(std::integral_constant<size_t, Is>{}), true)
+      : false) || ...);
+  }
+
+private:
+  std::aligned_storage_t<Size, Alignment> storage_;
+
+  uint8_t index_ = kValueless;
+};
+
+} // namespace flex_pimpl_plugin
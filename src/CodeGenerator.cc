@@ -1,4 +1,5 @@
 #include "flex_pimpl_plugin/CodeGenerator.hpp" // IWYU pragma: associated
+#include "flex_pimpl_plugin/pimpl/MethodTable.hpp"
 
 #include <flexlib/reflect/ReflTypes.hpp>
 #include <flexlib/reflect/ReflectAST.hpp>
@@ -23,6 +24,8 @@
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/AST/ASTContext.h>
 #include <clang/Lex/Preprocessor.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/QualTypeNames.h>
 
 #include <base/cpu.h>
 #include <base/bind.h>
@@ -36,7 +39,9 @@
 #include <base/logging.h>
 #include <base/files/file_util.h>
 
+#include <algorithm>
 #include <any>
+#include <map>
 #include <string>
 #include <vector>
 #include <regex>
@@ -45,6 +50,448 @@
 
 namespace plugin {
 
+namespace {
+
+// user can mark impl as trivially relocatable
+static const char kTriviallyRelocatableAttr[]
+  = "pimpl_trivially_relocatable";
+
+// member typedef required by allocator-aware impl
+static const char kAllocatorTypeName[] = "allocator_type";
+
+static const char kGetAllocatorName[] = "get_allocator";
+
+static const char kPmrAllocatorTemplate[]
+  = "std::pmr::polymorphic_allocator";
+
+// limits recursion depth when checking types of fields
+static const int kMaxRelocatableCheckDepth = 16;
+
+// class templates that can be relocated via memcpy
+// if their template type arguments can be relocated via memcpy
+struct RelocatableTemplate {
+  const char* name;
+  // false if first argument is stored out-of-line,
+  // for example: `T` in std::vector<T>
+  bool checkFirstArg;
+  bool checkOtherArgs;
+};
+
+static const RelocatableTemplate kRelocatableStdTemplates[] = {
+  {"std::unique_ptr", false, true}
+  , {"std::shared_ptr", false, false}
+  , {"std::weak_ptr", false, false}
+  , {"std::default_delete", false, false}
+  , {"std::allocator", false, false}
+  , {"std::vector", false, true}
+  , {"std::pair", true, true}
+  , {"std::tuple", true, true}
+};
+
+// input: specialization of `std::__1::vector<int>`
+// output: "std::vector"
+std::string getTemplateName(
+  const clang::ClassTemplateSpecializationDecl* specialization)
+{
+  DCHECK(specialization);
+  std::string templateName
+    = specialization->getSpecializedTemplate()
+        ->getQualifiedNameAsString();
+  // libc++ uses `std::__1::` inline namespace
+  base::ReplaceSubstringsAfterOffset(
+    &templateName, 0, "::__1::", "::");
+  return templateName;
+}
+
+bool isTriviallyRelocatableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth);
+
+bool areMembersTriviallyRelocatable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth);
+
+bool isTriviallyRelocatableRecord(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  if(depth > kMaxRelocatableCheckDepth) {
+    return false;
+  }
+
+  record = record->getDefinition();
+  if(!record) {
+    // incomplete type
+    return false;
+  }
+
+  if(hasAnnotation(record, kTriviallyRelocatableAttr)) {
+    return true;
+  }
+
+  // std:: types may have user-provided move constructors,
+  // but known to be relocatable
+  if(const clang::ClassTemplateSpecializationDecl* specialization
+      = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(record))
+  {
+    const std::string templateName
+      = getTemplateName(specialization);
+    for(const RelocatableTemplate& known : kRelocatableStdTemplates) {
+      if(templateName != known.name) {
+        continue;
+      }
+      const clang::TemplateArgumentList& args
+        = specialization->getTemplateArgs();
+      for(unsigned i = 0; i < args.size(); i++) {
+        const bool needCheck
+          = i == 0 ? known.checkFirstArg : known.checkOtherArgs;
+        if(!needCheck) {
+          continue;
+        }
+        // std::tuple<T...> stores arguments as pack
+        llvm::ArrayRef<clang::TemplateArgument> packOrArg
+          = args[i].getKind() == clang::TemplateArgument::Pack
+            ? args[i].getPackAsArray()
+            : llvm::makeArrayRef(args[i]);
+        for(const clang::TemplateArgument& arg : packOrArg) {
+          if(arg.getKind() != clang::TemplateArgument::Type) {
+            continue;
+          }
+          if(!isTriviallyRelocatableType(
+                arg.getAsType(), context, depth + 1))
+          {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+  }
+
+  for(const clang::CXXConstructorDecl* ctor : record->ctors()) {
+    if((ctor->isCopyConstructor() || ctor->isMoveConstructor())
+       && ctor->isUserProvided())
+    {
+      // user-provided constructor may store |this|
+      return false;
+    }
+  }
+
+  return areMembersTriviallyRelocatable(record, context, depth);
+}
+
+bool areMembersTriviallyRelocatable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  if(record->getNumVBases() > 0) {
+    return false;
+  }
+
+  for(const clang::CXXBaseSpecifier& base : record->bases()) {
+    if(!isTriviallyRelocatableType(
+          base.getType(), context, depth + 1))
+    {
+      return false;
+    }
+  }
+
+  for(const clang::FieldDecl* field : record->fields()) {
+    if(!isTriviallyRelocatableType(
+          field->getType(), context, depth + 1))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool isTriviallyRelocatableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth)
+{
+  if(type.isNull()) {
+    return false;
+  }
+
+  // reference stored in class behaves like pointer
+  if(type->isReferenceType()) {
+    return true;
+  }
+
+  type = context.getBaseElementType(type).getCanonicalType();
+
+  if(type.isTriviallyCopyableType(context)) {
+    return true;
+  }
+
+  if(const clang::CXXRecordDecl* record
+      = type->getAsCXXRecordDecl())
+  {
+    return isTriviallyRelocatableRecord(record, context, depth);
+  }
+
+  return false;
+}
+
+bool isNothrowMovableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth);
+
+bool areMembersNothrowMovable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth);
+
+// |method| is move constructor or move assignment operator
+bool isNothrowSpecialMember(
+  const clang::CXXMethodDecl* method
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(method);
+
+  if(method->isDeleted()) {
+    return false;
+  }
+
+  const clang::FunctionProtoType* proto
+    = method->getType()->getAs<clang::FunctionProtoType>();
+  if(!proto) {
+    return false;
+  }
+
+  if(!clang::isUnresolvedExceptionSpec(proto->getExceptionSpecType())) {
+    return proto->isNothrow();
+  }
+
+  // exception specification of defaulted member is computed lazily,
+  // it is non-throwing if same members of bases and fields are
+  if(method->isDefaulted()) {
+    return areMembersNothrowMovable(method->getParent(), context, depth);
+  }
+
+  return false;
+}
+
+bool isNothrowMovableRecord(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  if(depth > kMaxRelocatableCheckDepth) {
+    return false;
+  }
+
+  record = record->getDefinition();
+  if(!record) {
+    // incomplete type
+    return false;
+  }
+
+  const clang::CXXMethodDecl* moveConstructor = nullptr;
+  for(const clang::CXXConstructorDecl* ctor : record->ctors()) {
+    if(ctor->isMoveConstructor()) {
+      moveConstructor = ctor;
+    }
+  }
+
+  const clang::CXXMethodDecl* moveAssignment = nullptr;
+  for(const clang::CXXMethodDecl* method : record->methods()) {
+    if(method->isMoveAssignmentOperator()) {
+      moveAssignment = method;
+    }
+  }
+
+  // if move operation is not declared and will not be declared
+  // implicitly, then copy operation is used (assume it may throw)
+  const bool isConstructorNothrow
+    = moveConstructor
+      ? isNothrowSpecialMember(moveConstructor, context, depth)
+      : record->needsImplicitMoveConstructor()
+        && areMembersNothrowMovable(record, context, depth);
+
+  const bool isAssignmentNothrow
+    = moveAssignment
+      ? isNothrowSpecialMember(moveAssignment, context, depth)
+      : record->needsImplicitMoveAssignment()
+        && areMembersNothrowMovable(record, context, depth);
+
+  return isConstructorNothrow && isAssignmentNothrow;
+}
+
+bool areMembersNothrowMovable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  for(const clang::CXXBaseSpecifier& base : record->bases()) {
+    if(!isNothrowMovableType(base.getType(), context, depth + 1)) {
+      return false;
+    }
+  }
+
+  for(const clang::FieldDecl* field : record->fields()) {
+    // move assignment of class with such fields is deleted
+    if(field->getType()->isReferenceType()
+       || field->getType().isConstQualified())
+    {
+      return false;
+    }
+    if(!isNothrowMovableType(field->getType(), context, depth + 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool isNothrowMovableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth)
+{
+  if(type.isNull() || type->isReferenceType()) {
+    return false;
+  }
+
+  type = context.getBaseElementType(type).getCanonicalType();
+
+  if(type.isTriviallyCopyableType(context)) {
+    return true;
+  }
+
+  if(const clang::CXXRecordDecl* record
+      = type->getAsCXXRecordDecl())
+  {
+    return isNothrowMovableRecord(record, context, depth);
+  }
+
+  return false;
+}
+
+bool isCopyableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth);
+
+bool areMembersCopyable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  for(const clang::CXXBaseSpecifier& base : record->bases()) {
+    if(!isCopyableType(base.getType(), context, depth + 1)) {
+      return false;
+    }
+  }
+
+  for(const clang::FieldDecl* field : record->fields()) {
+    // copy assignment of class with such fields is deleted
+    if(field->getType()->isReferenceType()
+       || field->getType().isConstQualified())
+    {
+      return false;
+    }
+    if(!isCopyableType(field->getType(), context, depth + 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool isCopyableRecord(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context
+  , int depth)
+{
+  DCHECK(record);
+
+  if(depth > kMaxRelocatableCheckDepth) {
+    return false;
+  }
+
+  record = record->getDefinition();
+  if(!record) {
+    // incomplete type
+    return false;
+  }
+
+  const clang::CXXMethodDecl* copyConstructor = nullptr;
+  for(const clang::CXXConstructorDecl* ctor : record->ctors()) {
+    if(ctor->isCopyConstructor()) {
+      copyConstructor = ctor;
+    }
+  }
+
+  const clang::CXXMethodDecl* copyAssignment = nullptr;
+  for(const clang::CXXMethodDecl* method : record->methods()) {
+    if(method->isCopyAssignmentOperator()) {
+      copyAssignment = method;
+    }
+  }
+
+  if(copyConstructor && copyAssignment) {
+    return !copyConstructor->isDeleted() && !copyAssignment->isDeleted();
+  }
+
+  // implicit copy operations are deleted
+  // if class declares move operations
+  if(record->hasUserDeclaredMoveConstructor()
+     || record->hasUserDeclaredMoveAssignment())
+  {
+    return false;
+  }
+
+  return (!copyConstructor || !copyConstructor->isDeleted())
+    && (!copyAssignment || !copyAssignment->isDeleted())
+    && areMembersCopyable(record, context, depth);
+}
+
+bool isCopyableType(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth)
+{
+  if(type.isNull() || type->isReferenceType()) {
+    return false;
+  }
+
+  type = context.getBaseElementType(type).getCanonicalType();
+
+  if(type.isTriviallyCopyableType(context)) {
+    return true;
+  }
+
+  if(const clang::CXXRecordDecl* record
+      = type->getAsCXXRecordDecl())
+  {
+    return isCopyableRecord(record, context, depth);
+  }
+
+  return false;
+}
+
+} // namespace
+
 /// \todo move to flexlib, remove code duplication in multiple plugins
 std::string expandTemplateNames(
   const std::vector<reflection::TemplateParamInfo>& params)
@@ -78,6 +525,2956 @@ std::string methodParamDecls(
   return out;
 }
 
+std::string printInlinePimplStorageType(
+  const std::string& implType
+  , uint64_t typeSize
+  , unsigned typeAlignment)
+{
+  std::string out;
+
+  out += "::basis::FastPimpl<";
+  out += "\n";
+
+  // usually it is "FooImpl"
+  DCHECK(!implType.empty());
+  out += implType;
+
+  // sizeof(Foo::FooImpl)
+  out += "\n";
+  out += ", /*Size*/";
+  out += std::to_string(typeSize);
+
+  // alignof(Foo::FooImpl)
+  out += "\n";
+  out += ", /*Alignment*/";
+  out += std::to_string(typeAlignment);
+
+  out += "\n";
+  out += ", ::basis::pimpl::SizePolicy::AtLeast";
+
+  out += "\n";
+  out += ", ::basis::pimpl::AlignPolicy::AtLeast";
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printPoolPimplStorageType(
+  const std::string& implType)
+{
+  std::string out;
+
+  out += "::flex_pimpl_plugin::PoolPimpl<";
+  out += "\n";
+
+  // usually it is "FooImpl"
+  DCHECK(!implType.empty());
+  out += implType;
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printLazyPimplStorageType(
+  const std::string& implType
+  , uint64_t typeSize
+  , unsigned typeAlignment)
+{
+  std::string out;
+
+  out += "::flex_pimpl_plugin::LazyPimpl<";
+  out += "\n";
+
+  // usually it is "FooImpl"
+  DCHECK(!implType.empty());
+  out += implType;
+
+  // sizeof(Foo::FooImpl)
+  out += "\n";
+  out += ", /*Size*/";
+  out += std::to_string(typeSize);
+
+  // alignof(Foo::FooImpl)
+  out += "\n";
+  out += ", /*Alignment*/";
+  out += std::to_string(typeAlignment);
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printVariantPimplStorageType(
+  const std::vector<std::string>& implTypes
+  , uint64_t typeSize
+  , unsigned typeAlignment)
+{
+  std::string out;
+
+  out += "::flex_pimpl_plugin::VariantPimpl<";
+
+  // max. sizeof of alternatives
+  out += "\n";
+  out += "/*Size*/";
+  out += std::to_string(typeSize);
+
+  // max. alignof of alternatives
+  out += "\n";
+  out += ", /*Alignment*/";
+  out += std::to_string(typeAlignment);
+
+  // usually it is "FooImpl"
+  DCHECK(!implTypes.empty());
+  for(const std::string& implType : implTypes) {
+    DCHECK(!implType.empty());
+    out += "\n";
+    out += ", ";
+    out += implType;
+  }
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printCpuDispatchPimplStorageType(
+  const std::vector<std::string>& implTypes
+  , const std::vector<std::string>& cpuFeatures
+  , uint64_t typeSize
+  , unsigned typeAlignment)
+{
+  DCHECK(!implTypes.empty());
+  DCHECK_EQ(implTypes.size(), cpuFeatures.size());
+
+  std::string out;
+
+  out += "::flex_pimpl_plugin::CpuDispatchPimpl<";
+
+  // required features of each alternative
+  out += "\n";
+  out += "::flex_pimpl_plugin::pimpl::CpuFeatureList<";
+  for(size_t i = 0; i < cpuFeatures.size(); i++) {
+    DCHECK(!cpuFeatures[i].empty());
+    out += "\n";
+    out += i ? ", " : "";
+    out += cpuFeatures[i];
+  }
+  out += ">";
+
+  // max. sizeof of alternatives
+  out += "\n";
+  out += ", /*Size*/";
+  out += std::to_string(typeSize);
+
+  // max. alignof of alternatives
+  out += "\n";
+  out += ", /*Alignment*/";
+  out += std::to_string(typeAlignment);
+
+  for(const std::string& implType : implTypes) {
+    DCHECK(!implType.empty());
+    out += "\n";
+    out += ", ";
+    out += implType;
+  }
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printCpuFeatures(
+  const std::vector<std::string>& isaNames)
+{
+  // ISA name used by `isa_N` and name of enumerator
+  // in ::flex_pimpl_plugin::pimpl::CpuFeature
+  static const std::map<std::string, std::string> kCpuFeatures{
+    {"sse3", "kCpuSse3"}
+    , {"ssse3", "kCpuSsse3"}
+    , {"sse41", "kCpuSse41"}
+    , {"sse42", "kCpuSse42"}
+    , {"popcnt", "kCpuPopcnt"}
+    , {"avx", "kCpuAvx"}
+    , {"avx2", "kCpuAvx2"}
+    , {"aesni", "kCpuAesni"}
+    , {"avx512f", "kCpuAvx512f"}
+  };
+
+  if(isaNames.empty()) {
+    return "::flex_pimpl_plugin::pimpl::kCpuBaseline";
+  }
+
+  std::string out;
+  for(const std::string& isaName : isaNames) {
+    auto it = kCpuFeatures.find(isaName);
+    CHECK(it != kCpuFeatures.end())
+      << "(pimpl) unknown ISA extension: "
+      << isaName;
+    out += out.empty() ? "" : " | ";
+    out += "::flex_pimpl_plugin::pimpl::";
+    out += it->second;
+  }
+  return out;
+}
+
+std::string printCpuDispatchDecl()
+{
+  return "struct ImplDispatch;";
+}
+
+namespace {
+
+// global qualification is not allowed in class head,
+// also `const ::Foo::ImplDispatch ::Foo::...` would be parsed
+// as single qualified name
+std::string printNestedScope(
+  const std::string& interfaceType)
+{
+  return base::StartsWith(interfaceType, "::", base::CompareCase::SENSITIVE)
+    ? interfaceType.substr(2)
+    : interfaceType;
+}
+
+// example: `const ::Foo& self, int arg1`
+std::string printDispatchEntryParams(
+  const std::string& interfaceType
+  , const PimplDispatchEntry& entry)
+{
+  std::string out;
+  out += entry.isConst ? "const " : "";
+  out += interfaceType;
+  out += "& self";
+  if(!entry.paramDecls.empty()) {
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += entry.paramDecls;
+  }
+  return out;
+}
+
+// example: `  int (*foo)(const ::Foo& self, int arg1);`
+std::string printDispatchEntryPointers(
+  const std::string& interfaceType
+  , const std::vector<PimplDispatchEntry>& entries)
+{
+  std::string out;
+  for(const PimplDispatchEntry& entry : entries) {
+    out += "  ";
+    out += entry.returnType;
+    out += " (*";
+    out += entry.name;
+    out += ")(";
+    out += printDispatchEntryParams(interfaceType, entry);
+    out += ");";
+    out += "\n";
+  }
+  return out;
+}
+
+// lambda that is converted to function pointer,
+// |body| is statement that uses `self`
+std::string printDispatchEntryLambda(
+  const std::string& interfaceType
+  , const PimplDispatchEntry& entry
+  , const std::string& body)
+{
+  std::string out;
+  out += "[](";
+  out += printDispatchEntryParams(interfaceType, entry);
+  out += ") -> ";
+  out += entry.returnType;
+  out += " {";
+  out += "\n";
+  out += body;
+  out += "\n";
+  out += "    }";
+  out += "\n";
+  return out;
+}
+
+// example: `  return ImplTable::current.get().foo(*this, arg1);`
+std::string printDispatchEntryCall(
+  const std::string& table
+  , const std::string& entryName
+  , const std::string& forwardedParams)
+{
+  DCHECK(!entryName.empty());
+
+  std::string out;
+  out += " return ";
+  out += table;
+  out += ".";
+  out += entryName;
+  out += "(*this";
+  if(!forwardedParams.empty()) {
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += forwardedParams;
+  }
+  out += ");";
+  return out;
+}
+
+// FNV-1a, used to detect changes of layout or signatures
+uint64_t hashLayoutString(const std::string& value)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for(const char c : value) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+std::string printCpuDispatchTable(
+  const std::string& interfaceType
+  , size_t alternativesCount
+  , const std::vector<PimplDispatchEntry>& entries)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK_GT(alternativesCount, 0u);
+
+  const std::string tableSize = std::to_string(alternativesCount);
+  const std::string scope = printNestedScope(interfaceType);
+
+  std::string out;
+
+  out += "struct ";
+  out += scope;
+  out += "::ImplDispatch {";
+  out += "\n";
+  // indexed by `impl_.index()`
+  out += "  static const ImplDispatch kTables[";
+  out += tableSize;
+  out += "];";
+  out += "\n";
+  out += printDispatchEntryPointers(interfaceType, entries);
+  out += "};";
+  out += "\n";
+
+  // nested struct has access to `impl_` of interface,
+  // so lambdas can be converted to function pointers
+  out += "const ";
+  out += scope;
+  out += "::ImplDispatch ";
+  out += scope;
+  out += "::ImplDispatch::kTables[";
+  out += tableSize;
+  out += "] = {";
+  out += "\n";
+  for(size_t i = 0; i < alternativesCount; i++) {
+    out += i ? "  , {" : "  {";
+    out += "\n";
+    for(size_t j = 0; j < entries.size(); j++) {
+      out += j ? "    , " : "    ";
+      out += printDispatchEntryLambda(
+        interfaceType
+        , entries[j]
+        , "      return self.impl_.get<"
+          + std::to_string(i)
+          + ">()."
+          + entries[j].methodCall
+          + ";");
+    }
+    out += "  }";
+    out += "\n";
+  }
+  out += "};";
+  out += "\n";
+
+  return out;
+}
+
+std::string printCpuDispatchCall(
+  const std::string& entryName
+  , const std::string& forwardedParams)
+{
+  return printDispatchEntryCall(
+    "ImplDispatch::kTables[impl_.index()]"
+    , entryName
+    , forwardedParams);
+}
+
+std::string printHotSwapDecls()
+{
+  std::string out;
+  out += "// forwarders call impl via table that can be replaced";
+  out += "\n";
+  out += "// at runtime, see `hot_swap` of `_injectPimplMethodCalls`";
+  out += "\n";
+  out += "struct ImplTable;";
+  out += "\n";
+  out += "// table of impl compiled into this binary";
+  out += "\n";
+  out += "static const ImplTable* builtinImplTable() noexcept;";
+  out += "\n";
+  out += "// returns false if layout of impl or methods differ";
+  out += "\n";
+  out += "static bool swapImplTable(const ImplTable* table);";
+  out += "\n";
+  return out;
+}
+
+std::string printHotSwapTable(
+  const std::string& interfaceType
+  , const std::string& implType
+  , PimplStorageKind storageKind
+  , size_t alternativesCount
+  , const std::string& fieldsSignature
+  , const std::vector<PimplDispatchEntry>& entries)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!implType.empty());
+
+  const std::string scope = printNestedScope(interfaceType);
+
+  // methods of new build must match methods of interface
+  std::string methodsSignature;
+  for(const PimplDispatchEntry& entry : entries) {
+    methodsSignature += entry.returnType;
+    methodsSignature += " ";
+    methodsSignature += entry.name;
+    methodsSignature += "(";
+    methodsSignature += entry.paramDecls;
+    methodsSignature += entry.isConst ? ") const;" : ");";
+  }
+
+  std::string out;
+
+  out += "struct ";
+  out += scope;
+  out += "::ImplTable {";
+  out += "\n";
+  out += "  static const ImplTable kBuiltin;";
+  out += "\n";
+  out += "  static ::flex_pimpl_plugin::pimpl::HotSwapSlot<ImplTable> current;";
+  out += "\n";
+  out += "  ::flex_pimpl_plugin::pimpl::ImplLayout layout;";
+  out += "\n";
+  out += printDispatchEntryPointers(interfaceType, entries);
+  out += "};";
+  out += "\n";
+
+  // constant initialization, so forwarders can be called
+  // during initialization of other globals
+  out += "const ";
+  out += scope;
+  out += "::ImplTable ";
+  out += scope;
+  out += "::ImplTable::kBuiltin = {";
+  out += "\n";
+  out += "  ::flex_pimpl_plugin::pimpl::ImplLayout{";
+  out += "\n";
+  out += "    sizeof(";
+  out += implType;
+  out += ")";
+  out += "\n";
+  out += "    , alignof(";
+  out += implType;
+  out += ")";
+  out += "\n";
+  out += "    , /*fieldsHash*/ ";
+  out += std::to_string(hashLayoutString(fieldsSignature));
+  out += "ull";
+  out += "\n";
+  out += "    , /*methodsHash*/ ";
+  out += std::to_string(hashLayoutString(methodsSignature));
+  out += "ull";
+  out += "\n";
+  out += "  }";
+  out += "\n";
+  for(const PimplDispatchEntry& entry : entries) {
+    out += "  , ";
+    out += printDispatchEntryLambda(
+      interfaceType
+      , entry
+      , printForwarderBody(
+          storageKind
+          , entry.isConst
+          , alternativesCount
+          , "self."
+          , entry.methodCall));
+  }
+  out += "};";
+  out += "\n";
+
+  out += "::flex_pimpl_plugin::pimpl::HotSwapSlot<";
+  out += scope;
+  out += "::ImplTable>";
+  out += "\n";
+  out += "  ";
+  out += scope;
+  out += "::ImplTable::current{&";
+  out += scope;
+  out += "::ImplTable::kBuiltin};";
+  out += "\n";
+
+  out += "const ";
+  out += interfaceType;
+  out += "::ImplTable* ";
+  out += interfaceType;
+  out += "::builtinImplTable() noexcept";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " return &ImplTable::kBuiltin;";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  out += "bool ";
+  out += interfaceType;
+  out += "::swapImplTable(const ImplTable* table)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " return ImplTable::current.swap(table);";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  return out;
+}
+
+std::string printHotSwapCall(
+  const std::string& entryName
+  , const std::string& forwardedParams)
+{
+  return printDispatchEntryCall(
+    "ImplTable::current.get()"
+    , entryName
+    , forwardedParams);
+}
+
+std::string printMethodTableDecl()
+{
+  std::string out;
+  out += "// type-erased call of forwarder by name,";
+  out += "\n";
+  out += "// returns nullptr if there is no such method";
+  out += "\n";
+  out += "static const ::flex_pimpl_plugin::pimpl::MethodEntry*";
+  out += "\n";
+  out += "  findMethod(::std::string_view name) noexcept;";
+  out += "\n";
+  return out;
+}
+
+std::string printMethodTableDef(
+  const std::string& interfaceType
+  , const std::vector<PimplNamedMethod>& methods)
+{
+  DCHECK(!interfaceType.empty());
+
+  // max. number of seeds tried for each size of table
+  static const uint64_t kMaxSeeds = 1024;
+
+  // search for smallest table where names do not collide,
+  // table twice larger than number of methods is found quickly
+  size_t tableSize = methods.size();
+  uint64_t seed = 0;
+  std::vector<size_t> slots(methods.size());
+  auto isPerfectHash = [&methods, &slots](
+    size_t candidateSize, uint64_t candidateSeed)
+  {
+    std::vector<bool> used(candidateSize);
+    for(size_t i = 0; i < methods.size(); i++) {
+      slots[i]
+        = ::flex_pimpl_plugin::pimpl::methodNameHash(
+            methods[i].name, candidateSeed) % candidateSize;
+      if(used[slots[i]]) {
+        return false;
+      }
+      used[slots[i]] = true;
+    }
+    return true;
+  };
+  while(!methods.empty() && !isPerfectHash(tableSize, seed)) {
+    seed++;
+    if(seed == kMaxSeeds) {
+      seed = 0;
+      tableSize++;
+    }
+  }
+
+  std::vector<const PimplNamedMethod*> table(tableSize);
+  for(size_t i = 0; i < methods.size(); i++) {
+    table[slots[i]] = &methods[i];
+  }
+
+  std::string out;
+
+  out += "const ::flex_pimpl_plugin::pimpl::MethodEntry*";
+  out += "\n";
+  out += "  ";
+  out += interfaceType;
+  out += "::findMethod(::std::string_view name) noexcept";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " static constexpr ::std::array<";
+  out += "\n";
+  out += "   ::flex_pimpl_plugin::pimpl::MethodEntry, ";
+  out += std::to_string(tableSize);
+  out += "> kMethods{{";
+  out += "\n";
+  for(size_t i = 0; i < table.size(); i++) {
+    out += i ? "  , " : "  ";
+    const PimplNamedMethod* method = table[i];
+    if(!method) {
+      // empty slot
+      out += "{}";
+      out += "\n";
+      continue;
+    }
+    out += "{\"";
+    out += method->name;
+    out += "\"";
+    out += "\n";
+    // unused parameters are not named
+    out += "  , [](void* object, void* const*";
+    out += method->arity ? " args" : "";
+    out += ", void*";
+    out += method->resultType.empty() ? "" : " result";
+    out += ") {";
+    out += "\n";
+    std::string call;
+    call += "static_cast<";
+    call += method->isConst ? "const " : "";
+    call += interfaceType;
+    call += "*>(object)->";
+    call += method->name;
+    call += "(";
+    call += method->invokerArgs;
+    call += ")";
+    if(method->resultType.empty()) {
+      out += "     ";
+      out += call;
+      out += ";";
+    } else {
+      out += "     ::new (result) ";
+      out += method->resultType;
+      out += "(";
+      out += call;
+      out += ");";
+    }
+    out += "\n";
+    out += "    }";
+    out += "\n";
+    out += "  , ";
+    out += std::to_string(method->arity);
+    out += ", ";
+    out += method->isConst ? "true" : "false";
+    out += "}";
+    out += "\n";
+  }
+  out += " }};";
+  out += "\n";
+  out += " return ::flex_pimpl_plugin::pimpl::findMethodEntry(";
+  out += "\n";
+  out += "   kMethods, /*seed*/ ";
+  out += std::to_string(seed);
+  out += ", name);";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  return out;
+}
+
+namespace {
+
+// example: `size_t example_interface_Foo_name(
+//   const example_interface_Foo* self, char* out_data, size_t out_capacity)`
+std::string printCApiPrototype(
+  const PimplCApiFunction& function
+  , const std::string& handleType)
+{
+  const PimplCApiSignature& signature = function.signature;
+  const bool isConstructor = function.methodName.empty();
+
+  std::string out;
+
+  if(isConstructor) {
+    out += handleType;
+    out += "*";
+  } else {
+    switch(signature.result) {
+      case PimplCApiResult::kVoid:
+        out += "void";
+        break;
+      case PimplCApiResult::kScalar:
+        out += signature.resultType;
+        break;
+      case PimplCApiResult::kStringView:
+        out += "flex_pimpl_string_view";
+        break;
+      case PimplCApiResult::kStringCopy:
+        // full size of result
+        out += "size_t";
+        break;
+    }
+  }
+  out += " ";
+  out += function.name;
+  out += "(";
+
+  std::vector<std::string> params;
+  if(!isConstructor) {
+    params.push_back(
+      (function.isConst ? "const " : "")
+      + handleType
+      + "* self");
+  }
+  if(!signature.paramDecls.empty()) {
+    params.push_back(signature.paramDecls);
+  }
+  if(signature.result == PimplCApiResult::kStringCopy) {
+    params.push_back("char* out_data, size_t out_capacity");
+  }
+  out += params.empty()
+    ? "void"
+    : base::JoinString(params, ", ");
+  out += ")";
+
+  return out;
+}
+
+} // namespace
+
+std::string printCApiPrefix(
+  const std::string& interfaceType)
+{
+  DCHECK(!interfaceType.empty());
+
+  std::string prefix = printNestedScope(interfaceType);
+  base::ReplaceSubstringsAfterOffset(&prefix, 0, "::", "_");
+  // template arguments, whitespace, etc.
+  for(char& c : prefix) {
+    if(!base::IsAsciiAlpha(c) && !base::IsAsciiDigit(c)) {
+      c = '_';
+    }
+  }
+  return prefix;
+}
+
+std::string printCApiHeader(
+  const std::string& interfaceType
+  , const std::vector<PimplCApiFunction>& functions)
+{
+  const std::string handleType = printCApiPrefix(interfaceType);
+
+  std::string out;
+
+  out += "// C facade of ";
+  out += interfaceType;
+  out += ",";
+  out += "\n";
+  out += "// generated by flex_pimpl_plugin, do not edit";
+  out += "\n";
+  out += "#pragma once";
+  out += "\n";
+  out += "\n";
+  out += "#include <flex_pimpl_plugin/pimpl/CApi.h>";
+  out += "\n";
+  out += "\n";
+  out += "#include <stdbool.h>";
+  out += "\n";
+  out += "#include <stddef.h>";
+  out += "\n";
+  out += "\n";
+  out += "#ifdef __cplusplus";
+  out += "\n";
+  out += "extern \"C\" {";
+  out += "\n";
+  out += "#endif";
+  out += "\n";
+  out += "\n";
+  out += "// opaque handle";
+  out += "\n";
+  out += "typedef struct ";
+  out += handleType;
+  out += " ";
+  out += handleType;
+  out += ";";
+  out += "\n";
+  out += "\n";
+  out += "void ";
+  out += handleType;
+  out += "_destroy(";
+  out += handleType;
+  out += "* self) FLEX_PIMPL_C_NOEXCEPT;";
+  out += "\n";
+  for(const PimplCApiFunction& function : functions) {
+    out += "\n";
+    out += printCApiPrototype(function, handleType);
+    out += " FLEX_PIMPL_C_NOEXCEPT;";
+    out += "\n";
+  }
+  out += "\n";
+  out += "#ifdef __cplusplus";
+  out += "\n";
+  out += "} // extern \"C\"";
+  out += "\n";
+  out += "#endif";
+  out += "\n";
+
+  return out;
+}
+
+std::string printCApiDefs(
+  const std::string& interfaceType
+  , const std::vector<std::string>& enclosingNamespaces
+  , const std::vector<PimplCApiFunction>& functions)
+{
+  const std::string prefix = printCApiPrefix(interfaceType);
+
+  std::string out;
+
+  // opaque struct of C header must be declared in global namespace,
+  // so namespaces of annotation are closed while facade is defined
+  for(auto it = enclosingNamespaces.rbegin()
+      ; it != enclosingNamespaces.rend()
+      ; ++it)
+  {
+    out += "} // namespace ";
+    out += *it;
+    out += "\n";
+  }
+  out += "\n";
+  out += "#include \"";
+  out += prefix;
+  out += "_c_api.h\"";
+  out += "\n";
+  out += "\n";
+  out += "extern \"C\" {";
+  out += "\n";
+  out += "\n";
+  out += "void ";
+  out += prefix;
+  out += "_destroy(";
+  out += prefix;
+  out += "* self) noexcept";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " delete reinterpret_cast<";
+  out += interfaceType;
+  out += "*>(self);";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  for(const PimplCApiFunction& function : functions) {
+    const PimplCApiSignature& signature = function.signature;
+    DCHECK(signature.isSupported);
+
+    // exception can not be passed to C caller,
+    // so it terminates program instead of undefined behavior
+    out += "\n";
+    out += printCApiPrototype(function, prefix);
+    out += " noexcept";
+    out += "\n";
+    out += "{";
+    out += "\n";
+
+    if(function.methodName.empty()) {
+      out += " return reinterpret_cast<";
+      out += prefix;
+      out += "*>(new ";
+      out += interfaceType;
+      out += "(";
+      out += signature.forwardedArgs;
+      out += "));";
+      out += "\n";
+      out += "}";
+      out += "\n";
+      continue;
+    }
+
+    // example: `reinterpret_cast<const Foo*>(self)->baz()`
+    std::string call;
+    call += "reinterpret_cast<";
+    call += function.isConst ? "const " : "";
+    call += interfaceType;
+    call += "*>(self)->";
+    call += function.methodName;
+    call += "(";
+    call += signature.forwardedArgs;
+    call += ")";
+
+    switch(signature.result) {
+      case PimplCApiResult::kVoid:
+        out += " ";
+        out += call;
+        out += ";";
+        break;
+      case PimplCApiResult::kScalar:
+        out += " return static_cast<";
+        out += signature.resultType;
+        out += ">(";
+        out += call;
+        out += ");";
+        break;
+      case PimplCApiResult::kStringView:
+        // string is owned by impl, not copied
+        out += " const auto& result = ";
+        out += call;
+        out += ";";
+        out += "\n";
+        out += " return flex_pimpl_string_view{result.data(), result.size()};";
+        break;
+      case PimplCApiResult::kStringCopy:
+        out += " return ::flex_pimpl_plugin::pimpl::copyToBuffer(";
+        out += "\n";
+        out += "   ";
+        out += call;
+        out += "\n";
+        out += "   , out_data, out_capacity);";
+        break;
+    }
+    out += "\n";
+    out += "}";
+    out += "\n";
+  }
+
+  out += "\n";
+  out += "} // extern \"C\"";
+  out += "\n";
+  out += "\n";
+  for(const std::string& name : enclosingNamespaces) {
+    out += "namespace ";
+    out += name;
+    out += name.empty() ? "{" : " {";
+    out += "\n";
+  }
+
+  return out;
+}
+
+std::string printVariantMethodCall(
+  size_t alternativesCount
+  , const std::string& implMember
+  , const std::string& methodCall)
+{
+  DCHECK(alternativesCount > 0);
+  DCHECK(!implMember.empty());
+  DCHECK(!methodCall.empty());
+
+  std::string out;
+
+  out += " switch(";
+  out += implMember;
+  out += ".index()) {";
+  out += "\n";
+  for(size_t i = 0; i < alternativesCount; i++) {
+    // last alternative handled by `default`,
+    // so compiler does not expect return after switch
+    out += i + 1 == alternativesCount
+      ? "  default: "
+      : "  case " + std::to_string(i) + ": ";
+    out += "return ";
+    out += implMember;
+    out += ".get<";
+    out += std::to_string(i);
+    out += ">().";
+    out += methodCall;
+    out += ";";
+    out += "\n";
+  }
+  out += " }";
+
+  return out;
+}
+
+std::string printCowPimplStorageType(
+  const std::string& implType)
+{
+  std::string out;
+
+  out += "::flex_pimpl_plugin::CowPimpl<";
+  out += "\n";
+
+  // usually it is "FooImpl"
+  DCHECK(!implType.empty());
+  out += implType;
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printRcuPimplStorageType(
+  const std::string& implType)
+{
+  std::string out;
+
+  out += "::flex_pimpl_plugin::RcuPimpl<";
+  out += "\n";
+
+  // usually it is "FooImpl"
+  DCHECK(!implType.empty());
+  out += implType;
+
+  out += "\n";
+  out += ">";
+
+  return out;
+}
+
+std::string printStorageMember(
+  const std::string& storageType)
+{
+  DCHECK(!storageType.empty());
+  return storageType + " impl_;";
+}
+
+std::string printForwarderBody(
+  PimplStorageKind storageKind
+  , bool isConstMethod
+  , size_t alternativesCount
+  , const std::string& object
+  , const std::string& methodCall)
+{
+  DCHECK(!methodCall.empty());
+
+  if(alternativesCount > 0) {
+    DCHECK(storageKind == PimplStorageKind::kVariant
+      // storage is not injected yet
+      || storageKind == PimplStorageKind::kInline);
+    return printVariantMethodCall(
+      alternativesCount + 1
+      , object + "impl_"
+      , methodCall);
+  }
+
+  std::string out;
+
+  out += " return ";
+  out += object;
+  // usually it is `impl_->`
+  out += printImplAccess(storageKind, isConstMethod);
+  out += methodCall;
+  out += ";";
+
+  return out;
+}
+
+std::string printStorageMemberInstantiations(
+  PimplStorageKind kind
+  , const std::string& storageType
+  , bool isCpuDispatch
+  , bool isCopyable
+  , bool isExternDecl)
+{
+  DCHECK(!storageType.empty());
+  DCHECK(kind != PimplStorageKind::kAuto);
+
+  // `::flex_pimpl_plugin::CpuDispatchPimpl<...>::Base`
+  const std::string instantiatedType
+    = isCpuDispatch
+      ? storageType + "::Base"
+      : storageType;
+
+  // name of constructor and destructor,
+  // `PoolPimpl` for `::flex_pimpl_plugin::PoolPimpl<::FooImpl>`
+  std::string className = "VariantPimpl";
+  if(!isCpuDispatch) {
+    const std::string templateName
+      = storageType.substr(0, storageType.find('<'));
+    const size_t scopeEnd = templateName.rfind("::");
+    className
+      = scopeEnd == std::string::npos
+        ? templateName
+        : templateName.substr(scopeEnd + 2);
+  }
+  DCHECK(!className.empty());
+
+  const std::string prefix
+    = isExternDecl ? "extern template " : "template ";
+
+  std::string out;
+
+  const bool hasConstructors
+    = kind != PimplStorageKind::kInline;
+
+  if(hasConstructors) {
+    out += prefix;
+    out += instantiatedType;
+    out += "::";
+    out += className;
+    out += "(";
+    out += instantiatedType;
+    out += "&&);";
+    out += "\n";
+  }
+
+  out += prefix;
+  out += instantiatedType;
+  out += "& ";
+  out += instantiatedType;
+  out += "::operator=(";
+  out += instantiatedType;
+  out += "&&);";
+  out += "\n";
+
+  if(isCopyable) {
+    if(hasConstructors) {
+      out += prefix;
+      out += instantiatedType;
+      out += "::";
+      out += className;
+      out += "(const ";
+      out += instantiatedType;
+      out += "&);";
+      out += "\n";
+    }
+
+    out += prefix;
+    out += instantiatedType;
+    out += "& ";
+    out += instantiatedType;
+    out += "::operator=(const ";
+    out += instantiatedType;
+    out += "&);";
+    out += "\n";
+  }
+
+  out += prefix;
+  out += instantiatedType;
+  out += "::~";
+  out += className;
+  out += "();";
+  out += "\n";
+
+  return out;
+}
+
+std::string substituteTemplateParams(
+  const std::string& type
+  , const std::vector<std::string>& paramNames
+  , const std::vector<std::string>& args
+  , const std::vector<bool>& isTypeParam)
+{
+  DCHECK_EQ(paramNames.size(), args.size());
+  DCHECK_EQ(paramNames.size(), isTypeParam.size());
+
+  auto isIdentifierChar = [](char c) {
+    return base::IsAsciiAlpha(c) || base::IsAsciiDigit(c) || c == '_';
+  };
+
+  std::string out;
+  size_t pos = 0;
+  while(pos < type.size()) {
+    if(!isIdentifierChar(type[pos])) {
+      out += type[pos++];
+      continue;
+    }
+    size_t end = pos;
+    while(end < type.size() && isIdentifierChar(type[end])) {
+      end++;
+    }
+    const std::string identifier = type.substr(pos, end - pos);
+    // `::Foo::T` is not parameter of template
+    const bool isQualified
+      = pos >= 2 && type.compare(pos - 2, 2, "::") == 0;
+    const auto it
+      = std::find(paramNames.begin(), paramNames.end(), identifier);
+    if(isQualified || it == paramNames.end()) {
+      out += identifier;
+    } else {
+      const size_t index = it - paramNames.begin();
+      out += isTypeParam[index]
+        ? "::std::enable_if_t<true, " + args[index] + ">"
+        : "(" + args[index] + ")";
+    }
+    pos = end;
+  }
+  return out;
+}
+
+std::string printMethodInstantiation(
+  const std::string& interfaceType
+  , const std::string& methodName
+  , const PimplMethodInstantiation& instantiation
+  , bool isExternDecl)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!instantiation.templateArgs.empty());
+
+  std::string out;
+  out += isExternDecl ? "extern template " : "template ";
+  out += instantiation.returnType;
+  out += " ";
+  // `R ::Foo::bar` would be parsed as `R::Foo::bar`
+  out += printNestedScope(interfaceType);
+  out += "::";
+  out += methodName;
+  out += "<";
+  out += instantiation.templateArgs;
+  out += ">";
+  out += instantiation.paramTypes;
+  out += instantiation.trailing;
+  out += ";";
+  return out;
+}
+
+std::string printStorageLayoutAsserts(
+  PimplStorageKind storageKind
+  , const std::vector<std::string>& implTypes
+  , uint64_t typeSize
+  , unsigned typeAlignment)
+{
+  switch(storageKind) {
+    case PimplStorageKind::kInline:
+    case PimplStorageKind::kLazy:
+    case PimplStorageKind::kVariant:
+      break;
+    // impl is allocated on heap
+    case PimplStorageKind::kPool:
+    case PimplStorageKind::kCow:
+    case PimplStorageKind::kRcu:
+      return "";
+    case PimplStorageKind::kAuto:
+      NOTREACHED();
+      return "";
+  }
+
+  DCHECK(typeSize > 0);
+  DCHECK(typeAlignment > 0);
+
+  std::string out;
+
+  for(const std::string& implType : implTypes) {
+    DCHECK(!implType.empty());
+
+    out += "static_assert(sizeof(";
+    out += implType;
+    out += ") <= ";
+    out += std::to_string(typeSize);
+    out += ", \"(pimpl) size of ";
+    out += implType;
+    out += " changed, regenerate code\");";
+    out += "\n";
+
+    out += "static_assert(";
+    out += std::to_string(typeAlignment);
+    out += " % alignof(";
+    out += implType;
+    out += ") == 0, \"(pimpl) alignment of ";
+    out += implType;
+    out += " changed, regenerate code\");";
+    out += "\n";
+  }
+
+  return out;
+}
+
+std::string printImplAccess(
+  PimplStorageKind storageKind
+  , bool isConstMethod)
+{
+  switch(storageKind) {
+    case PimplStorageKind::kInline:
+    case PimplStorageKind::kPool:
+      return "impl_->";
+    // `get()` constructs impl on first use
+    case PimplStorageKind::kLazy:
+      return "impl_.get().";
+    // `write()` clones impl if it is shared
+    case PimplStorageKind::kCow:
+      return isConstMethod
+        ? "impl_.read()."
+        : "impl_.write().";
+    // guards keep impl alive until end of full-expression,
+    // `write()` publishes modified clone of impl
+    case PimplStorageKind::kRcu:
+      return isConstMethod
+        ? "impl_.read()->"
+        : "impl_.write()->";
+    // forwarders use `printVariantMethodCall`
+    case PimplStorageKind::kVariant:
+    case PimplStorageKind::kAuto:
+      break;
+  }
+  NOTREACHED();
+  return "impl_->";
+}
+
+std::string printAccessSpecifier(
+  clang::AccessSpecifier access)
+{
+  switch(access) {
+    case clang::AS_public:
+      return "public:";
+    case clang::AS_protected:
+      return "protected:";
+    case clang::AS_private:
+      return "private:";
+    case clang::AS_none:
+      break;
+  }
+  return "";
+}
+
+bool hasAnnotation(
+  const clang::Decl* decl
+  , const std::string& annotation)
+{
+  DCHECK(decl);
+  for(const clang::AnnotateAttr* annotate
+        : decl->specific_attrs<clang::AnnotateAttr>())
+  {
+    const std::string annotationCode
+      = annotate->getAnnotation().str();
+    if(base::StartsWith(
+         annotationCode, annotation, base::CompareCase::SENSITIVE))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool isTriviallyRelocatableType(
+  clang::QualType type
+  , clang::ASTContext& context)
+{
+  return isTriviallyRelocatableType(type, context, 0);
+}
+
+bool areMembersTriviallyRelocatable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context)
+{
+  return areMembersTriviallyRelocatable(record, context, 0);
+}
+
+bool isNothrowMovableType(
+  clang::QualType type
+  , clang::ASTContext& context)
+{
+  return isNothrowMovableType(type, context, 0);
+}
+
+bool areMembersNothrowMovable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context)
+{
+  return areMembersNothrowMovable(record, context, 0);
+}
+
+namespace {
+
+// |name| is `basic_string` or `basic_string_view`
+bool isStdStringType(
+  clang::QualType type
+  , const char* name)
+{
+  const auto* specialization
+    = clang::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(
+        type->getAsCXXRecordDecl());
+  if(!specialization
+     || !specialization->isInStdNamespace()
+     || specialization->getName() != name)
+  {
+    return false;
+  }
+  const clang::TemplateArgumentList& args
+    = specialization->getTemplateArgs();
+  return args.size()
+    && args[0].getKind() == clang::TemplateArgument::Type
+    && args[0].getAsType()->isCharType();
+}
+
+// returns type of elements if |type| is `::base::span`,
+// otherwise returns null type
+clang::QualType getBaseSpanElementType(
+  clang::QualType type)
+{
+  const auto* specialization
+    = clang::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(
+        type->getAsCXXRecordDecl());
+  if(!specialization
+     || specialization->getQualifiedNameAsString() != "base::span")
+  {
+    return clang::QualType();
+  }
+  const clang::TemplateArgumentList& args
+    = specialization->getTemplateArgs();
+  return args.size()
+      && args[0].getKind() == clang::TemplateArgument::Type
+    ? args[0].getAsType()
+    : clang::QualType();
+}
+
+// C spelling of arithmetic type or of underlying type of enum,
+// empty if type has no C equivalent
+// example: `unsigned long`
+std::string printCScalarType(
+  clang::QualType type
+  , const clang::ASTContext& context)
+{
+  type = type.getCanonicalType().getUnqualifiedType();
+  if(const clang::EnumType* enumType = type->getAs<clang::EnumType>()) {
+    type = enumType->getDecl()->getIntegerType().getCanonicalType();
+  }
+  // `char16_t`, `char32_t`, `_Complex`, etc.
+  if(type.isNull()
+     || !type->isArithmeticType()
+     || type->isComplexType()
+     || (type->isAnyCharacterType()
+         && !type->isCharType()
+         && !type->isWideCharType()))
+  {
+    return std::string();
+  }
+  return type.getAsString(context.getPrintingPolicy());
+}
+
+// appends parameters of C facade that represent |param|,
+// returns false if |param| has no C equivalent
+bool appendCApiParam(
+  const clang::ParmVarDecl* param
+  , const std::string& name
+  , const clang::ASTContext& context
+  , PimplCApiSignature* signature)
+{
+  DCHECK(param);
+  DCHECK(signature);
+
+  const clang::QualType type = param->getType();
+  const clang::QualType valueType = type.getNonReferenceType();
+
+  // impl can modify argument
+  const bool isOutParam
+    = type->isLValueReferenceType()
+      && !valueType.isConstQualified();
+
+  std::string paramDecl;
+  std::string forwardedArg;
+
+  const std::string scalarType = printCScalarType(valueType, context);
+  const clang::QualType spanElementType = getBaseSpanElementType(valueType);
+  if(!scalarType.empty()) {
+    const bool isEnum = valueType->isEnumeralType();
+    if(isOutParam && isEnum) {
+      return false;
+    }
+    paramDecl = scalarType + (isOutParam ? "* " : " ") + name;
+    forwardedArg
+      = isOutParam
+        ? "*" + name
+        : isEnum
+          ? "static_cast<"
+            + printFullyQualifiedType(
+                valueType.getUnqualifiedType(), context)
+            + ">(" + name + ")"
+          // `int&&` can not bind to parameter of facade
+          : type->isRValueReferenceType()
+            ? "::std::move(" + name + ")"
+            : name;
+  } else if(isOutParam) {
+    return false;
+  } else if(isStdStringType(valueType, "basic_string_view")
+            || isStdStringType(valueType, "basic_string"))
+  {
+    paramDecl
+      = "const char* " + name + "_data, size_t " + name + "_size";
+    // `::std::string` is built only if impl requires it
+    forwardedArg
+      = (isStdStringType(valueType, "basic_string_view")
+          ? "::std::string_view("
+          : "::std::string(")
+        + name + "_data, " + name + "_size)";
+  } else if(!spanElementType.isNull()) {
+    const std::string elementType
+      = printCScalarType(spanElementType, context);
+    if(elementType.empty() || spanElementType->isEnumeralType()) {
+      return false;
+    }
+    paramDecl
+      = (spanElementType.isConstQualified() ? "const " : "")
+        + elementType
+        + "* " + name + "_data, size_t " + name + "_size";
+    forwardedArg
+      = printFullyQualifiedType(valueType.getUnqualifiedType(), context)
+        + "(" + name + "_data, " + name + "_size)";
+  } else {
+    return false;
+  }
+
+  if(!signature->paramDecls.empty()) {
+    signature->paramDecls += clang_utils::kSeparatorCommaAndWhitespace;
+    signature->forwardedArgs += clang_utils::kSeparatorCommaAndWhitespace;
+  }
+  signature->paramDecls += paramDecl;
+  signature->forwardedArgs += forwardedArg;
+  return true;
+}
+
+} // namespace
+
+PimplCApiSignature reflectCApiSignature(
+  const clang::FunctionDecl* function
+  , const clang::ASTContext& context)
+{
+  DCHECK(function);
+
+  PimplCApiSignature signature;
+
+  const auto* method = clang::dyn_cast<clang::CXXMethodDecl>(function);
+  const bool isConstructor = clang::isa<clang::CXXConstructorDecl>(function);
+  // operators and templates have no name in C
+  if(function->isVariadic()
+     || function->getDescribedFunctionTemplate()
+     || (method && method->isStatic())
+     || (!isConstructor && !function->getDeclName().isIdentifier()))
+  {
+    return signature;
+  }
+
+  for(const clang::ParmVarDecl* param : function->parameters()) {
+    const std::string name
+      = param->getName().empty()
+        ? "arg" + std::to_string(param->getFunctionScopeIndex())
+        : param->getNameAsString();
+    if(!appendCApiParam(param, name, context, &signature)) {
+      return PimplCApiSignature();
+    }
+  }
+
+  const clang::QualType returnType = function->getReturnType();
+  const clang::QualType resultType = returnType.getNonReferenceType();
+  if(isConstructor || returnType->isVoidType()) {
+    signature.result = PimplCApiResult::kVoid;
+  } else if(!printCScalarType(resultType, context).empty()) {
+    signature.result = PimplCApiResult::kScalar;
+    signature.resultType = printCScalarType(resultType, context);
+  } else if(isStdStringType(resultType, "basic_string_view")) {
+    signature.result = PimplCApiResult::kStringView;
+  } else if(isStdStringType(resultType, "basic_string")) {
+    // reference points to string owned by impl
+    signature.result
+      = returnType->isReferenceType()
+        ? PimplCApiResult::kStringView
+        : PimplCApiResult::kStringCopy;
+  } else {
+    return PimplCApiSignature();
+  }
+
+  signature.isSupported = true;
+  return signature;
+}
+
+bool isViewType(
+  clang::QualType type)
+{
+  type = type.getCanonicalType();
+  if(type->isReferenceType()
+     || type->isAnyPointerType()
+     || type->isMemberPointerType())
+  {
+    return true;
+  }
+
+  const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl();
+  if(!record) {
+    return false;
+  }
+  return (record->isInStdNamespace()
+          && (record->getName() == "basic_string_view"
+              || record->getName() == "span"))
+    || !getBaseSpanElementType(type).isNull()
+    || record->getQualifiedNameAsString() == "base::BasicStringPiece";
+}
+
+bool hasPointerMembers(
+  clang::QualType type
+  , clang::ASTContext& context
+  , int depth)
+{
+  if(depth > kMaxRelocatableCheckDepth) {
+    // unknown, so not safe to save
+    return true;
+  }
+
+  type = context.getBaseElementType(type.getCanonicalType());
+  if(type->isReferenceType()
+     || type->isAnyPointerType()
+     || type->isMemberPointerType()
+     || type->isNullPtrType())
+  {
+    return true;
+  }
+
+  const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl();
+  if(!record) {
+    return false;
+  }
+  record = record->getDefinition();
+  if(!record) {
+    // incomplete type
+    return true;
+  }
+
+  // fields of trivially copyable class are saved via memcpy
+  if(type.isTriviallyCopyableType(context)) {
+    for(const clang::CXXBaseSpecifier& base : record->bases()) {
+      if(hasPointerMembers(base.getType(), context, depth + 1)) {
+        return true;
+      }
+    }
+    for(const clang::FieldDecl* field : record->fields()) {
+      if(hasPointerMembers(field->getType(), context, depth + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // other classes are saved by specialization of `SnapshotTraits`
+  // that stores elements, not internal pointers of container
+  if(const clang::ClassTemplateSpecializationDecl* specialization
+      = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(record))
+  {
+    for(const clang::TemplateArgument& arg
+          : specialization->getTemplateArgs().asArray())
+    {
+      if(arg.getKind() == clang::TemplateArgument::Type
+         && hasPointerMembers(arg.getAsType(), context, depth + 1))
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool hasPointerMembers(
+  clang::QualType type
+  , clang::ASTContext& context)
+{
+  return hasPointerMembers(type, context, 0);
+}
+
+bool isCopyableType(
+  clang::QualType type
+  , clang::ASTContext& context)
+{
+  return isCopyableType(type, context, 0);
+}
+
+bool areMembersCopyable(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context)
+{
+  return areMembersCopyable(record, context, 0);
+}
+
+std::string printSpecialMemberDecls(
+  const std::string& interfaceName
+  , bool isNothrowMovable
+  , bool isCopyable)
+{
+  DCHECK(!interfaceName.empty());
+
+  const std::string noexceptSpec
+    = isNothrowMovable ? " noexcept" : "";
+
+  std::string out;
+  if(isCopyable) {
+    out += interfaceName;
+    out += "(const ";
+    out += interfaceName;
+    out += "& other);";
+    out += "\n";
+    out += interfaceName;
+    out += "& operator=(const ";
+    out += interfaceName;
+    out += "& other);";
+    out += "\n";
+  }
+  out += interfaceName;
+  out += "(";
+  out += interfaceName;
+  out += "&& other)";
+  out += noexceptSpec;
+  out += ";";
+  out += "\n";
+  out += interfaceName;
+  out += "& operator=(";
+  out += interfaceName;
+  out += "&& other)";
+  out += noexceptSpec;
+  out += ";";
+  out += "\n";
+  out += "void swap(";
+  out += interfaceName;
+  out += "& other)";
+  out += noexceptSpec;
+  out += ";";
+  out += "\n";
+  out += "friend void swap(";
+  out += interfaceName;
+  out += "& lhs, ";
+  out += interfaceName;
+  out += "& rhs)";
+  out += noexceptSpec;
+  out += " { lhs.swap(rhs); }";
+  out += "\n";
+  return out;
+}
+
+namespace {
+
+// copies and moves only impl under lock of other object,
+// mutex and caches of interface are not copied
+std::string printLockedSpecialMemberDefs(
+  const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::string& noexceptSpec
+  , bool isCopyable
+  , const std::string& memoInvalidation
+  , const std::string& otherMemoInvalidation)
+{
+  std::string out;
+  if(isCopyable) {
+    out += interfaceType;
+    out += "::";
+    out += interfaceName;
+    out += "(const ";
+    out += interfaceType;
+    out += "& other)";
+    out += "\n";
+    out += "  : impl_(::flex_pimpl_plugin::pimpl::copyLocked("
+           "other.impl_, other.implMutex_))";
+    out += "\n";
+    out += "{}";
+    out += "\n";
+    out += interfaceType;
+    out += "& ";
+    out += interfaceType;
+    out += "::operator=(const ";
+    out += interfaceType;
+    out += "& other)";
+    out += "\n";
+    out += "{";
+    out += "\n";
+    out += " if(this != &other) {";
+    out += "\n";
+    // locks both mutexes without deadlock
+    out += " ::std::scoped_lock implLock(implMutex_, other.implMutex_);";
+    out += "\n";
+    out += memoInvalidation;
+    out += " impl_ = other.impl_;";
+    out += "\n";
+    out += " }";
+    out += "\n";
+    out += " return *this;";
+    out += "\n";
+    out += "}";
+    out += "\n";
+  }
+  out += interfaceType;
+  out += "::";
+  out += interfaceName;
+  out += "(";
+  out += interfaceType;
+  out += "&& other)";
+  out += noexceptSpec;
+  out += "\n";
+  out += "  : impl_(::flex_pimpl_plugin::pimpl::moveLocked("
+         "other.impl_, other.implMutex_))";
+  out += "\n";
+  out += "{}";
+  out += "\n";
+  out += interfaceType;
+  out += "& ";
+  out += interfaceType;
+  out += "::operator=(";
+  out += interfaceType;
+  out += "&& other)";
+  out += noexceptSpec;
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " if(this != &other) {";
+  out += "\n";
+  out += " ::std::scoped_lock implLock(implMutex_, other.implMutex_);";
+  out += "\n";
+  out += memoInvalidation;
+  out += otherMemoInvalidation;
+  out += " impl_ = ::std::move(other.impl_);";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  out += " return *this;";
+  out += "\n";
+  out += "}";
+  out += "\n";
+  out += "void ";
+  out += interfaceType;
+  out += "::swap(";
+  out += interfaceType;
+  out += "& other)";
+  out += noexceptSpec;
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " if(this == &other) {";
+  out += "\n";
+  out += "  return;";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  out += " ::std::scoped_lock implLock(implMutex_, other.implMutex_);";
+  out += "\n";
+  out += memoInvalidation;
+  out += otherMemoInvalidation;
+  out += " using ::std::swap;";
+  out += "\n";
+  out += " swap(impl_, other.impl_);";
+  out += "\n";
+  out += "}";
+  out += "\n";
+  return out;
+}
+
+} // namespace
+
+std::string printSpecialMemberDefs(
+  const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::string& storageType
+  , bool isNothrowMovable
+  , bool isCopyable
+  , PimplLocking locking
+  , const std::string& memoInvalidation
+  , const std::string& otherMemoInvalidation)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!interfaceName.empty());
+  DCHECK(!storageType.empty());
+
+  const std::string noexceptSpec
+    = isNothrowMovable ? " noexcept" : "";
+
+  std::string out;
+  if(locking != PimplLocking::kNone) {
+    out += printLockedSpecialMemberDefs(
+      interfaceType
+      , interfaceName
+      , noexceptSpec
+      , isCopyable
+      , memoInvalidation
+      , otherMemoInvalidation);
+  } else {
+    if(isCopyable) {
+      out += interfaceType;
+      out += "::";
+      out += interfaceName;
+      out += "(const ";
+      out += interfaceType;
+      out += "& other) = default;";
+      out += "\n";
+      out += interfaceType;
+      out += "& ";
+      out += interfaceType;
+      out += "::operator=(const ";
+      out += interfaceType;
+      out += "& other) = default;";
+      out += "\n";
+    }
+    out += interfaceType;
+    out += "::";
+    out += interfaceName;
+    out += "(";
+    out += interfaceType;
+    out += "&& other)";
+    out += noexceptSpec;
+    out += " = default;";
+    out += "\n";
+    out += interfaceType;
+    out += "& ";
+    out += interfaceType;
+    out += "::operator=(";
+    out += interfaceType;
+    out += "&& other)";
+    out += noexceptSpec;
+    out += " = default;";
+    out += "\n";
+    // swaps all members of interface, not only impl
+    out += "void ";
+    out += interfaceType;
+    out += "::swap(";
+    out += interfaceType;
+    out += "& other)";
+    out += noexceptSpec;
+    out += "\n";
+    out += "{";
+    out += "\n";
+    out += " ";
+    out += interfaceType;
+    out += " tmp(::std::move(other));";
+    out += "\n";
+    out += " other = ::std::move(*this);";
+    out += "\n";
+    out += " *this = ::std::move(tmp);";
+    out += "\n";
+    out += "}";
+    out += "\n";
+  }
+  if(isNothrowMovable) {
+    // checks that impl is moved without exceptions,
+    // so `::std::vector<Foo>` moves elements on reallocation
+    out += "static_assert(::std::is_nothrow_move_constructible_v<";
+    out += storageType;
+    out += ">";
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += "\"(pimpl) move constructor of impl may throw\");";
+    out += "\n";
+    out += "static_assert(::std::is_nothrow_move_assignable_v<";
+    out += storageType;
+    out += ">";
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += "\"(pimpl) move assignment of impl may throw\");";
+    out += "\n";
+    out += "static_assert(::std::is_nothrow_move_constructible_v<";
+    out += interfaceType;
+    out += ">";
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += "\"(pimpl) move constructor of interface may throw\");";
+    out += "\n";
+  }
+  return out;
+}
+
+std::string printForwardedParam(
+  const clang::ParmVarDecl* param
+  , const clang::FunctionTemplateDecl* functionTemplate)
+{
+  DCHECK(param);
+
+  const std::string name = param->getNameAsString();
+  DCHECK(!name.empty());
+
+  clang::PrintingPolicy printingPolicy(
+    param->getASTContext().getLangOpts());
+
+  clang::QualType type = param->getType();
+
+  // `Args&&... args`
+  bool isPack = false;
+  if(const clang::PackExpansionType* packExpansion
+      = type->getAs<clang::PackExpansionType>())
+  {
+    type = packExpansion->getPattern();
+    isPack = true;
+  }
+
+  std::string out;
+
+  if(type->isRValueReferenceType()) {
+    const clang::QualType pointee = type.getNonReferenceType();
+    const clang::TemplateTypeParmType* templateParam
+      = pointee->getAs<clang::TemplateTypeParmType>();
+    // `T&&` where `T` is parameter of method template
+    const bool isForwardingReference
+      = functionTemplate
+        && templateParam
+        && !pointee.hasQualifiers()
+        && templateParam->getDepth()
+             == functionTemplate->getTemplateParameters()->getDepth();
+    if(isForwardingReference) {
+      out += "::std::forward<";
+      out += pointee.getAsString(printingPolicy);
+      out += ">(";
+      out += name;
+      out += ")";
+    } else {
+      out += "::std::move(";
+      out += name;
+      out += ")";
+    }
+  } else if(!type->isReferenceType()
+            && !type.isConstQualified()
+            && (type->isRecordType() || type->isDependentType()))
+  {
+    // parameter passed by value is owned by forwarder
+    out += "::std::move(";
+    out += name;
+    out += ")";
+  } else {
+    out += name;
+  }
+
+  if(isPack) {
+    out += "...";
+  }
+
+  return out;
+}
+
+std::string printMethodSignature(
+  const clang::FunctionDecl* decl)
+{
+  DCHECK(decl);
+
+  const clang::ASTContext& context = decl->getASTContext();
+  clang::PrintingPolicy printingPolicy(context.getLangOpts());
+
+  std::string out;
+
+  out += decl->getReturnType().getCanonicalType()
+           .getAsString(printingPolicy);
+  out += " ";
+  out += decl->getNameAsString();
+  out += "(";
+  for(unsigned i = 0; i < decl->getNumParams(); i++) {
+    if(i != 0) {
+      out += clang_utils::kSeparatorCommaAndWhitespace;
+    }
+    out += decl->getParamDecl(i)->getType().getCanonicalType()
+             .getAsString(printingPolicy);
+  }
+  out += ")";
+
+  if(const clang::CXXMethodDecl* methodDecl
+      = clang::dyn_cast<clang::CXXMethodDecl>(decl))
+  {
+    if(methodDecl->isConst()) {
+      out += " const";
+    }
+    switch(methodDecl->getRefQualifier()) {
+      case clang::RQ_LValue:
+        out += " &";
+        break;
+      case clang::RQ_RValue:
+        out += " &&";
+        break;
+      case clang::RQ_None:
+        break;
+    }
+  }
+
+  return out;
+}
+
+bool isPmrAllocatorAwareType(
+  const clang::CXXRecordDecl* record
+  , clang::ASTContext& context)
+{
+  DCHECK(record);
+
+  record = record->getDefinition();
+  if(!record) {
+    // incomplete type
+    return false;
+  }
+
+  // `using allocator_type = std::pmr::polymorphic_allocator<...>;`
+  clang::QualType allocatorType;
+  for(const clang::NamedDecl* found
+        : record->lookup(&context.Idents.get(kAllocatorTypeName)))
+  {
+    if(const clang::TypedefNameDecl* typedefDecl
+        = clang::dyn_cast<clang::TypedefNameDecl>(found))
+    {
+      allocatorType
+        = typedefDecl->getUnderlyingType().getCanonicalType();
+    }
+  }
+  if(allocatorType.isNull()) {
+    return false;
+  }
+
+  const clang::ClassTemplateSpecializationDecl* allocatorDecl
+    = clang::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(
+        allocatorType->getAsCXXRecordDecl());
+  if(!allocatorDecl
+     || getTemplateName(allocatorDecl) != kPmrAllocatorTemplate)
+  {
+    return false;
+  }
+
+  if(record->lookup(&context.Idents.get(kGetAllocatorName)).empty()) {
+    return false;
+  }
+
+  // constructor that can be called with single allocator argument,
+  // example: `explicit FooImpl(const allocator_type& alloc);`
+  for(const clang::CXXConstructorDecl* ctor : record->ctors()) {
+    if(ctor->getNumParams() == 0
+       || ctor->getMinRequiredArgs() > 1
+       || ctor->isDeleted())
+    {
+      continue;
+    }
+    const clang::QualType paramType
+      = ctor->getParamDecl(0)->getType()
+          .getNonReferenceType()
+          .getUnqualifiedType()
+          .getCanonicalType();
+    if(paramType == allocatorType) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string printPmrInterfaceDecls(
+  const std::string& interfaceName
+  , bool isCopyable)
+{
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+
+  out += "using allocator_type";
+  out += " = ::std::pmr::polymorphic_allocator<::std::byte>;";
+  out += "\n";
+
+  out += "explicit ";
+  out += interfaceName;
+  out += "(::std::pmr::memory_resource* resource);";
+  out += "\n";
+
+  out += interfaceName;
+  out += "(::std::allocator_arg_t, const allocator_type& alloc);";
+  out += "\n";
+
+  // used by containers that propagate allocator to elements,
+  // like `::std::pmr::vector<Foo>`
+  if(isCopyable) {
+    out += interfaceName;
+    out += "(::std::allocator_arg_t, const allocator_type& alloc";
+    out += ", const ";
+    out += interfaceName;
+    out += "& other);";
+    out += "\n";
+  }
+
+  out += interfaceName;
+  out += "(::std::allocator_arg_t, const allocator_type& alloc";
+  out += ", ";
+  out += interfaceName;
+  out += "&& other);";
+  out += "\n";
+
+  out += "allocator_type get_allocator() const noexcept;";
+
+  return out;
+}
+
+std::string printPmrInterfaceDefs(
+  const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::string& implAccess
+  , bool isCopyable
+  , PimplLocking locking)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+
+  // usually it is `::Foo::Foo`
+  const std::string ctorName
+    = interfaceType + "::" + interfaceName;
+
+  out += ctorName;
+  out += "(::std::pmr::memory_resource* resource)";
+  out += "\n";
+  out += "  : ";
+  out += interfaceName;
+  out += "(::std::allocator_arg, allocator_type(resource))";
+  out += "\n";
+  out += "{}";
+  out += "\n";
+
+  out += ctorName;
+  out += "(::std::allocator_arg_t, const allocator_type& alloc)";
+  out += "\n";
+  out += "  : impl_(alloc)";
+  out += "\n";
+  out += "{}";
+  out += "\n";
+
+  // impl of |other| may use other memory resource,
+  // so impl is assigned (not copied or moved) into impl
+  // that already uses |alloc|
+  if(isCopyable) {
+    out += ctorName;
+    out += "(::std::allocator_arg_t, const allocator_type& alloc";
+    out += ", const ";
+    out += interfaceName;
+    out += "& other)";
+    out += "\n";
+    out += "  : impl_(alloc)";
+    out += "\n";
+    out += "{";
+    out += "\n";
+    out += printForwarderLock(locking, true, "other.");
+    out += " *impl_ = *other.impl_;";
+    out += "\n";
+    out += "}";
+    out += "\n";
+  }
+
+  out += ctorName;
+  out += "(::std::allocator_arg_t, const allocator_type& alloc";
+  out += ", ";
+  out += interfaceName;
+  out += "&& other)";
+  out += "\n";
+  out += "  : impl_(alloc)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += printForwarderLock(locking, false, "other.");
+  out += " *impl_ = ::std::move(*other.impl_);";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  // trailing return type, because qualified return type
+  // followed by `::Foo::get_allocator` is parsed as single name
+  out += "auto ";
+  out += interfaceType;
+  out += "::get_allocator() const noexcept -> allocator_type";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " return allocator_type(";
+  out += implAccess;
+  out += "get_allocator());";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  return out;
+}
+
+std::string printFullyQualifiedType(
+  clang::QualType type
+  , const clang::ASTContext& context)
+{
+  clang::PrintingPolicy printingPolicy(context.getLangOpts());
+  printingPolicy.SuppressScope = false;
+  printingPolicy.FullyQualifiedName = true;
+
+  return clang::TypeName::getFullyQualifiedName(
+    type
+    , context
+    , printingPolicy
+    , true // WithGlobalNsPrefix
+  );
+}
+
+std::string printForwardingMutexMember(
+  PimplLocking locking)
+{
+  switch(locking) {
+    case PimplLocking::kExclusive:
+      return "mutable ::flex_pimpl_plugin::pimpl::ForwardingMutex<"
+             "::std::mutex> implMutex_;";
+    case PimplLocking::kShared:
+      return "mutable ::flex_pimpl_plugin::pimpl::ForwardingMutex<"
+             "::std::shared_mutex> implMutex_;";
+    case PimplLocking::kNone:
+      break;
+  }
+  return "";
+}
+
+std::string printSnapshotDecls(
+  const std::string& interfaceName)
+{
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+  out += "// binary snapshot of impl, see `snapshot`";
+  out += "\n";
+  out += "// of `_injectPimplMethodCalls`";
+  out += "\n";
+  out += "size_t snapshotSize() const;";
+  out += "\n";
+  out += "// |out| must have at least `snapshotSize()` bytes,";
+  out += "\n";
+  out += "// returns number of written bytes";
+  out += "\n";
+  out += "size_t snapshot(char* out) const;";
+  out += "\n";
+  out += "// reads at most |size| bytes, returns number of read bytes";
+  out += "\n";
+  out += "// or 0 if input is too short (impl may be partially restored)";
+  out += "\n";
+  out += "size_t restore(const char* in, size_t size);";
+  out += "\n";
+  out += "// snapshots of |objects| placed one after another";
+  out += "\n";
+  out += "static size_t snapshotSize(::base::span<const ";
+  out += interfaceName;
+  out += "> objects);";
+  out += "\n";
+  out += "static size_t snapshot(::base::span<const ";
+  out += interfaceName;
+  out += "> objects, char* out);";
+  out += "\n";
+  out += "static size_t restore(::base::span<";
+  out += interfaceName;
+  out += "> objects, const char* in, size_t size);";
+  out += "\n";
+  return out;
+}
+
+std::string printSnapshotDefs(
+  PimplStorageKind storageKind
+  , const std::string& interfaceType
+  , const std::string& implType
+  , const std::vector<PimplFieldInfo>& fields
+  , bool isTriviallyCopyable
+  , const std::string& readLock
+  , const std::string& writeLock
+  , const std::string& memoInvalidation)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!implType.empty());
+
+  // reference to impl named `impl`,
+  // example: ` const auto& impl = (*impl_);`
+  auto printImplBinding = [storageKind](bool isConst) -> std::string {
+    const std::string binding
+      = isConst
+        ? " const auto& impl = "
+        : " auto& impl = ";
+    switch(storageKind) {
+      case PimplStorageKind::kInline:
+      case PimplStorageKind::kPool:
+      case PimplStorageKind::kAuto:
+        return binding + "(*impl_);\n";
+      case PimplStorageKind::kLazy:
+        return binding + "impl_.get();\n";
+      case PimplStorageKind::kCow:
+        return binding
+          + (isConst ? "impl_.read();\n" : "impl_.write();\n");
+      // guard keeps impl alive (or publishes modified clone)
+      // until end of function
+      case PimplStorageKind::kRcu:
+        return (isConst
+                 ? " const auto implGuard = impl_.read();\n"
+                 : " auto implGuard = impl_.write();\n")
+          + binding
+          + "*implGuard;\n";
+      case PimplStorageKind::kVariant:
+        break;
+    }
+    NOTREACHED();
+    return binding + "(*impl_);\n";
+  };
+
+  // `size_t ::Foo::snapshot` would be parsed as `size_t::Foo::snapshot`
+  const std::string scope = printNestedScope(interfaceType);
+
+  std::string out;
+
+  out += "size_t ";
+  out += scope;
+  out += "::snapshotSize() const";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  if(isTriviallyCopyable) {
+    out += " return sizeof(";
+    out += implType;
+    out += ");";
+    out += "\n";
+  } else {
+    out += readLock;
+    out += printImplBinding(true);
+    out += " return 0";
+    for(const PimplFieldInfo& field : fields) {
+      out += "\n";
+      out += "   + ::flex_pimpl_plugin::pimpl::snapshotSize(impl.";
+      out += field.name;
+      out += ")";
+    }
+    out += ";";
+    out += "\n";
+  }
+  out += "}";
+  out += "\n";
+
+  out += "size_t ";
+  out += scope;
+  out += "::snapshot(char* out) const";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += readLock;
+  out += printImplBinding(true);
+  if(isTriviallyCopyable) {
+    out += " ::std::memcpy(out, &impl, sizeof(impl));";
+    out += "\n";
+    out += " return sizeof(impl);";
+    out += "\n";
+  } else {
+    out += " char* pos = out;";
+    out += "\n";
+    for(const PimplFieldInfo& field : fields) {
+      out += " pos = ::flex_pimpl_plugin::pimpl::writeSnapshot(impl.";
+      out += field.name;
+      out += ", pos);";
+      out += "\n";
+    }
+    out += " return pos - out;";
+    out += "\n";
+  }
+  out += "}";
+  out += "\n";
+
+  out += "size_t ";
+  out += scope;
+  out += "::restore(const char* in, size_t size)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  if(isTriviallyCopyable) {
+    // impl is not modified if input is too short
+    out += " if(size < sizeof(";
+    out += implType;
+    out += ")) {";
+    out += "\n";
+    out += "  return 0;";
+    out += "\n";
+    out += " }";
+    out += "\n";
+  }
+  out += writeLock;
+  out += memoInvalidation;
+  out += printImplBinding(false);
+  if(isTriviallyCopyable) {
+    out += " ::std::memcpy(static_cast<void*>(&impl), in, sizeof(impl));";
+    out += "\n";
+    out += " return sizeof(impl);";
+    out += "\n";
+  } else {
+    // failed read returns nullptr that is passed to next reads
+    out += " const char* const end = in + size;";
+    out += "\n";
+    out += " const char* pos = in;";
+    out += "\n";
+    for(const PimplFieldInfo& field : fields) {
+      out += " pos = ::flex_pimpl_plugin::pimpl::readSnapshot(impl.";
+      out += field.name;
+      out += ", pos, end);";
+      out += "\n";
+    }
+    out += " return pos ? pos - in : 0;";
+    out += "\n";
+  }
+  out += "}";
+  out += "\n";
+
+  // bulk versions, calls of single-object versions
+  // are inlined because they are defined in same file
+  out += "size_t ";
+  out += scope;
+  out += "::snapshotSize(::base::span<const ";
+  out += interfaceType;
+  out += "> objects)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  if(isTriviallyCopyable) {
+    out += " return objects.size() * sizeof(";
+    out += implType;
+    out += ");";
+    out += "\n";
+  } else {
+    out += " size_t size = 0;";
+    out += "\n";
+    out += " for(const auto& object : objects) {";
+    out += "\n";
+    out += "  size += object.snapshotSize();";
+    out += "\n";
+    out += " }";
+    out += "\n";
+    out += " return size;";
+    out += "\n";
+  }
+  out += "}";
+  out += "\n";
+
+  out += "size_t ";
+  out += scope;
+  out += "::snapshot(::base::span<const ";
+  out += interfaceType;
+  out += "> objects, char* out)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " char* pos = out;";
+  out += "\n";
+  out += " for(const auto& object : objects) {";
+  out += "\n";
+  out += "  pos += object.snapshot(pos);";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  out += " return pos - out;";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  out += "size_t ";
+  out += scope;
+  out += "::restore(::base::span<";
+  out += interfaceType;
+  out += "> objects, const char* in, size_t size)";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " const char* pos = in;";
+  out += "\n";
+  out += " for(auto& object : objects) {";
+  out += "\n";
+  out += "  const size_t objectSize";
+  out += "\n";
+  out += "    = object.restore(pos, size - static_cast<size_t>(pos - in));";
+  out += "\n";
+  out += "  if(!objectSize) {";
+  out += "\n";
+  out += "   return 0;";
+  out += "\n";
+  out += "  }";
+  out += "\n";
+  out += "  pos += objectSize;";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  out += " return pos - in;";
+  out += "\n";
+  out += "}";
+  out += "\n";
+
+  return out;
+}
+
+std::string printForwarderLock(
+  PimplLocking locking
+  , bool isReadOnly
+  , const std::string& object)
+{
+  switch(locking) {
+    case PimplLocking::kExclusive:
+      return " ::std::lock_guard implLock(" + object + "implMutex_);\n";
+    case PimplLocking::kShared:
+      return isReadOnly
+        ? " ::std::shared_lock implLock(" + object + "implMutex_);\n"
+        : " ::std::lock_guard implLock(" + object + "implMutex_);\n";
+    case PimplLocking::kNone:
+      break;
+  }
+  return "";
+}
+
+std::string printMemoCacheMember(
+  const PimplMemoCache& cache)
+{
+  DCHECK(!cache.name.empty());
+  DCHECK(!cache.valueType.empty());
+  DCHECK_GT(cache.capacity, 0u);
+
+  std::string out;
+  out += "mutable ::flex_pimpl_plugin::pimpl::MemoCache<";
+  out += cache.keyType;
+  out += clang_utils::kSeparatorCommaAndWhitespace;
+  out += cache.valueType;
+  out += clang_utils::kSeparatorCommaAndWhitespace;
+  out += std::to_string(cache.capacity);
+  out += "> ";
+  out += cache.name;
+  out += ";";
+  return out;
+}
+
+std::string printMemoCacheInvalidation(
+  const std::vector<PimplMemoCache>& caches
+  , const std::string& object)
+{
+  std::string out;
+  for(const PimplMemoCache& cache : caches) {
+    out += " ";
+    out += object;
+    out += cache.name;
+    out += ".clear();";
+    out += "\n";
+  }
+  return out;
+}
+
+std::string printMemoizedForwarderBody(
+  const std::string& cacheName
+  , const std::string& object
+  , const std::string& paramNames
+  , const std::string& forwarderBody)
+{
+  DCHECK(!cacheName.empty());
+  DCHECK(!forwarderBody.empty());
+
+  std::string out;
+  out += " const auto memoKey = ::std::forward_as_tuple(";
+  out += paramNames;
+  out += ");";
+  out += "\n";
+  out += " if(const auto* cached = ";
+  out += object;
+  out += cacheName;
+  out += ".find(memoKey)) {";
+  out += "\n";
+  out += "  return *cached;";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  // lambda allows to reuse body of any storage
+  // (including switch of `storage = variant`)
+  out += " return ";
+  out += object;
+  out += cacheName;
+  out += ".insert(memoKey, [&]() {";
+  out += "\n";
+  out += forwarderBody;
+  out += "\n";
+  out += " }());";
+  return out;
+}
+
+std::string printAsyncForwarderName(
+  const std::string& methodName)
+{
+  DCHECK(!methodName.empty());
+  return methodName + "_async";
+}
+
+std::string printAsyncForwarderDecl(
+  const std::string& methodName
+  , const std::string& paramDecls
+  , const std::string& resultType
+  , bool isConstMethod)
+{
+  std::string out;
+  out += "::std::future<";
+  out += resultType.empty() ? "void" : resultType;
+  out += "> ";
+  out += printAsyncForwarderName(methodName);
+  out += "(";
+  out += paramDecls;
+  out += ")";
+  out += isConstMethod ? " const" : "";
+  out += ";";
+  out += "\n";
+  return out;
+}
+
+std::string printAsyncForwarderDef(
+  const std::string& interfaceType
+  , const std::string& methodName
+  , const std::string& paramDecls
+  , const std::vector<std::string>& paramNames
+  , const std::string& forwardedParams
+  , const std::string& resultType
+  , bool isConstMethod)
+{
+  DCHECK(!interfaceType.empty());
+
+  std::string out;
+  out += "::std::future<";
+  out += resultType.empty() ? "void" : resultType;
+  out += "> ";
+  out += interfaceType;
+  out += "::";
+  out += printAsyncForwarderName(methodName);
+  out += "(";
+  out += paramDecls;
+  out += ")";
+  out += isConstMethod ? " const" : "";
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " return ::std::async(::std::launch::async, [this";
+  // arguments are owned by task,
+  // references to arguments of caller can not be kept
+  for(const std::string& paramName : paramNames) {
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += paramName;
+    out += " = ::std::move(";
+    out += paramName;
+    out += ")";
+  }
+  out += "]() mutable {";
+  out += "\n";
+  out += "  return ";
+  out += methodName;
+  out += "(";
+  out += forwardedParams;
+  out += ");";
+  out += "\n";
+  out += " });";
+  out += "\n";
+  out += "}";
+  out += "\n";
+  return out;
+}
+
+std::string printHotnessAttributes(
+  PimplMethodHotness hotness)
+{
+  switch(hotness) {
+    case PimplMethodHotness::kHot:
+      return "[[gnu::hot]] ";
+    // cold forwarders are placed into `.text.unlikely`
+    case PimplMethodHotness::kCold:
+      return "[[gnu::cold]] [[gnu::noinline]] ";
+    case PimplMethodHotness::kUnknown:
+      break;
+  }
+  return "";
+}
+
+std::string printForwardingConstructorDecls(
+  const std::string& interfaceName
+  , const std::vector<PimplConstructorInfo>& constructors)
+{
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+  for(const PimplConstructorInfo& constructor : constructors) {
+    if(constructor.isExplicit) {
+      out += "explicit ";
+    }
+    out += interfaceName;
+    out += "(";
+    out += constructor.paramDecls;
+    out += ");";
+    out += "\n";
+    out += "void emplace(";
+    out += constructor.paramDecls;
+    out += ");";
+    out += "\n";
+  }
+  return out;
+}
+
+std::string printForwardingConstructorDefs(
+  PimplStorageKind kind
+  , const std::string& interfaceType
+  , const std::string& interfaceName
+  , const std::vector<PimplConstructorInfo>& constructors
+  , const std::string& lock
+  , const std::string& memoInvalidation
+  , bool isCpuDispatch)
+{
+  DCHECK(!interfaceType.empty());
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+  for(const PimplConstructorInfo& constructor : constructors) {
+    DCHECK(!constructor.forwardedParams.empty());
+
+    out += interfaceType;
+    out += "::";
+    out += interfaceName;
+    out += "(";
+    out += constructor.paramDecls;
+    out += ")";
+    out += "\n";
+    switch(kind) {
+      case PimplStorageKind::kInline:
+      case PimplStorageKind::kPool:
+      case PimplStorageKind::kCow:
+      case PimplStorageKind::kRcu: {
+        out += " : impl_(";
+        out += constructor.forwardedParams;
+        out += ")";
+        out += "\n";
+        out += "{}";
+        break;
+      }
+      // storage selects alternative supported by host
+      case PimplStorageKind::kVariant: {
+        out += isCpuDispatch
+          ? " : impl_("
+          : " : impl_(::std::in_place_index<0>, ";
+        out += constructor.forwardedParams;
+        out += ")";
+        out += "\n";
+        out += "{}";
+        break;
+      }
+      // storage does not construct impl eagerly
+      case PimplStorageKind::kLazy: {
+        out += "{";
+        out += "\n";
+        out += " impl_.emplace(";
+        out += constructor.forwardedParams;
+        out += ");";
+        out += "\n";
+        out += "}";
+        break;
+      }
+      case PimplStorageKind::kAuto: {
+        NOTREACHED();
+        break;
+      }
+    }
+    out += "\n";
+
+    out += "void ";
+    out += interfaceType;
+    out += "::emplace(";
+    out += constructor.paramDecls;
+    out += ")";
+    out += "\n";
+    out += "{";
+    out += "\n";
+    out += lock;
+    out += memoInvalidation;
+    switch(kind) {
+      case PimplStorageKind::kInline:
+      case PimplStorageKind::kPool: {
+        out += " ::flex_pimpl_plugin::pimpl::reconstruct(*impl_";
+        break;
+      }
+      case PimplStorageKind::kVariant: {
+        out += isCpuDispatch
+          ? " impl_.emplaceSelected("
+          : " impl_.emplace<0>(";
+        break;
+      }
+      // publishes new impl, readers keep old impl,
+      // copy-on-write storage does not clone impl that is replaced
+      case PimplStorageKind::kLazy:
+      case PimplStorageKind::kCow:
+      case PimplStorageKind::kRcu: {
+        out += " impl_.emplace(";
+        break;
+      }
+      case PimplStorageKind::kAuto: {
+        NOTREACHED();
+        break;
+      }
+    }
+    if(kind != PimplStorageKind::kVariant
+       && kind != PimplStorageKind::kLazy
+       && kind != PimplStorageKind::kCow
+       && kind != PimplStorageKind::kRcu)
+    {
+      out += clang_utils::kSeparatorCommaAndWhitespace;
+    }
+    out += constructor.forwardedParams;
+    out += ");";
+    out += "\n";
+    out += "}";
+    out += "\n";
+  }
+  return out;
+}
+
+std::string printBatchForwarderName(
+  const std::string& methodName)
+{
+  DCHECK(!methodName.empty());
+  return methodName + "_batch";
+}
+
+namespace {
+
+// example: `foo_batch(::base::span<const Foo> objects, int arg, int* out)`
+std::string printBatchForwarderSignature(
+  const std::string& interfaceType
+  , const std::string& scope
+  , const PimplBatchMethod& method)
+{
+  std::string out;
+  out += scope;
+  out += printBatchForwarderName(method.name);
+  out += "(::base::span<";
+  out += method.isConst ? "const " : "";
+  out += interfaceType;
+  out += "> objects";
+  if(!method.paramDecls.empty()) {
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += method.paramDecls;
+  }
+  if(!method.resultType.empty()) {
+    out += clang_utils::kSeparatorCommaAndWhitespace;
+    out += method.resultType;
+    out += "* out";
+  }
+  out += ")";
+  return out;
+}
+
+} // namespace
+
+std::string printBatchForwarderDecl(
+  const std::string& interfaceName
+  , const PimplBatchMethod& method)
+{
+  DCHECK(!interfaceName.empty());
+
+  std::string out;
+  out += "static void ";
+  out += printBatchForwarderSignature(interfaceName, "", method);
+  out += ";";
+  out += "\n";
+  return out;
+}
+
+std::string printBatchForwarderDef(
+  const std::string& interfaceType
+  , const PimplBatchMethod& method)
+{
+  DCHECK(!interfaceType.empty());
+
+  std::string out;
+  out += "void ";
+  out += printBatchForwarderSignature(
+    interfaceType, interfaceType + "::", method);
+  out += "\n";
+  out += "{";
+  out += "\n";
+  out += " for(::std::size_t i = 0; i < objects.size(); i++) {";
+  out += "\n";
+  out += "  ";
+  if(!method.resultType.empty()) {
+    out += "out[i] = ";
+  }
+  out += "objects[i].";
+  out += method.name;
+  out += "(";
+  out += method.paramNames;
+  out += ");";
+  out += "\n";
+  out += " }";
+  out += "\n";
+  out += "}";
+  out += "\n";
+  return out;
+}
+
 bool isPimplMethod(
   const reflection::MethodInfoPtr& methodInfo)
 {
@@ -123,6 +123,17 @@ void FlexpimplEventHandler::RegisterAnnotationMethods(
         , base::Unretained(tooling_.get()));
   }
 
+  {
+    VLOG(9)
+      << "registered source transform rule:"
+         " inject_pimpl_extern_templates";
+    CHECK(tooling_);
+    sourceTransformRules["inject_pimpl_extern_templates"] =
+      base::BindRepeating(
+        &pimplTooling::injectPimplExternTemplates
+        , base::Unretained(tooling_.get()));
+  }
+
   {
     VLOG(9)
       << "registered source transform rule:"
@@ -43,8 +43,12 @@
 #include <base/files/file_util.h>
 #include <base/path_service.h>
 #include <base/strings/string_number_conversions.h>
+#include <base/strings/string_split.h>
 
+#include <algorithm>
 #include <any>
+#include <cstring>
+#include <map>
 #include <string>
 #include <vector>
 #include <regex>
@@ -56,6 +60,359 @@ namespace plugin {
 
 static const char kSkipPimplAttr[] = "skip_pimpl";
 
+// method of impl that gets static batch forwarder
+static const char kBatchPimplAttr[] = "batch_pimpl";
+
+// per-method policy, see `parsePimplMethodPolicy`
+static const char kPimplPolicyAttr[] = "pimpl_policy";
+
+// template arguments of explicit instantiation,
+// see `parsePimplMethodInstantiation`
+static const char kPimplInstantiateAttr[] = "pimpl_instantiate";
+
+// template parameters of alternative impls:
+// `impl_1`, `impl_2`, etc.
+static const char kImplAlternativePrefix[] = "impl_";
+
+// ISA extensions required by alternative impls:
+// `isa_1`, `isa_2`, etc.
+static const char kIsaArgPrefix[] = "isa_";
+
+// nested struct of interface with static forwarders,
+// see `inline_forwarders` argument of `injectPimplMethodCalls`
+static const char kInlineForwardersName[] = "Inline";
+
+// max. size of impl (in bytes) that will use inline storage
+// if `storage = auto` is used without `inlineBudget`
+static const int kDefaultInlineBudget = 128;
+
+// method is hot if it has at least 1% of samples in profile
+static const uint64_t kHotSamplesPercent = 1;
+
+// max. number of cached results if `memoize` policy has no capacity,
+/// \note same as ::flex_pimpl_plugin::pimpl::kDefaultMemoCapacity
+static const size_t kDefaultMemoCapacity = 8;
+
+/// \note allows both `storage = pool` and `storage = "pool"`
+static std::string unquoteArgValue(const std::string& value)
+{
+  std::string result;
+  base::TrimString(value, " \t\"'", &result);
+  return result;
+}
+
+/**
+  * EXAMPLE INPUT:
+      _injectPimplStorage(
+        "storage = pool"
+      )
+  *
+  * EXAMPLE OUTPUT:
+      PimplStorageKind::kPool
+  **/
+static PimplStorageKind parsePimplStorageKind(
+  const std::string& value)
+{
+  const std::string storage = unquoteArgValue(value);
+
+  if(storage == "inline") {
+    return PimplStorageKind::kInline;
+  } else if(storage == "pool") {
+    return PimplStorageKind::kPool;
+  } else if(storage == "auto") {
+    return PimplStorageKind::kAuto;
+  } else if(storage == "lazy") {
+    return PimplStorageKind::kLazy;
+  } else if(storage == "cow") {
+    return PimplStorageKind::kCow;
+  } else if(storage == "variant") {
+    return PimplStorageKind::kVariant;
+  } else if(storage == "rcu") {
+    return PimplStorageKind::kRcu;
+  }
+
+  CHECK(false)
+    << "(pimpl) unknown storage: "
+    << storage;
+  return PimplStorageKind::kInline;
+}
+
+/**
+  * EXAMPLE INPUT:
+      # impl method, sample count
+      example_impl::FooImpl::baz 1234
+      example_impl::FooImpl::foo 0
+  *
+  * EXAMPLE OUTPUT:
+      {"example_impl::FooImpl::baz": 1234, "example_impl::FooImpl::foo": 0}
+  **/
+static std::map<std::string, uint64_t> parseProfileSummary(
+  const std::string& contents)
+{
+  std::map<std::string, uint64_t> samples;
+
+  for(base::StringPiece line
+        : base::SplitStringPiece(
+            contents
+            , "\n"
+            , base::TRIM_WHITESPACE
+            , base::SPLIT_WANT_NONEMPTY))
+  {
+    if(line.starts_with("#")) {
+      continue;
+    }
+
+    const size_t separator = line.find_last_of(" \t");
+    uint64_t count = 0;
+    if(separator == base::StringPiece::npos
+       || !base::StringToUint64(line.substr(separator + 1), &count))
+    {
+      LOG(WARNING)
+        << "(pimpl) skipped invalid line of profile: "
+        << line;
+      continue;
+    }
+
+    std::string method
+      = base::TrimWhitespaceASCII(
+          line.substr(0, separator), base::TRIM_ALL).as_string();
+    // allows both `::Foo::bar` and `Foo::bar`
+    if(base::StartsWith(method, "::", base::CompareCase::SENSITIVE)) {
+      method = method.substr(2);
+    }
+
+    samples[method] += count;
+  }
+
+  return samples;
+}
+
+/**
+  * EXAMPLE INPUT:
+      pimpl_policy(forwarding = inline, section = hot, locking = exclusive)
+  *
+  * EXAMPLE OUTPUT:
+      PimplMethodPolicy{kInline, kHot, false, false, kExclusive, false}
+  *
+  * keys that are not listed in annotation keep value from |defaults|
+  **/
+static PimplMethodPolicy parsePimplMethodPolicy(
+  const std::string& annotation
+  , const PimplMethodPolicy& defaults)
+{
+  PimplMethodPolicy policy = defaults;
+
+  const size_t argsBegin = annotation.find('(');
+  const size_t argsEnd = annotation.rfind(')');
+  CHECK(argsBegin != std::string::npos
+        && argsEnd != std::string::npos
+        && argsBegin < argsEnd)
+    << "(pimpl) invalid policy: "
+    << annotation;
+
+  for(const std::string& arg
+        : base::SplitString(
+            annotation.substr(argsBegin + 1, argsEnd - argsBegin - 1)
+            , ","
+            , base::TRIM_WHITESPACE
+            , base::SPLIT_WANT_NONEMPTY))
+  {
+    const size_t separator = arg.find('=');
+    std::string key;
+    base::TrimWhitespaceASCII(
+      arg.substr(0, separator), base::TRIM_ALL, &key);
+    const std::string value
+      = separator == std::string::npos
+        ? ""
+        : unquoteArgValue(arg.substr(separator + 1));
+
+    if(key == "forwarding" && value == "inline") {
+      policy.forwarding = PimplForwarding::kInline;
+    } else if(key == "forwarding" && value == "out_of_line") {
+      policy.forwarding = PimplForwarding::kOutOfLine;
+    } else if(key == "section" && value == "hot") {
+      policy.section = PimplMethodHotness::kHot;
+    } else if(key == "section" && value == "cold") {
+      policy.section = PimplMethodHotness::kCold;
+    } else if(key == "locking" && value == "none") {
+      policy.locking = PimplLocking::kNone;
+    } else if(key == "locking" && value == "exclusive") {
+      policy.locking = PimplLocking::kExclusive;
+    } else if(key == "locking" && value == "shared") {
+      policy.locking = PimplLocking::kShared;
+    } else if(key == "memoize" && value.empty()) {
+      policy.isMemoized = true;
+      policy.memoCapacity = kDefaultMemoCapacity;
+    } else if(key == "memoize") {
+      int capacity = 0;
+      CHECK(base::StringToInt(value, &capacity) && capacity > 0)
+        << "(pimpl) memoize expects positive capacity: "
+        << arg;
+      policy.isMemoized = true;
+      policy.memoCapacity = static_cast<size_t>(capacity);
+    } else if(key == "batch" && value.empty()) {
+      policy.isBatched = true;
+    } else if(key == "async" && value.empty()) {
+      policy.isAsync = true;
+    } else {
+      CHECK(false)
+        << "(pimpl) unknown policy: "
+        << arg
+        << " in "
+        << annotation;
+    }
+  }
+
+  return policy;
+}
+
+/**
+  * EXAMPLE INPUT:
+      template <typename T, int N>
+      _pimplInstantiate(::std::pair<int, char>, 4)
+      size_t describe(const T& value) const;
+  *
+  * EXAMPLE OUTPUT:
+      PimplMethodInstantiation{
+        .templateArgs = "::std::pair<int, char>, 4"
+        , .returnType = "::size_t"
+        , .paramTypes
+            = "(const ::std::enable_if_t<true, ::std::pair<int, char>> &)"
+        , .trailing = " const"
+      }
+  **/
+static PimplMethodInstantiation parsePimplMethodInstantiation(
+  const std::string& annotation
+  , const clang::CXXMethodDecl* methodDecl
+  , const clang::ASTContext& context)
+{
+  DCHECK(methodDecl);
+
+  const clang::FunctionTemplateDecl* functionTemplate
+    = methodDecl->getDescribedFunctionTemplate();
+  CHECK(functionTemplate)
+    << "(pimpl) _pimplInstantiate requires method template: "
+    << methodDecl->getQualifiedNameAsString();
+
+  const size_t argsBegin = annotation.find('(');
+  const size_t argsEnd = annotation.rfind(')');
+  CHECK(argsBegin != std::string::npos
+        && argsEnd != std::string::npos
+        && argsBegin < argsEnd)
+    << "(pimpl) invalid instantiation: "
+    << annotation;
+
+  PimplMethodInstantiation instantiation;
+  base::TrimWhitespaceASCII(
+    annotation.substr(argsBegin + 1, argsEnd - argsBegin - 1)
+    , base::TRIM_ALL
+    , &instantiation.templateArgs);
+
+  // `::std::pair<int, char>` is single argument
+  std::vector<std::string> args(1);
+  int depth = 0;
+  for(const char c : instantiation.templateArgs) {
+    if(c == ',' && depth == 0) {
+      args.emplace_back();
+      continue;
+    }
+    if(c == '<' || c == '(' || c == '[') {
+      depth++;
+    } else if(c == '>' || c == ')' || c == ']') {
+      depth--;
+    }
+    args.back() += c;
+  }
+  for(std::string& arg : args) {
+    base::TrimWhitespaceASCII(arg, base::TRIM_ALL, &arg);
+  }
+
+  std::vector<std::string> paramNames;
+  std::vector<bool> isTypeParam;
+  for(const clang::NamedDecl* param
+        : *functionTemplate->getTemplateParameters())
+  {
+    CHECK(!param->isParameterPack())
+      << "(pimpl) _pimplInstantiate does not support parameter packs: "
+      << methodDecl->getQualifiedNameAsString();
+    paramNames.push_back(param->getNameAsString());
+    isTypeParam.push_back(clang::isa<clang::TemplateTypeParmDecl>(param));
+  }
+  CHECK(args.size() == paramNames.size())
+    << "(pimpl) expected "
+    << paramNames.size()
+    << " template arguments in "
+    << annotation
+    << " for "
+    << methodDecl->getQualifiedNameAsString();
+
+  instantiation.returnType
+    = substituteTemplateParams(
+        printFullyQualifiedType(methodDecl->getReturnType(), context)
+        , paramNames
+        , args
+        , isTypeParam);
+
+  instantiation.paramTypes = "(";
+  for(const clang::ParmVarDecl* param : methodDecl->parameters()) {
+    if(param != methodDecl->parameters().front()) {
+      instantiation.paramTypes
+        += clang_utils::kSeparatorCommaAndWhitespace;
+    }
+    instantiation.paramTypes
+      += substituteTemplateParams(
+           printFullyQualifiedType(param->getType(), context)
+           , paramNames
+           , args
+           , isTypeParam);
+  }
+  instantiation.paramTypes += ")";
+
+  // exception specification is part of type of function
+  if(methodDecl->isConst()) {
+    instantiation.trailing += " const";
+  }
+  if(methodDecl->getRefQualifier() == clang::RQ_LValue) {
+    instantiation.trailing += " &";
+  } else if(methodDecl->getRefQualifier() == clang::RQ_RValue) {
+    instantiation.trailing += " &&";
+  }
+  const clang::FunctionProtoType* proto
+    = methodDecl->getType()->getAs<clang::FunctionProtoType>();
+  if(proto && proto->isNothrow()) {
+    instantiation.trailing += " noexcept";
+  }
+
+  return instantiation;
+}
+
+// data computed from AST of impl method during `reflectForPimpl`
+static const PimplMethodTraits& getMethodTraits(
+  const PimplImplTraits& implTraits
+  , const reflection::MethodInfo* method)
+{
+  DCHECK(method);
+  auto it = implTraits.methods.find(method);
+  CHECK(it != implTraits.methods.end())
+    << "not in cache "
+    << method->name;
+  return it->second;
+}
+
+// access of annotated class template,
+// example: `AS_private` if annotation placed in `private:` section
+static clang::AccessSpecifier getAnnotationAccess(
+  const clang::CXXRecordDecl* node)
+{
+  DCHECK(node);
+  if(const clang::ClassTemplateDecl* templateDecl
+       = node->getDescribedClassTemplate())
+  {
+    return templateDecl->getAccess();
+  }
+  return node->getAccess();
+}
+
 /// \todo refactor similar to https://github.com/jarro2783/cxxopts
 /**
   * EXAMPLE INPUT:
@@ -156,6 +513,31 @@ static ReflectForPimplSettings getReflectForPimplSettings(
             );
         CHECK(!result.interfaceParameterQualType.empty())
           << node->getNameAsString();
+      } else if(base::StartsWith(
+                  parameter_decl->getNameAsString()
+                  , kImplAlternativePrefix
+                  , base::CompareCase::SENSITIVE))
+      {
+        // alternatives must be numbered in order:
+        // `impl_1`, `impl_2`, etc.
+        CHECK(parameter_decl->getNameAsString()
+              == kImplAlternativePrefix
+                 + std::to_string(
+                     result.alternativeParameterQualTypes.size() + 1))
+          << "(pimpl) unexpected alternative: "
+          << parameter_decl->getNameAsString()
+          << " in "
+          << node->getNameAsString();
+
+        result.alternativeArgQualTypes.push_back(
+          template_type->getDefaultArgument());
+
+        result.alternativeParameterQualTypes.push_back(
+          clang_utils::extractTypeName(
+            result.alternativeArgQualTypes.back()
+              .getAsString(printingPolicy)));
+        CHECK(!result.alternativeParameterQualTypes.back().empty())
+          << node->getNameAsString();
       } else {
         CHECK(false)
           << "(pimpl) unknown argument: "
@@ -172,6 +554,11 @@ static ReflectForPimplSettings getReflectForPimplSettings(
     }
   } // for
 
+  CHECK(result.alternativeParameterQualTypes.empty()
+        || !result.implParameterQualType.empty())
+    << "(pimpl) alternatives require `impl` argument: "
+    << node->getNameAsString();
+
   VLOG(9)
     << "parsed pimpl reflection settings...";
 
@@ -256,6 +643,33 @@ pimplTooling::pimplTooling(
      outDir_ = base::FilePath{settings_.outDir};
   }
 
+  if(!settings_.profileFile.empty()) {
+    std::string contents;
+    if(!base::ReadFileToString(
+          base::FilePath{settings_.profileFile}, &contents))
+    {
+      LOG(ERROR)
+        << "(pimpl) failed to read profile: "
+        << settings_.profileFile;
+    } else {
+      profileSamples_ = parseProfileSummary(contents);
+      for(const auto& it : profileSamples_) {
+        profileTotalSamples_ += it.second;
+        const size_t classEnd = it.first.rfind("::");
+        if(classEnd != std::string::npos) {
+          profiledClasses_.insert(it.first.substr(0, classEnd));
+        }
+      }
+      VLOG(9)
+        << "loaded profile with "
+        << profileSamples_.size()
+        << " methods and "
+        << profileTotalSamples_
+        << " samples from "
+        << settings_.profileFile;
+    }
+  }
+
   if(!base::PathExists(outDir_)) {
     base::File::Error dirError = base::File::FILE_OK;
     // Returns 'true' on successful creation,
@@ -289,18 +703,69 @@ pimplTooling::~pimplTooling()
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 }
 
+PimplMethodHotness pimplTooling::getMethodHotness(
+  const std::string& implParameterQualType
+  , const std::string& methodName) const
+{
+  // profile may be collected from other binary,
+  // absent class says nothing about its methods
+  if(!isProfiledClass(implParameterQualType)) {
+    return PimplMethodHotness::kUnknown;
+  }
+
+  std::string method = implParameterQualType + "::" + methodName;
+  if(base::StartsWith(method, "::", base::CompareCase::SENSITIVE)) {
+    method = method.substr(2);
+  }
+
+  // method of profiled class without samples
+  // was not executed while profiling
+  auto it = profileSamples_.find(method);
+  const uint64_t samples
+    = it != profileSamples_.end() ? it->second : 0;
+
+  if(samples == 0) {
+    return PimplMethodHotness::kCold;
+  }
+
+  if(samples * 100 >= profileTotalSamples_ * kHotSamplesPercent) {
+    return PimplMethodHotness::kHot;
+  }
+
+  return PimplMethodHotness::kUnknown;
+}
+
+bool pimplTooling::isProfiledClass(
+  const std::string& implParameterQualType) const
+{
+  if(base::StartsWith(
+       implParameterQualType, "::", base::CompareCase::SENSITIVE))
+  {
+    return profiledClasses_.count(implParameterQualType.substr(2)) > 0;
+  }
+  return profiledClasses_.count(implParameterQualType) > 0;
+}
+
 reflection::ClassInfoPtr
   pimplTooling::reflectFromCache(
     ReflectForPimplSettings& reflectForPimplSettings
+){
+  return reflectFromCache(
+    reflectForPimplSettings.implParameterQualType);
+}
+
+reflection::ClassInfoPtr
+  pimplTooling::reflectFromCache(
+    const std::string& implParameterQualType
 ){
   VLOG(9)
     << "trying to get cached reflection data for class: "
-    << reflectForPimplSettings.implParameterQualType;
+    << implParameterQualType;
 
   reflection::ClassInfoPtr reflectedClass;
 
   auto it = reflectionCache_.find(
-    reflectForPimplSettings.implParameterQualType);
+    implParameterQualType);
 
   if(it != reflectionCache_.end()) {
     // fallback to cache
@@ -308,17 +773,73 @@ reflection::ClassInfoPtr
   } else {
     CHECK(false)
       << "not in cache "
-      << reflectForPimplSettings.implParameterQualType;
+      << implParameterQualType;
   }
 
   VLOG(9)
     << "retrieved cached reflection data "
        "from cache for class: "
-    << reflectForPimplSettings.implParameterQualType;
+    << implParameterQualType;
 
   return reflectedClass;
 }
 
+const PimplImplTraits&
+  pimplTooling::getImplTraits(
+    const ReflectForPimplSettings& reflectForPimplSettings
+){
+  return getImplTraits(
+    reflectForPimplSettings.implParameterQualType);
+}
+
+const PimplImplTraits&
+  pimplTooling::getImplTraits(
+    const std::string& implParameterQualType
+){
+  auto it = implTraitsCache_.find(
+    implParameterQualType);
+
+  CHECK(it != implTraitsCache_.end())
+    << "not in cache "
+    << implParameterQualType;
+
+  return it->second;
+}
+
+bool pimplTooling::isImplementedByAlternatives(
+  const reflection::MethodInfo* method
+  , const PimplImplTraits& implTraits
+  , const std::vector<std::string>& alternatives)
+{
+  DCHECK(method);
+
+  const PimplMethodTraits& methodTraits
+    = getMethodTraits(implTraits, method);
+
+  for(const std::string& alternative : alternatives) {
+    const PimplImplTraits& alternativeTraits
+      = getImplTraits(alternative);
+
+    bool found = false;
+    for(const auto& it : alternativeTraits.methods) {
+      if(it.second.signature == methodTraits.signature) {
+        found = true;
+        break;
+      }
+    }
+
+    if(!found) {
+      VLOG(9)
+        << methodTraits.signature
+        << " is not implemented by "
+        << alternative;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 reflection::ClassInfoPtr
   pimplTooling::reflectOrGetFromCache(
     reflection::AstReflector& reflector
@@ -424,6 +945,17 @@ clang_utils::SourceTransformResult
 
   int extra_size_bytes = 0;
 
+  PimplStorageKind storageKind = PimplStorageKind::kInline;
+
+  // used only by `storage = auto`
+  int inline_budget_bytes = -1;
+
+  bool isPmrAllocatorAware = false;
+
+  // `isa_1 = avx2`, `isa_2 = avx2+avx512f`, etc.
+  // key is index of alternative
+  std::map<size_t, std::vector<std::string>> isaOfAlternatives;
+
   /**
    * parse arguments from annotation attribute
    * EXAMPLE:
@@ -460,6 +992,40 @@ clang_utils::SourceTransformResult
           << arg.name_
           << " with value: "
           << arg.value_;
+      } else if(arg.name_ == "storage") {
+        storageKind = parsePimplStorageKind(arg.value_);
+      } else if(arg.name_ == "allocator") {
+        CHECK(unquoteArgValue(arg.value_) == "pmr")
+          << "(pimpl) unsupported allocator: "
+          << arg.value_;
+        isPmrAllocatorAware = true;
+      } else if(base::StartsWith(
+                  arg.name_
+                  , kIsaArgPrefix
+                  , base::CompareCase::SENSITIVE))
+      {
+        size_t alternativeIndex = 0;
+        CHECK(base::StringToSizeT(
+                arg.name_.substr(std::strlen(kIsaArgPrefix))
+                , &alternativeIndex)
+              && alternativeIndex > 0)
+          << "(pimpl) expected `isa_1`, `isa_2`, etc., got: "
+          << arg.name_;
+        isaOfAlternatives[alternativeIndex]
+          = base::SplitString(
+              unquoteArgValue(arg.value_)
+              , "+"
+              , base::TRIM_WHITESPACE
+              , base::SPLIT_WANT_NONEMPTY);
+      } else if(arg.name_ == "inlineBudget") {
+        DCHECK(inline_budget_bytes == -1); // -1 is default value
+        bool convertedStringToInt
+          = base::StringToInt(arg.value_, &inline_budget_bytes);
+        CHECK(convertedStringToInt && inline_budget_bytes >= 0)
+          << "(pimpl) unable to convert to int argument: "
+          << arg.name_
+          << " with value: "
+          << arg.value_;
       } else {
         CHECK(false)
           << "(pimpl) unknown argument: "
@@ -472,132 +1038,1771 @@ clang_utils::SourceTransformResult
 
   std::string replacer;
 
-  /**
-   * generates code similar to:
-   *  basis::FastPimpl<FooImpl, Size, Alignment> impl_;
-   **/
-  {
-    DVLOG(9)
-      << "running FastPimpl code generator for: "
-      << reflectForPimplSettings.implParameterQualType;
-
-    DCHECK(reflectedClass->decl);
-    DCHECK(sourceTransformOptions.matchResult.Context);
-
-    uint64_t typeSize
-      = reflectedClass->ASTRecordSize + extra_size_bytes;
+  DCHECK(reflectedClass->decl);
+  DCHECK(sourceTransformOptions.matchResult.Context);
 
-    // assume it could be a subclass.
-    unsigned fieldAlign
-      = reflectedClass->ASTRecordNonVirtualAlignment;
+  uint64_t typeSize
+    = reflectedClass->ASTRecordSize + extra_size_bytes;
 
-    replacer += "::basis::FastPimpl<";
-    replacer += "\n";
+  // assume it could be a subclass.
+  unsigned fieldAlign
+    = reflectedClass->ASTRecordNonVirtualAlignment;
 
-    // usually it is "FooImpl"
-    DCHECK(!reflectForPimplSettings.implParameterQualType.empty());
-    replacer += reflectForPimplSettings.implParameterQualType;
+  CHECK((storageKind == PimplStorageKind::kVariant)
+        == !reflectForPimplSettings.alternativeParameterQualTypes.empty())
+    << "(pimpl) `storage = variant` requires alternatives "
+       "(`impl_1`, `impl_2`, etc.) and alternatives require "
+       "`storage = variant` for "
+    << reflectForPimplSettings.implParameterQualType;
 
-    // sizeof(Foo::FooImpl)
-    replacer += "\n";
-    replacer += ", /*Size*/";
-    replacer += std::to_string(typeSize);
+  // storage must fit any alternative
+  for(const std::string& alternative
+        : reflectForPimplSettings.alternativeParameterQualTypes)
+  {
+    reflection::ClassInfoPtr alternativeClass
+      = reflectFromCache(alternative);
+    DCHECK(alternativeClass);
 
-    // alignof(Foo::FooImpl)
-    replacer += "\n";
-    replacer += ", /*Alignment*/";
-    replacer += std::to_string(fieldAlign);
+    typeSize = std::max<uint64_t>(
+      typeSize
+      , alternativeClass->ASTRecordSize + extra_size_bytes);
 
-    replacer += "\n";
-    replacer += ", ::basis::pimpl::SizePolicy::AtLeast";
+    fieldAlign = std::max<unsigned>(
+      fieldAlign
+      , alternativeClass->ASTRecordNonVirtualAlignment);
+  }
 
-    replacer += "\n";
-    replacer += ", ::basis::pimpl::AlignPolicy::AtLeast";
+  // alternatives are builds of same impl
+  // for different ISA extensions
+  std::vector<std::string> cpuFeatures;
+  if(!isaOfAlternatives.empty()) {
+    CHECK(storageKind == PimplStorageKind::kVariant
+          && isaOfAlternatives.rbegin()->first
+             <= reflectForPimplSettings.alternativeParameterQualTypes.size())
+      << "(pimpl) `isa_N` requires `storage = variant` "
+         "with alternative `impl_N` for "
+      << reflectForPimplSettings.implParameterQualType;
 
-    replacer += "\n";
-    replacer += "> impl_;";
+    // `impl` is baseline
+    cpuFeatures.push_back(printCpuFeatures({}));
+    for(size_t i = 1;
+        i <= reflectForPimplSettings.alternativeParameterQualTypes.size();
+        i++)
+    {
+      auto it = isaOfAlternatives.find(i);
+      cpuFeatures.push_back(printCpuFeatures(
+        it != isaOfAlternatives.end()
+          ? it->second
+          : std::vector<std::string>{}));
+    }
   }
 
-  DVLOG(9)
-    << "applying source code transformation for: "
+  CHECK(inline_budget_bytes == -1
+        || storageKind == PimplStorageKind::kAuto)
+    << "(pimpl) inlineBudget requires `storage = auto` for "
     << reflectForPimplSettings.implParameterQualType;
-  // remove annotation from source file
-  clang_utils::replaceWith(
-    sourceTransformOptions.rewriter
-    , sourceTransformOptions.decl
-    , sourceTransformOptions.matchResult
-    , replacer);
 
-  return clang_utils::SourceTransformResult{nullptr};
-}
+  if(storageKind == PimplStorageKind::kAuto) {
+    const uint64_t inlineBudget
+      = inline_budget_bytes == -1
+        ? kDefaultInlineBudget
+        : inline_budget_bytes;
+
+    storageKind
+      = typeSize <= inlineBudget
+        ? PimplStorageKind::kInline
+        : PimplStorageKind::kPool;
+
+    LOG(INFO)
+      << "(pimpl) selected "
+      << (storageKind == PimplStorageKind::kInline
+          ? "inline" : "pool")
+      << " storage for "
+      << reflectForPimplSettings.implParameterQualType
+      << " (size "
+      << typeSize
+      << " bytes, inline budget "
+      << inlineBudget
+      << " bytes)";
+  }
 
-/// \todo ability to change generator template
-clang_utils::SourceTransformResult
-  pimplTooling::injectPimplMethodCalls(
-    const clang_utils::SourceTransformOptions& sourceTransformOptions)
-{
-  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // fully qualified, so storage type can be used
+  // outside of interface (see `injectPimplExternTemplates`)
+  // example: ::example_impl::FooImpl, ::example_impl::FooFastImpl
+  std::vector<std::string> implTypes{
+    printFullyQualifiedType(
+      reflectForPimplSettings.implArgQualType
+      , *sourceTransformOptions.matchResult.Context)};
+  for(const clang::QualType& alternative
+        : reflectForPimplSettings.alternativeArgQualTypes)
+  {
+    implTypes.push_back(printFullyQualifiedType(
+      alternative
+      , *sourceTransformOptions.matchResult.Context));
+  }
 
-  VLOG(9)
-    << "injectPimplMethodCalls called...";
+  // example: ::basis::FastPimpl<::FooImpl, Size, Alignment>
+  std::string storageType;
 
-  clang::SourceManager &SM
-    = sourceTransformOptions.rewriter.getSourceMgr();
+  switch(storageKind) {
+    /**
+     * generates code similar to:
+     *  basis::FastPimpl<FooImpl, Size, Alignment> impl_;
+     **/
+    case PimplStorageKind::kInline: {
+      DVLOG(9)
+        << "running FastPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  clang::PrintingPolicy printingPolicy(
-    sourceTransformOptions.rewriter.getLangOpts());
+      storageType = printInlinePimplStorageType(
+        implTypes.front()
+        , typeSize
+        , fieldAlign);
+      break;
+    }
+    /**
+     * generates code similar to:
+     *  ::flex_pimpl_plugin::PoolPimpl<FooImpl> impl_;
+     **/
+    case PimplStorageKind::kPool: {
+      DVLOG(9)
+        << "running PoolPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  const clang::LangOptions& langOptions
-    = sourceTransformOptions.rewriter.getLangOpts();
+      LOG_IF(WARNING, extra_size_bytes != 0)
+        << "(pimpl) sizePadding is ignored by pool storage of "
+        << reflectForPimplSettings.implParameterQualType;
 
-  const clang::CXXRecordDecl *node =
-    sourceTransformOptions.matchResult.Nodes.getNodeAs<
-      clang::CXXRecordDecl>("bind_gen");
+      storageType = printPoolPimplStorageType(
+        implTypes.front());
+      break;
+    }
+    /**
+     * generates code similar to:
+     *  ::flex_pimpl_plugin::LazyPimpl<FooImpl, Size, Alignment> impl_;
+     **/
+    case PimplStorageKind::kLazy: {
+      DVLOG(9)
+        << "running LazyPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  ReflectForPimplSettings reflectForPimplSettings
-    = getReflectForPimplSettings(sourceTransformOptions);
+      // first const call constructs impl, so it must not run
+      // concurrently with other const calls under shared lock
+      CHECK(getImplTraits(reflectForPimplSettings).locking
+            != PimplLocking::kShared)
+        << "(pimpl) `locking = shared` is not supported by "
+        << "`storage = lazy` of "
+        << reflectForPimplSettings.implParameterQualType
+        << ", use `locking = exclusive`";
+
+      storageType = printLazyPimplStorageType(
+        implTypes.front()
+        , typeSize
+        , fieldAlign);
+      break;
+    }
+    /**
+     * generates code similar to:
+     *  ::flex_pimpl_plugin::VariantPimpl<
+     *    Size, Alignment, FooImpl, FooFastImpl> impl_;
+     **/
+    case PimplStorageKind::kVariant: {
+      DVLOG(9)
+        << "running VariantPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  DCHECK(reflectForPimplSettings.implArgQualType
-          ->getAsCXXRecordDecl());
-  CHECK(reflectForPimplSettings.implArgQualType
-          ->getAsCXXRecordDecl())
-    << "must be CXXRecordDecl: "
-    << reflectForPimplSettings.implParameterQualType;
+      /**
+       * generates code similar to:
+       *  ::flex_pimpl_plugin::CpuDispatchPimpl<
+       *    ::flex_pimpl_plugin::pimpl::CpuFeatureList<...>
+       *    , Size, Alignment, FooImpl, FooAvx2Impl> impl_;
+       **/
+      storageType = cpuFeatures.empty()
+        ? printVariantPimplStorageType(
+            implTypes
+            , typeSize
+            , fieldAlign)
+        : printCpuDispatchPimplStorageType(
+            implTypes
+            , cpuFeatures
+            , typeSize
+            , fieldAlign);
+      break;
+    }
+    /**
+     * generates code similar to:
+     *  ::flex_pimpl_plugin::CowPimpl<FooImpl> impl_;
+     **/
+    case PimplStorageKind::kCow: {
+      DVLOG(9)
+        << "running CowPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  /// \todo support custom namespaces
-  reflection::NamespacesTree m_namespaces;
+      LOG_IF(WARNING, extra_size_bytes != 0)
+        << "(pimpl) sizePadding is ignored by copy-on-write storage of "
+        << reflectForPimplSettings.implParameterQualType;
 
-  DCHECK(sourceTransformOptions.matchResult.Context);
-  reflection::AstReflector reflector(
-    sourceTransformOptions.matchResult.Context);
+      storageType = printCowPimplStorageType(
+        implTypes.front());
+      break;
+    }
+    /**
+     * generates code similar to:
+     *  ::flex_pimpl_plugin::RcuPimpl<FooImpl> impl_;
+     **/
+    case PimplStorageKind::kRcu: {
+      DVLOG(9)
+        << "running RcuPimpl code generator for: "
+        << reflectForPimplSettings.implParameterQualType;
 
-  DCHECK(reflectForPimplSettings.implArgQualType
-          ->getAsCXXRecordDecl());
-  reflection::ClassInfoPtr reflectedClass
-    = reflectFromCache(
-        reflectForPimplSettings);
-  DCHECK(reflectedClass);
+      LOG_IF(WARNING, extra_size_bytes != 0)
+        << "(pimpl) sizePadding is ignored by rcu storage of "
+        << reflectForPimplSettings.implParameterQualType;
+
+      // non-const forwarders modify copy of impl
+      CHECK(getImplTraits(reflectForPimplSettings).isCopyable)
+        << "(pimpl) `storage = rcu` requires copyable impl: "
+        << reflectForPimplSettings.implParameterQualType;
+
+      storageType = printRcuPimplStorageType(
+        implTypes.front());
+      break;
+    }
+    case PimplStorageKind::kAuto: {
+      NOTREACHED();
+      break;
+    }
+  }
+
+  replacer += printStorageMember(storageType);
+
+  // table of forwarders is defined in .cc file of interface
+  if(!cpuFeatures.empty()) {
+    replacer += "\n";
+    replacer += printCpuDispatchDecl();
+  }
+
+  const PimplImplTraits& implTraits
+    = getImplTraits(reflectForPimplSettings);
+
+  // used by forwarders of methods with `locking` policy
+  if(implTraits.locking != PimplLocking::kNone) {
+    DVLOG(9)
+      << "adding mutex for locked forwarders of: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printForwardingMutexMember(implTraits.locking);
+  }
+
+  // used by forwarders of methods with `memoize` policy
+  bool areMemoCachesNothrowMovable = true;
+  for(const PimplMemoCache& memoCache : implTraits.memoCaches) {
+    DVLOG(9)
+      << "adding result cache "
+      << memoCache.name
+      << " of: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printMemoCacheMember(memoCache);
+    areMemoCachesNothrowMovable
+      = areMemoCachesNothrowMovable && memoCache.isNothrowMovable;
+  }
+
+  // variant is relocatable if every alternative is relocatable,
+  // same for move and copy
+  bool areAlternativesTriviallyRelocatable = true;
+  bool areAlternativesNothrowMovable = true;
+  bool areAlternativesCopyable = true;
+  for(const std::string& alternative
+        : reflectForPimplSettings.alternativeParameterQualTypes)
+  {
+    const PimplImplTraits& alternativeTraits
+      = getImplTraits(alternative);
+    areAlternativesTriviallyRelocatable
+      = areAlternativesTriviallyRelocatable
+        && alternativeTraits.isTriviallyRelocatable;
+    areAlternativesNothrowMovable
+      = areAlternativesNothrowMovable
+        && alternativeTraits.isNothrowMovable;
+    areAlternativesCopyable
+      = areAlternativesCopyable
+        && alternativeTraits.isCopyable;
+  }
+
+  // interface that stores impl, usually it is `Foo`
+  const clang::CXXRecordDecl* interfaceDecl
+    = clang::dyn_cast_or_null<clang::CXXRecordDecl>(node->getParent());
+  CHECK(interfaceDecl)
+    << "(pimpl) storage must be injected into class: "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // user may declare copy, move or swap of interface manually
+  const bool hasSpecialMembers
+    = !interfaceDecl->hasUserDeclaredCopyConstructor()
+      && !interfaceDecl->hasUserDeclaredCopyAssignment()
+      && !interfaceDecl->hasUserDeclaredMoveConstructor()
+      && !interfaceDecl->hasUserDeclaredMoveAssignment()
+      && interfaceDecl->lookup(
+           &sourceTransformOptions.matchResult.Context->Idents.get("swap"))
+           .empty();
+
+  // generated copy and move with `locking` transfer only impl,
+  // so other members of interface would not be copied
+  CHECK(!hasSpecialMembers
+        || implTraits.locking == PimplLocking::kNone
+        || interfaceDecl->field_empty())
+    << "(pimpl) interface with `locking` and own data members"
+       " must declare copy, move and swap manually: "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // pool, copy-on-write and rcu storage move single pointer
+  const bool isNothrowMovable
+    = (storageKind == PimplStorageKind::kPool
+        || storageKind == PimplStorageKind::kCow
+        || storageKind == PimplStorageKind::kRcu
+        || (implTraits.isNothrowMovable
+            && areAlternativesNothrowMovable))
+      && areMemoCachesNothrowMovable
+      && areMembersNothrowMovable(
+           interfaceDecl
+           , *sourceTransformOptions.matchResult.Context);
+
+  // copy operations of storage are explicitly instantiated
+  // only for copyable impl
+  const bool isImplCopyable
+    = implTraits.isCopyable
+      && areAlternativesCopyable;
+
+  const bool isCopyable
+    = isImplCopyable
+      && areMembersCopyable(
+           interfaceDecl
+           , *sourceTransformOptions.matchResult.Context);
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   Foo(Foo&& other) noexcept;
+   *   Foo& operator=(Foo&& other) noexcept;
+   *   void swap(Foo& other) noexcept;
+   *  private:
+   **/
+  if(hasSpecialMembers) {
+    DVLOG(9)
+      << "generating move operations and swap for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    LOG_IF(WARNING, !isNothrowMovable)
+      << "(pimpl) move operations of interface are not noexcept, "
+         "because impl or members of interface may throw on move: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += printSpecialMemberDecls(
+      interfaceDecl->getNameAsString()
+      , isNothrowMovable
+      , isCopyable);
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  } else {
+    VLOG(9)
+      << "interface declares copy, move or swap manually,"
+         " skipped generation of special members for: "
+      << reflectForPimplSettings.implParameterQualType;
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+   *   explicit Foo(std::pmr::memory_resource* resource);
+   *   Foo(std::allocator_arg_t, const allocator_type& alloc);
+   *   Foo(std::allocator_arg_t, const allocator_type& alloc, Foo&& other);
+   *   allocator_type get_allocator() const noexcept;
+   *  private:
+   **/
+  if(isPmrAllocatorAware) {
+    CHECK(implTraits.isPmrAllocatorAware)
+      << "(pimpl) `allocator = pmr` requires impl with "
+         "`allocator_type` (std::pmr::polymorphic_allocator), "
+         "constructor from allocator and `get_allocator()`: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // lazy storage constructs impl without arguments,
+    // variant storage does not know alternative to construct
+    CHECK(storageKind == PimplStorageKind::kInline
+          || storageKind == PimplStorageKind::kPool)
+      << "(pimpl) `allocator = pmr` requires inline or pool storage: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    DVLOG(9)
+      << "generating allocator-aware constructors for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += printPmrInterfaceDecls(
+      interfaceDecl->getNameAsString()
+      , isCopyable);
+    replacer += "\n";
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  // storage of pool is single pointer,
+  // inline storage is relocatable if impl is relocatable
+  /// \note other members of interface must be relocatable too,
+  /// mutex used by `locking` policy is not relocatable,
+  /// result caches of `memoize` policy may store any type
+  const bool isTriviallyRelocatable
+    = implTraits.locking == PimplLocking::kNone
+      && implTraits.memoCaches.empty()
+      && (storageKind == PimplStorageKind::kPool
+          || storageKind == PimplStorageKind::kCow
+          || (implTraits.isTriviallyRelocatable
+              && areAlternativesTriviallyRelocatable))
+      && areMembersTriviallyRelocatable(
+           interfaceDecl
+           , *sourceTransformOptions.matchResult.Context);
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   using IsRelocatable = std::true_type;
+   *  private:
+   **/
+  if(isTriviallyRelocatable) {
+    DVLOG(9)
+      << "marking interface as trivially relocatable for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += "// see ::flex_pimpl_plugin::pimpl::IsTriviallyRelocatable";
+    replacer += "\n";
+    replacer += "using IsRelocatable = std::true_type;";
+    replacer += "\n";
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  {
+    auto it = storageCache_.find(
+      reflectForPimplSettings.implParameterQualType);
+
+    if(it != storageCache_.end()) {
+      CHECK(false)
+        << "storage already injected for "
+        << reflectForPimplSettings.implParameterQualType;
+    }
+
+    PimplStorageSettings& storageSettings
+      = storageCache_[reflectForPimplSettings.implParameterQualType];
+    storageSettings.kind = storageKind;
+    storageSettings.alternatives
+      = reflectForPimplSettings.alternativeParameterQualTypes;
+    storageSettings.isPmrAllocatorAware = isPmrAllocatorAware;
+    storageSettings.cpuFeatures = cpuFeatures;
+    storageSettings.storageType = storageType;
+    storageSettings.implTypes = implTypes;
+    storageSettings.typeSize = typeSize;
+    storageSettings.typeAlignment = fieldAlign;
+    storageSettings.interfaceName = interfaceDecl->getNameAsString();
+    storageSettings.hasSpecialMembers = hasSpecialMembers;
+    storageSettings.isNothrowMovable = isNothrowMovable;
+    storageSettings.isCopyable = isCopyable;
+    storageSettings.isImplCopyable = isImplCopyable;
+
+    VLOG(9)
+      << "populated storage cache with key: "
+      << reflectForPimplSettings.implParameterQualType;
+  }
+
+  DVLOG(9)
+    << "applying source code transformation for: "
+    << reflectForPimplSettings.implParameterQualType;
+  // remove annotation from source file
+  clang_utils::replaceWith(
+    sourceTransformOptions.rewriter
+    , sourceTransformOptions.decl
+    , sourceTransformOptions.matchResult
+    , replacer);
+
+  return clang_utils::SourceTransformResult{nullptr};
+}
+
+/// \todo ability to change generator template
+clang_utils::SourceTransformResult
+  pimplTooling::injectPimplMethodCalls(
+    const clang_utils::SourceTransformOptions& sourceTransformOptions)
+{
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  VLOG(9)
+    << "injectPimplMethodCalls called...";
+
+  clang::SourceManager &SM
+    = sourceTransformOptions.rewriter.getSourceMgr();
+
+  clang::PrintingPolicy printingPolicy(
+    sourceTransformOptions.rewriter.getLangOpts());
+
+  const clang::LangOptions& langOptions
+    = sourceTransformOptions.rewriter.getLangOpts();
+
+  const clang::CXXRecordDecl *node =
+    sourceTransformOptions.matchResult.Nodes.getNodeAs<
+      clang::CXXRecordDecl>("bind_gen");
+
+  ReflectForPimplSettings reflectForPimplSettings
+    = getReflectForPimplSettings(sourceTransformOptions);
+
+  DCHECK(reflectForPimplSettings.implArgQualType
+          ->getAsCXXRecordDecl());
+  CHECK(reflectForPimplSettings.implArgQualType
+          ->getAsCXXRecordDecl())
+    << "must be CXXRecordDecl: "
+    << reflectForPimplSettings.implParameterQualType;
+
+  /// \todo support custom namespaces
+  reflection::NamespacesTree m_namespaces;
+
+  DCHECK(sourceTransformOptions.matchResult.Context);
+  reflection::AstReflector reflector(
+    sourceTransformOptions.matchResult.Context);
+
+  DCHECK(reflectForPimplSettings.implArgQualType
+          ->getAsCXXRecordDecl());
+  reflection::ClassInfoPtr reflectedClass
+    = reflectFromCache(
+        reflectForPimplSettings);
+  DCHECK(reflectedClass);
 
   CHECK(!reflectedClass->methods.empty())
     << "no methods in "
     << reflectedClass->name;
 
-  bool without_method_body = false;
+  bool without_method_body = false;
+
+  bool inline_forwarders = false;
+
+  // forwarders call impl via table that can be replaced at runtime
+  bool hot_swap = false;
+
+  // interface gets `findMethod(name)` with table of invokers
+  bool by_name = false;
+
+  // extern "C" facade for FFI, see `PimplCApiFunction`
+  bool c_api = false;
+
+  // interface gets `snapshot` and `restore` of impl state
+  bool snapshot = false;
+
+  /**
+   * parse arguments from annotation attribute
+   * EXAMPLE:
+      template<typename impl = FooImpl>
+      class
+        my_annotation_attr(
+          "without_method_body"
+        )
+      PimplMethodDeclsInjector
+      {};
+    *
+    * parsed argument value is:
+        without_method_body
+   **/
+  {
+    /// \todo refactor similar to https://github.com/jarro2783/cxxopts
+    flexlib::args annotationArgs =
+      sourceTransformOptions.func_with_args.parsed_func_.args_;
+    for(const auto& arg : annotationArgs.as_vec_)
+    {
+      if(arg.name_.empty() && arg.value_.empty()) {
+        continue;
+      }
+
+      if(arg.value_ == "without_method_body") {
+        DCHECK(!without_method_body);
+        without_method_body = true;
+      } else if(arg.value_ == "inline_forwarders") {
+        DCHECK(!inline_forwarders);
+        inline_forwarders = true;
+      } else if(arg.value_ == "hot_swap") {
+        DCHECK(!hot_swap);
+        hot_swap = true;
+      } else if(arg.value_ == "by_name") {
+        DCHECK(!by_name);
+        by_name = true;
+      } else if(arg.value_ == "c_api") {
+        DCHECK(!c_api);
+        c_api = true;
+      } else if(arg.value_ == "snapshot") {
+        DCHECK(!snapshot);
+        snapshot = true;
+      } else {
+        CHECK(false)
+          << "(pimpl) unknown argument: "
+          << arg.name_
+          << " with value: "
+          << arg.value_;
+      }
+    }
+  }
+
+  CHECK(!inline_forwarders
+        || without_method_body
+        || !reflectForPimplSettings.interfaceParameterQualType.empty())
+    << "(pimpl) inline forwarders require `interface` argument for "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // facade is defined in `.cc` file
+  CHECK(!c_api
+        || (!without_method_body
+            && !inline_forwarders
+            && !reflectForPimplSettings.interfaceParameterQualType.empty()))
+    << "(pimpl) c_api requires `interface` argument in `.cc` file for "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // snapshot is defined in `.cc` file that can see impl
+  CHECK(!snapshot
+        || without_method_body
+        || (!inline_forwarders
+            && !reflectForPimplSettings.interfaceParameterQualType.empty()))
+    << "(pimpl) snapshot requires `interface` argument in `.cc` file for "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // inlined forwarders can not be replaced
+  CHECK(!hot_swap || !inline_forwarders)
+    << "(pimpl) hot_swap is not compatible with inline forwarders of "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // static forwarders are defined in `.inl` file
+  // that can see impl, example: `Foo::Inline::baz(foo)`
+  const bool printInlineForwarders
+    = inline_forwarders && !without_method_body;
+
+  // storage of interface is unknown if `injectPimplStorage`
+  // was not processed, assume storage that provides `operator->`
+  PimplStorageSettings storageSettings;
+  {
+    auto it = storageCache_.find(
+      reflectForPimplSettings.implParameterQualType);
+    if(it != storageCache_.end()) {
+      storageSettings = it->second;
+    } else {
+      DVLOG(9)
+        << "storage of "
+        << reflectForPimplSettings.implParameterQualType
+        << " not in cache, using default storage";
+    }
+  }
+
+  // alternatives are known from annotation (usually in header
+  // where storage is not injected yet) or from injected storage
+  std::vector<std::string> alternatives
+    = reflectForPimplSettings.alternativeParameterQualTypes;
+  {
+    auto it = storageCache_.find(
+      reflectForPimplSettings.implParameterQualType);
+    if(it != storageCache_.end()) {
+      CHECK(alternatives.empty()
+            || alternatives == it->second.alternatives)
+        << "(pimpl) alternatives must match injected storage of "
+        << reflectForPimplSettings.implParameterQualType;
+      alternatives = it->second.alternatives;
+    }
+  }
+
+  const PimplImplTraits& implTraits
+    = getImplTraits(reflectForPimplSettings);
+
+  // methods annotated with `_pimplBatch()`
+  std::vector<PimplBatchMethod> batchMethods;
+
+  // used by `isa_1`, `isa_2`, etc. of `storage = variant`,
+  // forwarders of methods that are not templates
+  // call impl via table of function pointers
+  const bool isCpuDispatch
+    = !storageSettings.cpuFeatures.empty()
+      && !without_method_body
+      && !printInlineForwarders
+      && !reflectForPimplSettings.interfaceParameterQualType.empty();
+
+  // forwarders of methods that are not templates
+  // call impl via table of `hot_swap`
+  const bool isHotSwap
+    = hot_swap
+      && !without_method_body
+      && !reflectForPimplSettings.interfaceParameterQualType.empty();
+  CHECK(!isHotSwap || !isCpuDispatch)
+    << "(pimpl) hot_swap is not compatible with `isa_N` of "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // entries of table used by `isCpuDispatch` or `isHotSwap`
+  std::vector<PimplDispatchEntry> dispatchEntries;
+
+  // methods that can be called via `findMethod(name)`
+  const bool isByName
+    = by_name
+      && !without_method_body
+      && !printInlineForwarders
+      && !reflectForPimplSettings.interfaceParameterQualType.empty();
+  std::vector<PimplNamedMethod> namedMethods;
+
+  // functions of extern "C" facade, see `c_api` argument
+  std::vector<PimplCApiFunction> cApiFunctions;
+  const std::string cApiPrefix
+    = c_api
+      ? printCApiPrefix(reflectForPimplSettings.interfaceParameterQualType)
+      : std::string();
+  // number of entries with same method name
+  std::map<std::string, size_t> dispatchOverloads;
+
+  std::string replacer;
+
+  /**
+   * generates code similar to:
+   *  struct Foo::Inline {
+   *    static std::string baz(Foo& self) { return self.impl_->baz(); }
+   *  };
+   **/
+  if(printInlineForwarders) {
+    replacer += "struct ";
+    replacer += reflectForPimplSettings.interfaceParameterQualType;
+    replacer += "::";
+    replacer += kInlineForwardersName;
+    replacer += " {";
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  std::string foo(int arg1) { return impl->foo(arg1); };
+   **/
+  {
+    DVLOG(9)
+      << "running FastPimpl method call generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    for(const reflection::MethodInfoPtr& method
+         : reflectedClass->methods)
+    {
+      DCHECK(method);
+
+      const bool needPrint = isPimplMethod(method);
+      if(!needPrint) {
+        continue;
+      }
+
+      // forwarder must be able to call method
+      // regardless of stored alternative
+      if(!alternatives.empty()
+         && !isImplementedByAlternatives(
+               method.get(), implTraits, alternatives))
+      {
+        LOG(WARNING)
+          << "(pimpl) skipped method "
+          << method->name
+          << " from "
+          << reflectForPimplSettings.implParameterQualType
+          << " because it is not implemented by all alternatives";
+        continue;
+      }
+
+      const PimplMethodTraits& methodTraits
+        = getMethodTraits(implTraits, method.get());
+
+      // impl may be freed right after forwarder returns
+      // (const forwarder leaves read section,
+      // published clone is retired by next write)
+      CHECK(storageSettings.kind != PimplStorageKind::kRcu
+            || !methodTraits.returnsView)
+        << "(pimpl) method "
+        << method->name
+        << " returns reference, pointer or view into impl,"
+           " not supported by `storage = rcu` of "
+        << reflectForPimplSettings.implParameterQualType;
+
+      // caller may modify impl via returned view after interface
+      // is copied, so copy that shares impl would see the change
+      CHECK(storageSettings.kind != PimplStorageKind::kCow
+            || methodTraits.isConst
+            || !methodTraits.returnsView)
+        << "(pimpl) non-const method "
+        << method->name
+        << " returns reference, pointer or view into impl,"
+           " not supported by `storage = cow` of "
+        << reflectForPimplSettings.implParameterQualType;
+
+      if(methodTraits.hasBatchForwarder) {
+        batchMethods.push_back(PimplBatchMethod{
+          method->name
+          , methodParamDecls(method->params)
+          , methodTraits.paramNames
+          , methodTraits.batchResultType
+          , methodTraits.isConst
+        });
+      }
+
+      // type of template arguments is unknown
+      if(isByName && !method->isTemplate()) {
+        namedMethods.push_back(PimplNamedMethod{
+          method->name
+          , methodTraits.invokerArgs
+          , methodTraits.paramNameList.size()
+          , methodTraits.batchResultType
+          , methodTraits.isConst
+        });
+      }
+
+      // names of `_create` and `_destroy` are reserved
+      if(c_api
+         && (!methodTraits.cApi.isSupported
+             || method->name == "destroy"
+             || base::StartsWith(
+                  method->name
+                  , "create"
+                  , base::CompareCase::SENSITIVE)))
+      {
+        LOG(WARNING)
+          << "(pimpl) method "
+          << method->name
+          << " from "
+          << reflectForPimplSettings.implParameterQualType
+          << " is not exported to C facade";
+      } else if(c_api) {
+        cApiFunctions.push_back(PimplCApiFunction{
+          cApiPrefix + "_" + method->name
+          , method->name
+          , methodTraits.isConst
+          , methodTraits.cApi
+        });
+      }
+
+      const bool isMemoized = !methodTraits.memoCache.name.empty();
+
+      // example: `foo(::std::move(arg1))`
+      /// \note arguments of memoized method are also used as cache key,
+      /// so they are not moved
+      const std::string methodCall
+        = method->name
+          + "("
+          + (isMemoized
+              ? methodTraits.paramNames
+              : methodTraits.forwardedParams)
+          + ")";
+
+      // impl may be changed by non-const method,
+      // so cached results become invalid
+      const bool needMemoInvalidation
+        = !methodTraits.isConst
+          && !implTraits.memoCaches.empty();
+
+      const std::string methodForwarding
+         = clang_utils::printMethodForwarding(
+             method
+             , clang_utils::kSeparatorWhitespace
+            // what method printer is allowed to print
+             , MethodPrinter::Forwarding::Options::ALL
+               & ~MethodPrinter::Forwarding::Options::VIRTUAL);
+      const std::string methodTrailing
+         = clang_utils::printMethodTrailing(
+             method
+             , clang_utils::kSeparatorWhitespace
+             // what method printer is allowed to print
+             , MethodPrinter::Trailing::Options::NOTHING
+               | MethodPrinter::Trailing::Options::CONST
+               | MethodPrinter::Trailing::Options::NOEXCEPT);
+        // with profile only hot methods are inlined
+        // (if profile lists impl class),
+        // policy of method overrides profile
+        const bool needInlineForwarder
+          = methodTraits.policy.forwarding == PimplForwarding::kInline
+            || (methodTraits.policy.forwarding
+                  == PimplForwarding::kDefault
+                && (!isProfiledClass(
+                      reflectForPimplSettings.implParameterQualType)
+                    || methodTraits.hotness == PimplMethodHotness::kHot));
+        if(printInlineForwarders && !needInlineForwarder) {
+          VLOG(9)
+            << "skipped inline forwarder of method "
+            << method->name
+            << " because of policy or profile";
+          continue;
+        }
+
+        if(method->isTemplate())
+        {
+          replacer += "template<";
+          replacer += expandTemplateNames(method->tplParams);
+          replacer += ">";
+        } // method->isTemplate
+
+        // example: `[[gnu::hot]] `
+        replacer += printHotnessAttributes(methodTraits.hotness);
+
+        if(printInlineForwarders) {
+          replacer += "static ";
+          replacer += methodForwarding;
+          replacer += " ";
+          replacer += method->name;
+          replacer += "(";
+          replacer += methodTraits.isConst ? "const " : "";
+          replacer += reflectForPimplSettings.interfaceParameterQualType;
+          replacer += "& self";
+          if(!method->params.empty()) {
+            replacer += clang_utils::kSeparatorCommaAndWhitespace;
+            replacer += methodParamDecls(method->params);
+          }
+          replacer += ")";
+          replacer += " ";
+          replacer += clang_utils::printMethodTrailing(
+            method
+            , clang_utils::kSeparatorWhitespace
+            , MethodPrinter::Trailing::Options::NOTHING
+              | MethodPrinter::Trailing::Options::NOEXCEPT);
+          replacer += "\n";
+          replacer += "{";
+          replacer += "\n";
+          replacer += printForwarderLock(
+            methodTraits.policy.locking
+            , methodTraits.isConst && !isMemoized
+            , "self.");
+          if(needMemoInvalidation) {
+            replacer += printMemoCacheInvalidation(
+              implTraits.memoCaches
+              , "self.");
+          }
+          {
+            const std::string forwarderBody
+              = printForwarderBody(
+                  storageSettings.kind
+                  , methodTraits.isConst
+                  , alternatives.size()
+                  , "self."
+                  , methodCall);
+            replacer += isMemoized
+              ? printMemoizedForwarderBody(
+                  methodTraits.memoCache.name
+                  , "self."
+                  , methodTraits.paramNames
+                  , forwarderBody)
+              : forwarderBody;
+          }
+          replacer += "\n";
+          replacer += "}";
+          replacer += "\n";
+          continue;
+        }
+
+        replacer += methodForwarding;
+        replacer += " ";
+        if(!reflectForPimplSettings.interfaceParameterQualType.empty()) {
+          // usually it is `::Foo` part out of `::Foo::bar()`
+          // where Foo is class that stores implementation
+          replacer += reflectForPimplSettings.interfaceParameterQualType;
+          replacer += "::";
+          VLOG(9)
+            << "creating methods of class: "
+            << reflectForPimplSettings.interfaceParameterQualType;
+        }
+        replacer += method->name;
+        replacer += "(";
+        replacer += methodParamDecls(method->params);
+        replacer += ")";
+        replacer += " ";
+        replacer += methodTrailing;
+
+        if(!without_method_body) {
+          replacer += "\n";
+          replacer += "{";
+          replacer += "\n";
+          replacer += printForwarderLock(
+            methodTraits.policy.locking
+            , methodTraits.isConst && !isMemoized
+            , "" // forwarder is member of interface
+          );
+          if(needMemoInvalidation) {
+            replacer += printMemoCacheInvalidation(
+              implTraits.memoCaches
+              , "" // forwarder is member of interface
+            );
+          }
+          std::string dispatchEntryName;
+          if((isCpuDispatch || isHotSwap) && !method->isTemplate()) {
+            // overloads get separate entries
+            dispatchEntryName = method->name;
+            const size_t overloadIndex
+              = dispatchOverloads[method->name]++;
+            if(overloadIndex) {
+              dispatchEntryName += "_" + std::to_string(overloadIndex);
+            }
+            dispatchEntries.push_back(PimplDispatchEntry{
+              dispatchEntryName
+              , methodTraits.returnType
+              , methodParamDecls(method->params)
+              // entry owns its parameters
+              , method->name + "(" + methodTraits.forwardedParams + ")"
+              , methodTraits.isConst
+            });
+          }
+          {
+            const std::string forwarderBody
+              = dispatchEntryName.empty()
+                ? printForwarderBody(
+                    storageSettings.kind
+                    , methodTraits.isConst
+                    , alternatives.size()
+                    , "" // forwarder is member of interface
+                    , methodCall)
+                : isHotSwap
+                  ? printHotSwapCall(
+                      dispatchEntryName
+                      , isMemoized
+                        ? methodTraits.paramNames
+                        : methodTraits.forwardedParams)
+                  : printCpuDispatchCall(
+                      dispatchEntryName
+                      , isMemoized
+                        ? methodTraits.paramNames
+                        : methodTraits.forwardedParams);
+            replacer += isMemoized
+              ? printMemoizedForwarderBody(
+                  methodTraits.memoCache.name
+                  , "" // forwarder is member of interface
+                  , methodTraits.paramNames
+                  , forwarderBody)
+              : forwarderBody;
+          }
+          replacer += "\n";
+          replacer += "}";
+          replacer += "\n";
+
+          /**
+           * forwarder of method template is visible only in `.cc` file,
+           * so generates code similar to:
+           *  template ::size_t example_interface::Foo::describe<int>(
+           *    const ::std::enable_if_t<true, int> &) const;
+           **/
+          if(!reflectForPimplSettings.interfaceParameterQualType.empty()) {
+            for(const PimplMethodInstantiation& instantiation
+                  : methodTraits.instantiations)
+            {
+              replacer += printMethodInstantiation(
+                reflectForPimplSettings.interfaceParameterQualType
+                , method->name
+                , instantiation
+                , false // isExternDecl
+              );
+              replacer += "\n";
+            }
+          }
+        } else {
+          replacer += ";";
+          replacer += "\n";
+        }
+
+        /**
+         * generates code similar to:
+         *  ::std::future<int> foo_async(int arg) const;
+         **/
+        if(methodTraits.policy.isAsync) {
+          if(without_method_body) {
+            replacer += printAsyncForwarderDecl(
+              method->name
+              , methodParamDecls(method->params)
+              , methodTraits.batchResultType
+              , methodTraits.isConst);
+          } else {
+            CHECK(!reflectForPimplSettings.interfaceParameterQualType.empty())
+              << "(pimpl) async forwarders require `interface` for "
+              << reflectForPimplSettings.implParameterQualType;
+            replacer += printAsyncForwarderDef(
+              reflectForPimplSettings.interfaceParameterQualType
+              , method->name
+              , methodParamDecls(method->params)
+              , methodTraits.paramNameList
+              , methodTraits.forwardedParams
+              , methodTraits.batchResultType
+              , methodTraits.isConst);
+          }
+        }
+    }
+  }
+
+  if(printInlineForwarders) {
+    replacer += "};";
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  struct Foo::ImplDispatch {
+   *    static const ImplDispatch kTables[2];
+   *    int (*foo)(const Foo& self, int arg1);
+   *  };
+   *  const Foo::ImplDispatch Foo::ImplDispatch::kTables[2] = {...};
+   **/
+  /// \note table must be defined before forwarders that use it
+  if(isCpuDispatch) {
+    DVLOG(9)
+      << "running dispatch table generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer = printCpuDispatchTable(
+                 reflectForPimplSettings.interfaceParameterQualType
+                 , storageSettings.cpuFeatures.size()
+                 , dispatchEntries)
+               + replacer;
+  }
+
+  /**
+   * generates code similar to:
+   *  struct Foo::ImplTable {
+   *    static const ImplTable kBuiltin;
+   *    static ::flex_pimpl_plugin::pimpl::HotSwapSlot<ImplTable> current;
+   *    ::flex_pimpl_plugin::pimpl::ImplLayout layout;
+   *    int (*foo)(const Foo& self, int arg1);
+   *  };
+   *  ...
+   *  bool Foo::swapImplTable(const ImplTable* table) {...}
+   **/
+  if(isHotSwap) {
+    DVLOG(9)
+      << "running hot swap table generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    CHECK(!storageSettings.implTypes.empty())
+      << "(pimpl) hot_swap requires injected storage of "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // example: `::std::string data_;`
+    std::string fieldsSignature;
+    for(const PimplFieldInfo& field : implTraits.fields) {
+      fieldsSignature += field.type;
+      fieldsSignature += " ";
+      fieldsSignature += field.name;
+      fieldsSignature += ";";
+    }
+
+    replacer = printHotSwapTable(
+                 reflectForPimplSettings.interfaceParameterQualType
+                 , storageSettings.implTypes.front()
+                 , storageSettings.kind
+                 , alternatives.size()
+                 , fieldsSignature
+                 , dispatchEntries)
+               + replacer;
+  }
+
+  /**
+   * generates code similar to:
+   *  const ::flex_pimpl_plugin::pimpl::MethodEntry*
+   *    Foo::findMethod(::std::string_view name) noexcept
+   *  {
+   *    static constexpr ::std::array<...> kMethods{{...}};
+   *    return ::flex_pimpl_plugin::pimpl::findMethodEntry(
+   *      kMethods, seed, name);
+   *  }
+   **/
+  if(isByName) {
+    DVLOG(9)
+      << "running method table generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // name of overloaded method is ambiguous
+    std::map<std::string, size_t> nameCounts;
+    for(const PimplNamedMethod& namedMethod : namedMethods) {
+      nameCounts[namedMethod.name]++;
+    }
+    namedMethods.erase(
+      std::remove_if(
+        namedMethods.begin()
+        , namedMethods.end()
+        , [&nameCounts, &reflectForPimplSettings](
+            const PimplNamedMethod& namedMethod)
+          {
+            const bool isOverloaded = nameCounts[namedMethod.name] > 1;
+            LOG_IF(WARNING, isOverloaded)
+              << "(pimpl) overloaded method "
+              << namedMethod.name
+              << " from "
+              << reflectForPimplSettings.implParameterQualType
+              << " can not be called by name";
+            return isOverloaded;
+          })
+      , namedMethods.end());
+
+    replacer += printMethodTableDef(
+      reflectForPimplSettings.interfaceParameterQualType
+      , namedMethods);
+  }
+
+  /**
+   * generates code similar to:
+   *  extern "C" {
+   *  void example_interface_Foo_destroy(
+   *    example_interface_Foo* self) noexcept {...}
+   *  example_interface_Foo* example_interface_Foo_create(void) noexcept {...}
+   *  int example_interface_Foo_foo(
+   *    const example_interface_Foo* self, int arg1) noexcept {...}
+   *  } // extern "C"
+   *
+   * and writes declarations into `example_interface_Foo_c_api.h`
+   * in output directory
+   **/
+  if(c_api) {
+    DVLOG(9)
+      << "running C facade generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // C has no overloading
+    std::map<std::string, size_t> nameCounts;
+    for(const PimplCApiFunction& function : cApiFunctions) {
+      nameCounts[function.name]++;
+    }
+    cApiFunctions.erase(
+      std::remove_if(
+        cApiFunctions.begin()
+        , cApiFunctions.end()
+        , [&nameCounts, &reflectForPimplSettings](
+            const PimplCApiFunction& function)
+          {
+            const bool isOverloaded = nameCounts[function.name] > 1;
+            LOG_IF(WARNING, isOverloaded)
+              << "(pimpl) overloaded method "
+              << function.methodName
+              << " from "
+              << reflectForPimplSettings.implParameterQualType
+              << " is not exported to C facade";
+            return isOverloaded;
+          })
+      , cApiFunctions.end());
+
+    // default constructor of interface is declared manually
+    std::vector<PimplCApiFunction> cApiConstructors;
+    if(implTraits.isDefaultConstructible) {
+      PimplCApiFunction create;
+      create.name = cApiPrefix + "_create";
+      create.signature.isSupported = true;
+      cApiConstructors.push_back(create);
+    }
+    for(size_t i = 0; i < implTraits.constructors.size(); i++) {
+      const PimplConstructorInfo& constructor = implTraits.constructors[i];
+      if(!constructor.cApi.isSupported) {
+        LOG(WARNING)
+          << "(pimpl) constructor "
+          << constructor.paramTypes
+          << " from "
+          << reflectForPimplSettings.implParameterQualType
+          << " is not exported to C facade";
+        continue;
+      }
+      PimplCApiFunction create;
+      create.name = cApiPrefix + "_create_" + std::to_string(i + 1);
+      create.signature = constructor.cApi;
+      cApiConstructors.push_back(create);
+    }
+    cApiFunctions.insert(
+      cApiFunctions.begin()
+      , cApiConstructors.begin()
+      , cApiConstructors.end());
+
+    const std::string header
+      = printCApiHeader(
+          reflectForPimplSettings.interfaceParameterQualType
+          , cApiFunctions);
+    const base::FilePath headerPath
+      = outDir_.Append(cApiPrefix + "_c_api.h");
+    CHECK(base::WriteFile(
+            headerPath
+            , header.data()
+            , static_cast<int>(header.size()))
+          == static_cast<int>(header.size()))
+      << "(pimpl) unable to write C facade: "
+      << headerPath;
+
+    // outermost first
+    std::vector<std::string> enclosingNamespaces;
+    for(const clang::DeclContext* context = node->getDeclContext()
+        ; context && !context->isTranslationUnit()
+        ; context = context->getParent())
+    {
+      const auto* namespaceDecl
+        = clang::dyn_cast<clang::NamespaceDecl>(context);
+      CHECK(namespaceDecl)
+        << "(pimpl) c_api must be injected at namespace scope for "
+        << reflectForPimplSettings.implParameterQualType;
+      enclosingNamespaces.insert(
+        enclosingNamespaces.begin()
+        , namespaceDecl->isAnonymousNamespace()
+          ? ""
+          : namespaceDecl->getNameAsString());
+    }
+
+    replacer += printCApiDefs(
+      reflectForPimplSettings.interfaceParameterQualType
+      , enclosingNamespaces
+      , cApiFunctions);
+  }
+
+  /**
+   * generates code similar to:
+   *  size_t Foo::snapshot(char* out) const {
+   *    const auto& impl = (*impl_);
+   *    ::std::memcpy(out, &impl, sizeof(impl));
+   *    return sizeof(impl);
+   *  }
+   *
+   * or (if impl is not trivially copyable) code similar to:
+   *  size_t Foo::snapshot(char* out) const {
+   *    const auto& impl = (*impl_);
+   *    char* pos = out;
+   *    pos = ::flex_pimpl_plugin::pimpl::writeSnapshot(impl.data_, pos);
+   *    return pos - out;
+   *  }
+   **/
+  if(snapshot && !without_method_body) {
+    DVLOG(9)
+      << "running snapshot generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // type of stored alternative is known only at runtime
+    CHECK(storageSettings.kind != PimplStorageKind::kVariant)
+      << "(pimpl) snapshot is not compatible with `storage = variant` of "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // fields of bases are not reflected,
+    // so only whole impl can be copied
+    CHECK(implTraits.isTriviallyCopyable
+          || (!implTraits.hasBases && implTraits.areFieldsAssignable))
+      << "(pimpl) snapshot requires trivially copyable impl"
+         " or impl without bases and reference fields: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // restored address would point into memory of other process,
+    // applies to both memcpy of whole impl and fields one by one
+    CHECK(!implTraits.hasPointerFields)
+      << "(pimpl) snapshot does not support pointer, reference"
+         " or member pointer fields: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += printSnapshotDefs(
+      storageSettings.kind
+      , reflectForPimplSettings.interfaceParameterQualType
+      , reflectForPimplSettings.implParameterQualType
+      , implTraits.fields
+      , implTraits.isTriviallyCopyable
+      , printForwarderLock(implTraits.locking, true, "")
+      , printForwarderLock(implTraits.locking, false, "")
+      , printMemoCacheInvalidation(implTraits.memoCaches, ""));
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   static const ::flex_pimpl_plugin::pimpl::MethodEntry*
+   *     findMethod(::std::string_view name) noexcept;
+   *  private:
+   **/
+  if(by_name && without_method_body) {
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += printMethodTableDecl();
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   size_t snapshotSize() const;
+   *   size_t snapshot(char* out) const;
+   *   size_t restore(const char* in, size_t size);
+   *  private:
+   **/
+  if(snapshot && without_method_body) {
+    const clang::CXXRecordDecl* interfaceDecl
+      = clang::dyn_cast_or_null<clang::CXXRecordDecl>(node->getParent());
+    CHECK(interfaceDecl)
+      << "(pimpl) snapshot must be injected into class: "
+      << reflectForPimplSettings.implParameterQualType;
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += printSnapshotDecls(interfaceDecl->getNameAsString());
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   struct ImplTable;
+   *   static const ImplTable* builtinImplTable() noexcept;
+   *   static bool swapImplTable(const ImplTable* table);
+   *  private:
+   **/
+  if(hot_swap && without_method_body) {
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += printHotSwapDecls();
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   struct Inline;
+   *  private:
+   **/
+  if(inline_forwarders && without_method_body) {
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    replacer += "// static forwarders that can be inlined,";
+    replacer += "\n";
+    replacer += "// defined in `.inl` file that includes impl";
+    replacer += "\n";
+    replacer += "struct ";
+    replacer += kInlineForwardersName;
+    replacer += ";";
+    replacer += "\n";
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   explicit Foo(int id);
+   *   void emplace(int id);
+   *  private:
+   **/
+  if(!implTraits.constructors.empty() && without_method_body) {
+    DVLOG(9)
+      << "running forwarding constructor declaration generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    const clang::CXXRecordDecl* interfaceDecl
+      = clang::dyn_cast_or_null<clang::CXXRecordDecl>(node->getParent());
+    CHECK(interfaceDecl)
+      << "(pimpl) forwarding constructors must be injected into class: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    // skip constructors that interface declares manually
+    std::vector<PimplConstructorInfo> constructors;
+    for(const PimplConstructorInfo& constructor
+          : implTraits.constructors)
+    {
+      bool isDeclared = false;
+      for(const clang::CXXConstructorDecl* ctor : interfaceDecl->ctors()) {
+        const std::string signature = printMethodSignature(ctor);
+        isDeclared
+          = isDeclared
+            || signature.substr(signature.find('('))
+                 == constructor.paramTypes;
+      }
+      if(isDeclared) {
+        VLOG(9)
+          << "skipped constructor "
+          << constructor.paramTypes
+          << " declared by interface of "
+          << reflectForPimplSettings.implParameterQualType;
+        continue;
+      }
+      constructors.push_back(constructor);
+    }
+
+    if(!constructors.empty()) {
+      replacer += "\n";
+      replacer += printAccessSpecifier(clang::AS_public);
+      replacer += "\n";
+      replacer += printForwardingConstructorDecls(
+        interfaceDecl->getNameAsString()
+        , constructors);
+      // restore access of declarations that follow annotation
+      replacer += printAccessSpecifier(getAnnotationAccess(node));
+      replacer += "\n";
+    }
+
+    constructorsCache_[reflectForPimplSettings.implParameterQualType]
+      = std::move(constructors);
+  }
+
+  // forwarding constructors were declared in header of interface,
+  // definitions without `interface` would be missing at link time
+  if(!without_method_body
+     && !printInlineForwarders
+     && reflectForPimplSettings.interfaceParameterQualType.empty())
+  {
+    auto it = constructorsCache_.find(
+      reflectForPimplSettings.implParameterQualType);
+    CHECK(it == constructorsCache_.end() || it->second.empty())
+      << "(pimpl) forwarding constructors require `interface` argument"
+         " in `.cc` file for "
+      << reflectForPimplSettings.implParameterQualType;
+  }
+
+  /**
+   * generates code similar to:
+   *  Foo::Foo(int id)
+   *    : impl_(id)
+   *  {}
+   *  void Foo::emplace(int id) {
+   *    ::flex_pimpl_plugin::pimpl::reconstruct(*impl_, id);
+   *  }
+   **/
+  if(!without_method_body
+     && !printInlineForwarders
+     && !reflectForPimplSettings.interfaceParameterQualType.empty())
+  {
+    // constructors declared in header of interface
+    auto it = constructorsCache_.find(
+      reflectForPimplSettings.implParameterQualType);
+    const std::vector<PimplConstructorInfo>& constructors
+      = it != constructorsCache_.end()
+        ? it->second
+        : implTraits.constructors;
+
+    if(!constructors.empty()) {
+      CHECK(!storageSettings.interfaceName.empty())
+        << "(pimpl) forwarding constructors require injected storage of "
+        << reflectForPimplSettings.implParameterQualType;
+
+      DVLOG(9)
+        << "running forwarding constructor generator for: "
+        << reflectForPimplSettings.implParameterQualType;
+
+      replacer += printForwardingConstructorDefs(
+        storageSettings.kind
+        , reflectForPimplSettings.interfaceParameterQualType
+        , storageSettings.interfaceName
+        , constructors
+        // `emplace` replaces impl
+        , printForwarderLock(implTraits.locking, false, "")
+        , printMemoCacheInvalidation(
+            implTraits.memoCaches
+            , "" // `emplace` is member of interface
+          )
+        , !storageSettings.cpuFeatures.empty());
+    }
+  }
+
+  /**
+   * generates code similar to:
+   *  public:
+   *   static void foo_batch(::base::span<Foo> objects, int arg);
+   *  private:
+   **/
+  if(!batchMethods.empty() && without_method_body) {
+    DVLOG(9)
+      << "running batch forwarder declaration generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    const clang::CXXRecordDecl* interfaceDecl
+      = clang::dyn_cast_or_null<clang::CXXRecordDecl>(node->getParent());
+    CHECK(interfaceDecl)
+      << "(pimpl) batch forwarders must be injected into class: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += "\n";
+    replacer += printAccessSpecifier(clang::AS_public);
+    replacer += "\n";
+    for(const PimplBatchMethod& batchMethod : batchMethods) {
+      replacer += printBatchForwarderDecl(
+        interfaceDecl->getNameAsString()
+        , batchMethod);
+    }
+    // restore access of declarations that follow annotation
+    replacer += printAccessSpecifier(getAnnotationAccess(node));
+    replacer += "\n";
+  }
+
+  /**
+   * generates code similar to:
+   *  void Foo::foo_batch(::base::span<Foo> objects, int arg) {
+   *    for(size_t i = 0; i < objects.size(); i++) {
+   *      objects[i].foo(arg);
+   *    }
+   *  }
+   **/
+  if(!batchMethods.empty()
+     && !without_method_body
+     && !printInlineForwarders)
+  {
+    CHECK(!reflectForPimplSettings.interfaceParameterQualType.empty())
+      << "(pimpl) batch forwarders require `interface` for "
+      << reflectForPimplSettings.implParameterQualType;
+
+    DVLOG(9)
+      << "running batch forwarder generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    for(const PimplBatchMethod& batchMethod : batchMethods) {
+      replacer += printBatchForwarderDef(
+        reflectForPimplSettings.interfaceParameterQualType
+        , batchMethod);
+    }
+  }
+
+  // copy, move and `swap` are declared by storage injector,
+  // definitions without `interface` would be missing at link time
+  CHECK(!storageSettings.hasSpecialMembers
+        || without_method_body
+        || printInlineForwarders
+        || !reflectForPimplSettings.interfaceParameterQualType.empty())
+    << "(pimpl) generated copy, move and swap require `interface` argument"
+       " in `.cc` file for "
+    << reflectForPimplSettings.implParameterQualType;
 
   /**
-   * parse arguments from annotation attribute
-   * EXAMPLE:
-      template<typename impl = FooImpl>
+   * generates code similar to:
+   *  Foo::Foo(Foo&& other) noexcept = default;
+   *  Foo& Foo::operator=(Foo&& other) noexcept = default;
+   *  void Foo::swap(Foo& other) noexcept { ... }
+   **/
+  if(storageSettings.hasSpecialMembers
+     && !without_method_body
+     && !printInlineForwarders
+     && !reflectForPimplSettings.interfaceParameterQualType.empty())
+  {
+    DVLOG(9)
+      << "running move operations generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += printSpecialMemberDefs(
+      reflectForPimplSettings.interfaceParameterQualType
+      , storageSettings.interfaceName
+      , storageSettings.storageType
+      , storageSettings.isNothrowMovable
+      , storageSettings.isCopyable
+      , implTraits.locking
+      , printMemoCacheInvalidation(implTraits.memoCaches, "")
+      , printMemoCacheInvalidation(implTraits.memoCaches, "other."));
+  }
+
+  // constructors and `get_allocator` are declared by storage injector,
+  // definitions without `interface` would be missing at link time
+  CHECK(!storageSettings.isPmrAllocatorAware
+        || without_method_body
+        || printInlineForwarders
+        || !reflectForPimplSettings.interfaceParameterQualType.empty())
+    << "(pimpl) allocator-aware storage requires `interface` argument"
+       " in `.cc` file for "
+    << reflectForPimplSettings.implParameterQualType;
+
+  /**
+   * generates code similar to:
+   *  Foo::Foo(std::allocator_arg_t, const allocator_type& alloc)
+   *    : impl_(alloc)
+   *  {}
+   *  Foo::Foo(std::allocator_arg_t, const allocator_type& alloc,
+   *    Foo&& other)
+   *    : impl_(alloc)
+   *  {
+   *   *impl_ = std::move(*other.impl_);
+   *  }
+   **/
+  if(storageSettings.isPmrAllocatorAware
+     && !without_method_body
+     && !printInlineForwarders
+     && !reflectForPimplSettings.interfaceParameterQualType.empty())
+  {
+    DVLOG(9)
+      << "running allocator-aware constructor generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += printPmrInterfaceDefs(
+      reflectForPimplSettings.interfaceParameterQualType
+      , storageSettings.interfaceName
+      // `get_allocator()` is const
+      , printImplAccess(storageSettings.kind, true)
+      , storageSettings.isCopyable
+      , implTraits.locking);
+  }
+
+  DVLOG(9)
+    << "applying source code transformation for: "
+    << reflectForPimplSettings.implParameterQualType;
+  // remove annotation from source file
+  clang_utils::replaceWith(
+    sourceTransformOptions.rewriter
+    , sourceTransformOptions.decl
+    , sourceTransformOptions.matchResult
+    , replacer);
+
+  return clang_utils::SourceTransformResult{nullptr};
+}
+
+/**
+  * EXAMPLE INPUT (header, at global namespace scope):
+      template<
+        typename impl = FooImpl
+      >
       class
-        my_annotation_attr(
+        _injectPimplExternTemplates(
           "without_method_body"
         )
-      PimplMethodDeclsInjector
+      PimplExternTemplatesInjector
       {};
-    *
-    * parsed argument value is:
-        without_method_body
-   **/
+  *
+  * EXAMPLE OUTPUT (header):
+      extern template ::basis::FastPimpl<::FooImpl, ...>&
+        ::basis::FastPimpl<::FooImpl, ...>::operator=(
+          ::basis::FastPimpl<::FooImpl, ...>&&);
+      extern template ::basis::FastPimpl<::FooImpl, ...>::~FastPimpl();
+      // only with `typename interface = Foo`, see `_pimplInstantiate`
+      extern template ::size_t Foo::describe<int>(
+        const ::std::enable_if_t<true, int> &) const;
+  *
+  * EXAMPLE INPUT (source file, at global namespace scope):
+      template<
+        typename impl = FooImpl
+      >
+      class
+        _injectPimplExternTemplates()
+      PimplExternTemplatesInjector
+      {};
+  *
+  * EXAMPLE OUTPUT (source file):
+      template ::basis::FastPimpl<::FooImpl, ...>&
+        ::basis::FastPimpl<::FooImpl, ...>::operator=(
+          ::basis::FastPimpl<::FooImpl, ...>&&);
+      template ::basis::FastPimpl<::FooImpl, ...>::~FastPimpl();
+      static_assert(sizeof(::FooImpl) <= 64, "...");
+  **/
+clang_utils::SourceTransformResult
+  pimplTooling::injectPimplExternTemplates(
+    const clang_utils::SourceTransformOptions& sourceTransformOptions)
+{
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  VLOG(9)
+    << "injectPimplExternTemplates called...";
+
+  ReflectForPimplSettings reflectForPimplSettings
+    = getReflectForPimplSettings(sourceTransformOptions);
+
+  bool without_method_body = false;
+
   {
     /// \todo refactor similar to https://github.com/jarro2783/cxxopts
     flexlib::args annotationArgs =
@@ -621,86 +2826,82 @@ clang_utils::SourceTransformResult
     }
   }
 
+  // storage type is known only after `injectPimplStorage`
+  auto it = storageCache_.find(
+    reflectForPimplSettings.implParameterQualType);
+  CHECK(it != storageCache_.end())
+    << "(pimpl) extern templates require injected storage of "
+    << reflectForPimplSettings.implParameterQualType;
+  const PimplStorageSettings& storageSettings = it->second;
+
   std::string replacer;
 
-  /**
-   * generates code similar to:
-   *  std::string foo(int arg1) { return impl->foo(arg1); };
-   **/
-  {
+  // `template class` would instantiate every non-template member
+  // of storage, including copy operations that do not compile
+  // for move-only impl, so special members are instantiated one by one
+  // (header and source file make same decision)
+  const std::string storageInstantiations
+    = printStorageMemberInstantiations(
+        storageSettings.kind
+        , storageSettings.storageType
+        , !storageSettings.cpuFeatures.empty()
+        , storageSettings.isImplCopyable
+        , without_method_body);
+
+  if(without_method_body) {
     DVLOG(9)
-      << "running FastPimpl method call generator for: "
+      << "running extern template generator for: "
       << reflectForPimplSettings.implParameterQualType;
 
-    for(const reflection::MethodInfoPtr& method
-         : reflectedClass->methods)
-    {
-      DCHECK(method);
-
-      const bool needPrint = isPimplMethod(method);
-      if(!needPrint) {
-        continue;
-      }
-      const std::string methodForwarding
-         = clang_utils::printMethodForwarding(
-             method
-             , clang_utils::kSeparatorWhitespace
-            // what method printer is allowed to print
-             , MethodPrinter::Forwarding::Options::ALL
-               & ~MethodPrinter::Forwarding::Options::VIRTUAL);
-      const std::string methodTrailing
-         = clang_utils::printMethodTrailing(
-             method
-             , clang_utils::kSeparatorWhitespace
-             // what method printer is allowed to print
-             , MethodPrinter::Trailing::Options::NOTHING
-               | MethodPrinter::Trailing::Options::CONST
-               | MethodPrinter::Trailing::Options::NOEXCEPT);
-        if(method->isTemplate())
-        {
-          replacer += "template<";
-          replacer += expandTemplateNames(method->tplParams);
-          replacer += ">";
-        } // method->isTemplate
+    replacer += storageInstantiations;
 
-        replacer += methodForwarding;
-        replacer += " ";
-        if(!reflectForPimplSettings.interfaceParameterQualType.empty()) {
-          // usually it is `::Foo` part out of `::Foo::bar()`
-          // where Foo is class that stores implementation
-          replacer += reflectForPimplSettings.interfaceParameterQualType;
-          replacer += "::";
-          VLOG(9)
-            << "creating methods of class: "
-            << reflectForPimplSettings.interfaceParameterQualType;
+    /**
+     * generates code similar to:
+     *  extern template ::size_t example_interface::Foo::describe<int>(
+     *    const ::std::enable_if_t<true, int> &) const;
+     **/
+    /// \note explicit instantiations are generated
+    /// by `injectPimplMethodCalls` in `.cc` file
+    if(!reflectForPimplSettings.interfaceParameterQualType.empty()) {
+      reflection::ClassInfoPtr reflectedClass
+        = reflectFromCache(
+            reflectForPimplSettings);
+      DCHECK(reflectedClass);
+
+      const PimplImplTraits& implTraits
+        = getImplTraits(reflectForPimplSettings);
+
+      for(const reflection::MethodInfoPtr& method
+           : reflectedClass->methods)
+      {
+        DCHECK(method);
+        if(!isPimplMethod(method)) {
+          continue;
         }
-        replacer += method->name;
-        replacer += "(";
-        replacer += methodParamDecls(method->params);
-        replacer += ")";
-        replacer += " ";
-        replacer += methodTrailing;
-
-        if(!without_method_body) {
-          replacer += "\n";
-          replacer += "{";
-          replacer += "\n";
-          replacer += " return impl_->";
-          replacer += method->name;
-          replacer += "(";
-          replacer
-            += clang_utils::forwardMethodParamNames(
-                 method->params);
-          replacer += ")";
-          replacer += ";";
-          replacer += "\n";
-          replacer += "}";
-          replacer += "\n";
-        } else {
-          replacer += ";";
+        for(const PimplMethodInstantiation& instantiation
+              : getMethodTraits(implTraits, method.get()).instantiations)
+        {
+          replacer += printMethodInstantiation(
+            reflectForPimplSettings.interfaceParameterQualType
+            , method->name
+            , instantiation
+            , true // isExternDecl
+          );
           replacer += "\n";
         }
+      }
     }
+  } else {
+    DVLOG(9)
+      << "running explicit instantiation generator for: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    replacer += storageInstantiations;
+    replacer += printStorageLayoutAsserts(
+      storageSettings.kind
+      , storageSettings.implTypes
+      , storageSettings.typeSize
+      , storageSettings.typeAlignment);
   }
 
   DVLOG(9)
@@ -748,6 +2949,57 @@ clang_utils::SourceTransformResult
     << "must be CXXRecordDecl: "
     << reflectForPimplSettings.implParameterQualType;
 
+  // each alternative must be reflected by separate annotation
+  CHECK(reflectForPimplSettings.alternativeParameterQualTypes.empty())
+    << "(pimpl) reflect alternatives separately from "
+    << reflectForPimplSettings.implParameterQualType;
+
+  // `locking` of methods without own `locking` policy
+  PimplLocking defaultLocking = PimplLocking::kNone;
+
+  /**
+   * parse arguments from annotation attribute
+   * EXAMPLE:
+      template<typename impl = FooImpl>
+      class _reflectForPimpl("locking = shared")
+        PimplReflector
+      {};
+    *
+    * parsed argument name is:
+        locking
+    * parsed argument value is:
+        shared
+   **/
+  {
+    flexlib::args annotationArgs =
+      sourceTransformOptions.func_with_args.parsed_func_.args_;
+    for(const auto& arg : annotationArgs.as_vec_)
+    {
+      if(arg.name_.empty() && arg.value_.empty()) {
+        continue;
+      }
+
+      if(arg.name_ == "locking") {
+        const std::string value = unquoteArgValue(arg.value_);
+        if(value == "exclusive") {
+          defaultLocking = PimplLocking::kExclusive;
+        } else if(value == "shared") {
+          defaultLocking = PimplLocking::kShared;
+        } else {
+          CHECK(value == "none")
+            << "(pimpl) unsupported locking: "
+            << arg.value_;
+        }
+      } else {
+        CHECK(false)
+          << "(pimpl) unknown argument: "
+          << arg.name_
+          << " with value: "
+          << arg.value_;
+      }
+    }
+  }
+
   /// \todo support custom namespaces
   reflection::NamespacesTree m_namespaces;
 
@@ -837,6 +3089,367 @@ clang_utils::SourceTransformResult
       << " were skipped";
   }
 
+  {
+    PimplImplTraits& implTraits
+      = implTraitsCache_[reflectForPimplSettings.implParameterQualType];
+
+    implTraits.isTriviallyRelocatable
+      = isTriviallyRelocatableType(
+          reflectForPimplSettings.implArgQualType
+          , *sourceTransformOptions.matchResult.Context);
+
+    DVLOG(9)
+      << reflectForPimplSettings.implParameterQualType
+      << (implTraits.isTriviallyRelocatable
+          ? " is trivially relocatable"
+          : " is not trivially relocatable");
+
+    implTraits.isPmrAllocatorAware
+      = isPmrAllocatorAwareType(
+          reflectForPimplSettings.implArgQualType
+            ->getAsCXXRecordDecl()
+          , *sourceTransformOptions.matchResult.Context);
+
+    const clang::CXXRecordDecl* implDecl
+      = reflectForPimplSettings.implArgQualType
+          ->getAsCXXRecordDecl()->getDefinition();
+    CHECK(implDecl)
+      << "(pimpl) incomplete impl: "
+      << reflectForPimplSettings.implParameterQualType;
+
+    implTraits.isDefaultConstructible
+      = implDecl->hasDefaultConstructor();
+
+    implTraits.isNothrowMovable
+      = isNothrowMovableType(
+          reflectForPimplSettings.implArgQualType
+          , *sourceTransformOptions.matchResult.Context);
+
+    implTraits.isCopyable
+      = isCopyableType(
+          reflectForPimplSettings.implArgQualType
+          , *sourceTransformOptions.matchResult.Context);
+
+    implTraits.isTriviallyCopyable
+      = reflectForPimplSettings.implArgQualType.isTriviallyCopyableType(
+          *sourceTransformOptions.matchResult.Context);
+
+    implTraits.hasBases = implDecl->getNumBases() > 0;
+
+    // fields are checked one by one below,
+    // bases are checked only if impl is copied via memcpy
+    implTraits.hasPointerFields
+      = implTraits.isTriviallyCopyable
+        && hasPointerMembers(
+             reflectForPimplSettings.implArgQualType
+             , *sourceTransformOptions.matchResult.Context);
+
+    for(const clang::CXXConstructorDecl* ctor : implDecl->ctors()) {
+      DCHECK(ctor);
+      // default constructor of interface is declared manually
+      if(ctor->getAccess() != clang::AS_public
+         || ctor->isDeleted()
+         || ctor->isImplicit()
+         || ctor->isCopyOrMoveConstructor()
+         || ctor->getNumParams() == 0)
+      {
+        continue;
+      }
+      // constructor from allocator is used by `allocator = pmr`
+      if(implTraits.isPmrAllocatorAware
+         && ctor->getNumParams() == 1)
+      {
+        continue;
+      }
+
+      PimplConstructorInfo constructor;
+      constructor.isExplicit = ctor->isExplicit();
+      constructor.cApi
+        = reflectCApiSignature(
+            ctor
+            , *sourceTransformOptions.matchResult.Context);
+      const std::string signature = printMethodSignature(ctor);
+      constructor.paramTypes = signature.substr(signature.find('('));
+
+      bool hasUnnamedParams = false;
+      for(const clang::ParmVarDecl* param : ctor->parameters()) {
+        DCHECK(param);
+        if(param->getName().empty()) {
+          hasUnnamedParams = true;
+          break;
+        }
+        if(!constructor.paramDecls.empty()) {
+          constructor.paramDecls
+            += clang_utils::kSeparatorCommaAndWhitespace;
+          constructor.forwardedParams
+            += clang_utils::kSeparatorCommaAndWhitespace;
+        }
+        // interface may be declared in other namespace
+        constructor.paramDecls
+          += printFullyQualifiedType(
+               param->getType()
+               , *sourceTransformOptions.matchResult.Context);
+        constructor.paramDecls += " ";
+        constructor.paramDecls += param->getNameAsString();
+        constructor.forwardedParams
+          += printForwardedParam(param, nullptr);
+      }
+      if(hasUnnamedParams) {
+        VLOG(9)
+          << "skipped constructor with unnamed parameters "
+          << signature
+          << " from "
+          << reflectForPimplSettings.implParameterQualType;
+        continue;
+      }
+
+      implTraits.constructors.push_back(std::move(constructor));
+    }
+
+    implTraits.areFieldsAssignable = true;
+    for(const clang::FieldDecl* field : implDecl->fields()) {
+      DCHECK(field);
+      implTraits.areFieldsAssignable
+        = implTraits.areFieldsAssignable
+          && !field->isBitField()
+          && !field->getType()->isReferenceType()
+          && !field->getType().isConstQualified();
+      implTraits.hasPointerFields
+        = implTraits.hasPointerFields
+          || hasPointerMembers(
+               field->getType()
+               , *sourceTransformOptions.matchResult.Context);
+      implTraits.fields.push_back(PimplFieldInfo{
+        field->getNameAsString()
+        , printFullyQualifiedType(
+            field->getType()
+            , *sourceTransformOptions.matchResult.Context)
+      });
+    }
+
+    for(const reflection::MethodInfoPtr& method
+          : reflectedClass->methods)
+    {
+      DCHECK(method && method->decl);
+      PimplMethodTraits& methodTraits
+        = implTraits.methods[method.get()];
+
+      methodTraits.signature
+        = printMethodSignature(method->decl);
+
+      const clang::CXXMethodDecl* methodDecl
+        = clang::dyn_cast<clang::CXXMethodDecl>(method->decl);
+      DCHECK(methodDecl);
+
+      methodTraits.isConst = methodDecl->isConst();
+
+      // static forwarders have no mutex of interface
+      if(!methodDecl->isStatic()) {
+        methodTraits.policy.locking = defaultLocking;
+      }
+
+      for(const clang::AnnotateAttr* annotate
+            : methodDecl->specific_attrs<clang::AnnotateAttr>())
+      {
+        const std::string annotationCode
+          = annotate->getAnnotation().str();
+        if(base::StartsWith(
+             annotationCode
+             , kPimplPolicyAttr
+             , base::CompareCase::SENSITIVE))
+        {
+          methodTraits.policy
+            = parsePimplMethodPolicy(annotationCode, methodTraits.policy);
+        } else if(base::StartsWith(
+                    annotationCode
+                    , kPimplInstantiateAttr
+                    , base::CompareCase::SENSITIVE))
+        {
+          methodTraits.instantiations.push_back(
+            parsePimplMethodInstantiation(
+              annotationCode
+              , methodDecl
+              , *sourceTransformOptions.matchResult.Context));
+        }
+      }
+      const PimplMethodPolicy& policy = methodTraits.policy;
+
+      // policy overrides profile
+      methodTraits.hotness
+        = policy.section != PimplMethodHotness::kUnknown
+          ? policy.section
+          : getMethodHotness(
+              reflectForPimplSettings.implParameterQualType
+              , method->name);
+
+      if(policy.locking > implTraits.locking) {
+        implTraits.locking = policy.locking;
+      }
+
+      methodTraits.isBatchable
+        = !methodDecl->isStatic()
+          && !methodDecl->getDescribedFunctionTemplate();
+      for(const clang::ParmVarDecl* param : methodDecl->parameters()) {
+        // argument is passed to each row,
+        // so it can not be moved
+        methodTraits.isBatchable
+          = methodTraits.isBatchable
+            && !param->getType()->isRValueReferenceType()
+            && !param->getName().empty();
+        if(!methodTraits.paramNames.empty()) {
+          methodTraits.paramNames
+            += clang_utils::kSeparatorCommaAndWhitespace;
+          methodTraits.forwardedParams
+            += clang_utils::kSeparatorCommaAndWhitespace;
+        }
+        // example: `*static_cast<const int*>(args[1])`
+        std::string invokerArg
+          = "*static_cast<"
+            + printFullyQualifiedType(
+                param->getType().getNonReferenceType()
+                , *sourceTransformOptions.matchResult.Context)
+            + "*>(args["
+            + std::to_string(methodTraits.paramNameList.size())
+            + "])";
+        if(!param->getType()->isLValueReferenceType()) {
+          invokerArg = "::std::move(" + invokerArg + ")";
+        }
+        if(!methodTraits.invokerArgs.empty()) {
+          methodTraits.invokerArgs
+            += clang_utils::kSeparatorCommaAndWhitespace;
+        }
+        methodTraits.invokerArgs += invokerArg;
+        methodTraits.paramNames += param->getNameAsString();
+        methodTraits.paramNameList.push_back(param->getNameAsString());
+        methodTraits.forwardedParams
+          += printForwardedParam(
+               param
+               , methodDecl->getDescribedFunctionTemplate());
+      }
+
+      const clang::QualType returnType = methodDecl->getReturnType();
+      methodTraits.returnsView = isViewType(returnType);
+      methodTraits.returnType
+        = printFullyQualifiedType(
+            returnType
+            , *sourceTransformOptions.matchResult.Context);
+      if(!returnType->isVoidType()) {
+        methodTraits.batchResultType
+          = printFullyQualifiedType(
+              returnType.getNonReferenceType().getUnqualifiedType()
+              , *sourceTransformOptions.matchResult.Context);
+      }
+
+      methodTraits.cApi
+        = reflectCApiSignature(
+            methodDecl
+            , *sourceTransformOptions.matchResult.Context);
+
+      methodTraits.hasBatchForwarder
+        = hasAnnotation(methodDecl, kBatchPimplAttr)
+          || policy.isBatched;
+      CHECK(!methodTraits.hasBatchForwarder || methodTraits.isBatchable)
+        << "(pimpl) batch forwarder requires non-static, non-template "
+           "method without rvalue reference or unnamed parameters: "
+        << method->name
+        << " from "
+        << reflectForPimplSettings.implParameterQualType;
+
+      const bool isPlainMethod
+        = !methodDecl->isStatic()
+          && !methodDecl->getDescribedFunctionTemplate();
+
+      // arguments are stored as cache key,
+      // so they must be named and must not be moved
+      CHECK(!policy.isMemoized
+            || (isPlainMethod
+                && methodTraits.isBatchable
+                && methodTraits.isConst
+                && !methodTraits.batchResultType.empty()
+                && !returnType->isReferenceType()))
+        << "(pimpl) memoize requires non-static, non-template "
+           "const method that returns value (not reference) "
+           "and has no rvalue reference or unnamed parameters: "
+        << method->name
+        << " from "
+        << reflectForPimplSettings.implParameterQualType;
+
+      if(policy.isMemoized) {
+        PimplMemoCache& memoCache = methodTraits.memoCache;
+
+        // overloads get separate caches
+        const size_t overloadIndex
+          = std::count_if(
+              implTraits.memoCaches.begin()
+              , implTraits.memoCaches.end()
+              , [&method](const PimplMemoCache& cache) {
+                  return base::StartsWith(
+                    cache.name
+                    , method->name + "Memo"
+                    , base::CompareCase::SENSITIVE);
+                });
+        memoCache.name = method->name + "Memo";
+        if(overloadIndex) {
+          memoCache.name += std::to_string(overloadIndex);
+        }
+        memoCache.name += "_";
+
+        memoCache.valueType = methodTraits.batchResultType;
+        memoCache.capacity = policy.memoCapacity;
+        memoCache.isNothrowMovable
+          = isNothrowMovableType(
+              returnType.getNonReferenceType().getUnqualifiedType()
+              , *sourceTransformOptions.matchResult.Context);
+        memoCache.keyType = "::std::tuple<";
+        for(const clang::ParmVarDecl* param : methodDecl->parameters()) {
+          const clang::QualType keyType
+            = param->getType().getNonReferenceType().getUnqualifiedType();
+          if(param != methodDecl->parameters().front()) {
+            memoCache.keyType += clang_utils::kSeparatorCommaAndWhitespace;
+          }
+          memoCache.keyType
+            += printFullyQualifiedType(
+                 keyType
+                 , *sourceTransformOptions.matchResult.Context);
+          memoCache.isNothrowMovable
+            = memoCache.isNothrowMovable
+              && isNothrowMovableType(
+                   keyType
+                   , *sourceTransformOptions.matchResult.Context);
+        }
+        memoCache.keyType += ">";
+
+        implTraits.memoCaches.push_back(memoCache);
+      }
+
+      // task owns copies of arguments
+      bool areParamsCopyable = true;
+      for(const clang::ParmVarDecl* param : methodDecl->parameters()) {
+        const clang::QualType paramType = param->getType();
+        areParamsCopyable
+          = areParamsCopyable
+            && !param->getName().empty()
+            && !(paramType->isLValueReferenceType()
+                 && !paramType.getNonReferenceType().isConstQualified());
+      }
+      CHECK(!policy.isAsync || (isPlainMethod && areParamsCopyable))
+        << "(pimpl) async requires non-static, non-template method "
+           "without unnamed or non-const lvalue reference parameters: "
+        << method->name
+        << " from "
+        << reflectForPimplSettings.implParameterQualType;
+
+      // task calls forwarder on other thread while caller
+      // may still use the same interface object
+      CHECK(!policy.isAsync || policy.locking != PimplLocking::kNone)
+        << "(pimpl) async requires `locking = exclusive`"
+           " or `locking = shared`: "
+        << method->name
+        << " from "
+        << reflectForPimplSettings.implParameterQualType;
+    }
+  }
+
   {
     auto it = reflectionCache_.find(
       reflectForPimplSettings.implParameterQualType);
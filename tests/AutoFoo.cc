@@ -0,0 +1,28 @@
+#include "pimpl_annotations.hpp"
+
+#include "AutoFoo.hpp.generated.hpp"
+
+#include "AutoFooImpl.hpp.generated.hpp"
+
+#include <flex_pimpl_plugin/pimpl/HotSwap.hpp>
+
+namespace example_interface {
+
+AutoFoo::AutoFoo() {
+}
+
+AutoFoo::~AutoFoo() {
+}
+
+// will replace itself with generated code like:
+// int AutoFoo::sum() const
+// { return ImplTable::current.get().sum(*this); }
+template<
+  typename impl = example_impl::AutoFooImpl
+  , typename interface = AutoFoo
+>
+class _injectPimplMethodCalls("hot_swap")
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <basis/core/pimpl.hpp>
+
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+
+#include <cstddef>
+
+namespace example_impl {
+
+class AutoFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// storage is selected by size of impl,
+// forwarders are called via replaceable table
+class AutoFoo {
+public:
+  AutoFoo();
+
+  ~AutoFoo();
+
+  // Will replace itself with generated code like:
+  // void set(::size_t index, int value);
+  // int sum() const;
+  // struct ImplTable;
+  // static const ImplTable* builtinImplTable() noexcept;
+  // static bool swapImplTable(const ImplTable* table);
+  template<typename impl = example_impl::AutoFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body, hot_swap"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::PoolPimpl<::example_impl::AutoFooImpl> impl_;
+  template<
+    typename impl = example_impl::AutoFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = auto, inlineBudget = 128"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <array>
+#include <cstddef>
+#include <numeric>
+
+namespace example_impl {
+
+// impl is larger than `inlineBudget`, so `storage = auto`
+// selects pool storage
+class AutoFooImpl
+{
+ public:
+  void set(size_t index, int value)
+  {
+    values_.at(index) = value;
+  }
+
+  int sum() const
+  {
+    return std::accumulate(values_.begin(), values_.end(), 0);
+  }
+
+ private:
+  std::array<int, 64> values_{};
+};
+
+template<typename impl = AutoFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
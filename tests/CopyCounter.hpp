@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts copies and moves of all |CopyCounter| objects,
+// used to check that generated forwarders do not copy arguments.
+/// \note declared in global namespace, so same name can be used
+/// by both impl and interface
+struct CopyCounter {
+  CopyCounter() = default;
+
+  CopyCounter(const CopyCounter&) noexcept
+  {
+    copies++;
+  }
+
+  CopyCounter(CopyCounter&&) noexcept
+  {
+    moves++;
+  }
+
+  CopyCounter& operator=(const CopyCounter&) noexcept
+  {
+    copies++;
+    return *this;
+  }
+
+  CopyCounter& operator=(CopyCounter&&) noexcept
+  {
+    moves++;
+    return *this;
+  }
+
+  static void reset() noexcept
+  {
+    copies = 0;
+    moves = 0;
+  }
+
+  static inline size_t copies = 0;
+
+  static inline size_t moves = 0;
+};
@@ -0,0 +1,27 @@
+#include "pimpl_annotations.hpp"
+
+#include "CowFoo.hpp.generated.hpp"
+
+#include "CowFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+CowFoo::CowFoo() {
+}
+
+CowFoo::~CowFoo() {
+}
+
+// will replace itself with generated code like:
+// ::std::string CowFoo::text() const { return impl_.read().text(); }
+// void CowFoo::append(const ::std::string & suffix)
+// { return impl_.write().append(suffix); }
+template<
+  typename impl = example_impl::CowFooImpl
+  , typename interface = CowFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/CowPimpl.hpp>
+
+#include <string>
+
+namespace example_impl {
+
+class CowFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// copying interface does not copy impl
+class CowFoo {
+public:
+  CowFoo();
+
+  ~CowFoo();
+
+  // Will replace itself with generated code like:
+  // ::std::string text() const;
+  // void append(const ::std::string & suffix);
+  template<typename impl = example_impl::CowFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::CowPimpl<::example_impl::CowFooImpl> impl_;
+  template<
+    typename impl = example_impl::CowFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = cow"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <string>
+
+namespace example_impl {
+
+// impl shared by copies of interface until it is modified
+class CowFooImpl
+{
+ public:
+  std::string text() const
+  {
+    return text_;
+  }
+
+  void append(const std::string& suffix)
+  {
+    text_ += suffix;
+  }
+
+ private:
+  std::string text_ = "cow";
+};
+
+template<typename impl = CowFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
@@ -4,13 +4,19 @@
 
 #include "FooImpl.hpp.generated.hpp"
 
+#include <flex_pimpl_plugin/pimpl/CApi.h>
+#include <flex_pimpl_plugin/pimpl/Reconstruct.hpp>
+#include <flex_pimpl_plugin/pimpl/Snapshot.hpp>
+
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace example_interface {
@@ -29,12 +35,28 @@ Foo::~Foo() {
 
 // will replace itself with generated code like:
 // std::string foo() { return impl_->foo(); }
+// and extern "C" facade declared in `example_interface_Foo_c_api.h`
 template<
   typename impl = example_impl::FooImpl
   , typename interface = Foo
 >
-class _injectPimplMethodCalls()
+class _injectPimplMethodCalls("snapshot, c_api")
   PimplMethodCallsInjector
 {};
 
 } // namespace example_interface
+
+// Will replace itself with generated code like:
+// template ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>&
+//   ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>::operator=(
+//     ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>&&);
+// template
+//   ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>::~FastPimpl();
+// static_assert(sizeof(::example_impl::FooImpl) <= 64, "...");
+template<
+  typename impl = example_impl::FooImpl
+>
+class
+  _injectPimplExternTemplates()
+PimplExternTemplatesInjector
+{};
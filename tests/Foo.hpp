@@ -2,9 +2,20 @@
 
 #include "pimpl_annotations.hpp"
 
+#include "CopyCounter.hpp"
+
 #include <basis/core/pimpl.hpp>
 
+#include <base/containers/span.h>
+
+#include <flex_pimpl_plugin/pimpl/ForwardingMutex.hpp>
+#include <flex_pimpl_plugin/pimpl/MemoCache.hpp>
+
+#include <cstddef>
+#include <future>
 #include <string>
+#include <utility>
+#include <vector>
 
 /// \note store implementation in separate namespace
 /// for example purposes
@@ -27,10 +38,11 @@ public:
   // Will replace itself with generated code like:
   // std::string foo();
   // int bar(int&& arg1, const int& arg2) const noexcept;
+  // size_t snapshot(char* out) const;
   template<typename impl = example_impl::FooImpl>
   class
     _injectPimplMethodCalls(
-      "without_method_body"
+      "without_method_body, snapshot"
     )
   PimplMethodDeclsInjector
   {};
@@ -54,3 +66,24 @@ private:
 };
 
 } // namespace example_interface
+
+// Will replace itself with generated code like:
+// extern template ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>&
+//   ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>::operator=(
+//     ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>&&);
+// extern template
+//   ::basis::pimpl::FastPimpl<::example_impl::FooImpl, ...>::~FastPimpl();
+// extern template ::size_t example_interface::Foo::describe<int>(
+//   const ::std::enable_if_t<true, int> &) const;
+/// \note FooImpl is move-only, so copy operations
+/// of storage are not declared
+template<
+  typename impl = example_impl::FooImpl
+  , typename interface = example_interface::Foo
+>
+class
+  _injectPimplExternTemplates(
+    "without_method_body"
+  )
+PimplExternTemplatesInjector
+{};
@@ -2,6 +2,8 @@
 
 #include "FooImpl.hpp.generated.hpp"
 
+#include <algorithm>
+
 namespace example_impl {
 
 int FooImpl::foo(int&& arg1, const int& arg2) const noexcept {
@@ -12,6 +14,26 @@ const std::string FooImpl::baz() {
   return data_;
 }
 
+size_t FooImpl::store(CopyCounter counter) {
+  CopyCounter stored(std::move(counter));
+  return CopyCounter::copies;
+}
+
+size_t FooImpl::consume(CopyCounter&& counter) {
+  CopyCounter consumed(std::move(counter));
+  return CopyCounter::copies;
+}
+
+int FooImpl::multiply(int factor) const {
+  return static_cast<int>(data_.size()) * factor;
+}
+
+size_t FooImpl::count(char ch) const {
+  countCalls++;
+  return static_cast<size_t>(
+    std::count(data_.begin(), data_.end(), ch));
+}
+
 int FooImpl::bar(int a) {
   return 678;
 }
@@ -19,7 +41,15 @@ int FooImpl::bar(int a) {
 FooImpl::FooImpl() {
 }
 
+FooImpl::FooImpl(std::string data)
+  : data_(std::move(data)) {
+}
+
 FooImpl::~FooImpl() {
 }
 
+FooImpl::FooImpl(FooImpl&& other) noexcept = default;
+
+FooImpl& FooImpl::operator=(FooImpl&& other) noexcept = default;
+
 } // namespace example_impl
@@ -2,25 +2,83 @@
 
 #include "pimpl_annotations.hpp"
 
+#include "CopyCounter.hpp"
+
+#include <cstddef>
 #include <string>
 #include <memory>
 
+namespace example_interface {
+
+class Foo;
+
+} // namespace example_interface
+
 namespace example_impl {
 
 class FooImpl
 {
+  // `snapshot` of interface writes fields of impl
+  friend class ::example_interface::Foo;
+
  public:
   FooImpl();
 
+  // interface gets `explicit Foo(::std::string data)`
+  // and `void emplace(::std::string data)`
+  explicit FooImpl(std::string data);
+
   ~FooImpl();
 
+  // interface gets `noexcept` move operations
+  // only if impl can be moved without exceptions
+  FooImpl(FooImpl&& other) noexcept;
+
+  FooImpl& operator=(FooImpl&& other) noexcept;
+
+  // forwarders of const methods with `locking = shared`
+  // hold shared lock, so readers do not block each other
+  // (interface stores ::std::shared_mutex)
+  _pimplPolicy("locking = shared")
   int foo(int&& arg1, const int& arg2) const noexcept;
 
+  // forwarder locks mutex of interface,
+  // interface also gets `baz_async`
+  _pimplPolicy("locking = exclusive, async")
   const std::string baz();
 
+  // forwarders must move arguments passed by value
+  // and by rvalue reference (without copies)
+  size_t store(CopyCounter counter);
+
+  size_t consume(CopyCounter&& counter);
+
+  // interface gets static `multiply_batch`
+  // that calls method for span of objects
+  _pimplBatch()
+  int multiply(int factor) const;
+
+  // interface caches results per object,
+  // cache is cleared by non-const forwarders
+  _pimplPolicy("memoize = 4")
+  size_t count(char ch) const;
+
+  // forwarder is defined only in Foo.cc,
+  // so it is explicitly instantiated for listed types
+  template <typename T>
+  _pimplInstantiate(int)
+  _pimplInstantiate(::std::string)
+  size_t describe(const T& value) const
+  {
+    return sizeof(value) + data_.size();
+  }
+
   _skipForPimpl()
   int bar(int a);
 
+  // number of calls of `count` that were not served from cache
+  static inline size_t countCalls = 0;
+
  private:
   std::string data_{"somedata"};
 };
@@ -0,0 +1,30 @@
+#include "pimpl_annotations.hpp"
+
+#include "IsaFoo.hpp.generated.hpp"
+
+#include "IsaFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+// storage constructs alternative selected for host
+IsaFoo::IsaFoo() {
+}
+
+IsaFoo::~IsaFoo() {
+}
+
+// will replace itself with generated code like:
+// int IsaFoo::sum(int count) const
+// {
+//  return ImplDispatch::kTables[impl_.index()].sum(*this, count);
+// }
+template<
+  typename impl = example_impl::IsaFooImpl
+  , typename impl_1 = example_impl::IsaFooAvx2Impl
+  , typename interface = IsaFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
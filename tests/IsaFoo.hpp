@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/CpuDispatchPimpl.hpp>
+
+#include <string>
+
+namespace example_impl {
+
+class IsaFooImpl;
+
+class IsaFooAvx2Impl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// alternative is selected by features of host CPU
+class IsaFoo {
+public:
+  IsaFoo();
+
+  ~IsaFoo();
+
+  // Will replace itself with generated code like:
+  // ::std::string isa() const;
+  // int sum(int count) const;
+  template<
+    typename impl = example_impl::IsaFooImpl
+    , typename impl_1 = example_impl::IsaFooAvx2Impl
+  >
+  class
+    _injectPimplMethodCalls(
+      "without_method_body"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::CpuDispatchPimpl<...> impl_;
+  // struct ImplDispatch;
+  template<
+    typename impl = example_impl::IsaFooImpl
+    , typename impl_1 = example_impl::IsaFooAvx2Impl
+  >
+  class
+    _injectPimplStorage(
+      "storage = variant, isa_1 = avx2"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
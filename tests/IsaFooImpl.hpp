@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <string>
+
+namespace example_impl {
+
+// builds of same kernel for different ISA extensions,
+// in real code alternative is compiled with `-mavx2`
+class IsaFooImpl
+{
+ public:
+  std::string isa() const
+  {
+    return "baseline";
+  }
+
+  int sum(int count) const
+  {
+    int result = 0;
+    for(int i = 0; i < count; i++) {
+      result += i;
+    }
+    return result;
+  }
+};
+
+class IsaFooAvx2Impl
+{
+ public:
+  std::string isa() const
+  {
+    return "avx2";
+  }
+
+  int sum(int count) const
+  {
+    return count > 0
+      ? count * (count - 1) / 2
+      : 0;
+  }
+};
+
+template<typename impl = IsaFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+// each alternative is reflected separately
+template<typename impl = IsaFooAvx2Impl>
+class _reflectForPimpl()
+  PimplAvx2Reflector
+{};
+
+} // namespace example_impl
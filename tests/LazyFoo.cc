@@ -0,0 +1,26 @@
+#include "pimpl_annotations.hpp"
+
+#include "LazyFoo.hpp.generated.hpp"
+
+#include "LazyFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+LazyFoo::LazyFoo() {
+}
+
+LazyFoo::~LazyFoo() {
+}
+
+// will replace itself with generated code like:
+// int LazyFoo::value() const { return impl_.get().value(); }
+// LazyFoo::LazyFoo(int value) { impl_.emplace(value); }
+template<
+  typename impl = example_impl::LazyFooImpl
+  , typename interface = LazyFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/LazyPimpl.hpp>
+
+namespace example_impl {
+
+class LazyFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// impl is not constructed until first use
+class LazyFoo {
+public:
+  LazyFoo();
+
+  ~LazyFoo();
+
+  // Will replace itself with generated code like:
+  // explicit LazyFoo(int value);
+  // void emplace(int value);
+  // int value() const;
+  // void increment();
+  // struct Inline;
+  template<typename impl = example_impl::LazyFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body, inline_forwarders"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::LazyPimpl<::example_impl::LazyFooImpl, 4, 4> impl_;
+  template<
+    typename impl = example_impl::LazyFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = lazy"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
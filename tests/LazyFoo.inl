@@ -0,0 +1,24 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include "LazyFoo.hpp.generated.hpp"
+
+#include "LazyFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+// will replace itself with generated code like:
+// struct LazyFoo::Inline {
+//   static int value(const LazyFoo& self)
+//   { return self.impl_.get().value(); }
+// };
+template<
+  typename impl = example_impl::LazyFooImpl
+  , typename interface = LazyFoo
+>
+class _injectPimplMethodCalls("inline_forwarders")
+  PimplInlineForwardersInjector
+{};
+
+} // namespace example_interface
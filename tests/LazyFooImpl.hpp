@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+namespace example_impl {
+
+// impl constructed on first forwarded call,
+// also called via inline forwarders
+class LazyFooImpl
+{
+ public:
+  LazyFooImpl()
+    : value_(1)
+  {
+    constructions++;
+  }
+
+  // interface gets `explicit LazyFoo(int value)`
+  // and `void emplace(int value)`
+  explicit LazyFooImpl(int value)
+    : value_(value)
+  {
+    constructions++;
+  }
+
+  int value() const
+  {
+    return value_;
+  }
+
+  void increment()
+  {
+    value_++;
+  }
+
+  static inline int constructions = 0;
+
+ private:
+  int value_;
+};
+
+template<typename impl = LazyFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
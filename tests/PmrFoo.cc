@@ -0,0 +1,27 @@
+#include "pimpl_annotations.hpp"
+
+#include "PmrFoo.hpp.generated.hpp"
+
+#include "PmrFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+PmrFoo::PmrFoo() {
+}
+
+PmrFoo::~PmrFoo() {
+}
+
+// will replace itself with generated code like:
+// size_t PmrFoo::size() const { return impl_->size(); }
+// PmrFoo::PmrFoo(::std::allocator_arg_t, const allocator_type& alloc)
+//   : impl_(alloc) {}
+template<
+  typename impl = example_impl::PmrFooImpl
+  , typename interface = PmrFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <basis/core/pimpl.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+
+namespace example_impl {
+
+class PmrFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// impl uses memory resource passed to interface
+class PmrFoo {
+public:
+  PmrFoo();
+
+  ~PmrFoo();
+
+  // Will replace itself with generated code like:
+  // size_t size() const;
+  // void append(::std::string_view suffix);
+  template<typename impl = example_impl::PmrFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::basis::pimpl::FastPimpl<PmrFooImpl, /*Size*/ 40, /*Alignment*/ 8> impl_;
+  // public:
+  //   using allocator_type = ::std::pmr::polymorphic_allocator<::std::byte>;
+  //   explicit PmrFoo(::std::pmr::memory_resource* resource);
+  //   PmrFoo(::std::allocator_arg_t, const allocator_type& alloc);
+  //   PmrFoo(::std::allocator_arg_t, const allocator_type& alloc,
+  //     const PmrFoo& other);
+  //   PmrFoo(::std::allocator_arg_t, const allocator_type& alloc,
+  //     PmrFoo&& other);
+  //   allocator_type get_allocator() const noexcept;
+  template<
+    typename impl = example_impl::PmrFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "allocator = pmr"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
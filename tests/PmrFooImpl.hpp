@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace example_impl {
+
+// impl with `allocator_type`, constructor from allocator
+// and `get_allocator()`, used by `allocator = pmr`
+class PmrFooImpl
+{
+ public:
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  explicit PmrFooImpl(const allocator_type& alloc = {})
+    : data_("somedata, long enough to be allocated", alloc)
+  {}
+
+  allocator_type get_allocator() const
+  {
+    return data_.get_allocator();
+  }
+
+  size_t size() const
+  {
+    return data_.size();
+  }
+
+  void append(std::string_view suffix)
+  {
+    data_.append(suffix.data(), suffix.size());
+  }
+
+ private:
+  std::pmr::string data_;
+};
+
+template<typename impl = PmrFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
@@ -0,0 +1,26 @@
+#include "pimpl_annotations.hpp"
+
+#include "PoolFoo.hpp.generated.hpp"
+
+#include "PoolFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+PoolFoo::PoolFoo() {
+}
+
+PoolFoo::~PoolFoo() {
+}
+
+// will replace itself with generated code like:
+// int PoolFoo::add(int lhs, int rhs) const { return impl_->add(lhs, rhs); }
+// and perfect-hash table used by `PoolFoo::findMethod(name)`
+template<
+  typename impl = example_impl::PoolFooImpl
+  , typename interface = PoolFoo
+>
+class _injectPimplMethodCalls("by_name")
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/MethodTable.hpp>
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+
+#include <string_view>
+
+namespace example_impl {
+
+class PoolFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// interface stores single pointer to impl from pool
+class PoolFoo {
+public:
+  PoolFoo();
+
+  ~PoolFoo();
+
+  // Will replace itself with generated code like:
+  // int add(int lhs, int rhs) const;
+  // void setBias(int bias);
+  // static const ::flex_pimpl_plugin::pimpl::MethodEntry*
+  //   findMethod(::std::string_view name) noexcept;
+  template<typename impl = example_impl::PoolFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body, by_name"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::PoolPimpl<::example_impl::PoolFooImpl> impl_;
+  template<
+    typename impl = example_impl::PoolFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = pool"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
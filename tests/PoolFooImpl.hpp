@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+namespace example_impl {
+
+// impl allocated from pool, methods are also called by name
+class PoolFooImpl
+{
+ public:
+  int add(int lhs, int rhs) const
+  {
+    return lhs + rhs + bias_;
+  }
+
+  void setBias(int bias)
+  {
+    bias_ = bias;
+  }
+
+ private:
+  int bias_ = 0;
+};
+
+template<typename impl = PoolFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
@@ -0,0 +1,27 @@
+#include "pimpl_annotations.hpp"
+
+#include "RcuFoo.hpp.generated.hpp"
+
+#include "RcuFooImpl.hpp.generated.hpp"
+
+namespace example_interface {
+
+RcuFoo::RcuFoo() {
+}
+
+RcuFoo::~RcuFoo() {
+}
+
+// will replace itself with generated code like:
+// int RcuFoo::route(int key) const { return impl_.read()->route(key); }
+// void RcuFoo::setOffset(int offset)
+// { return impl_.write()->setOffset(offset); }
+template<
+  typename impl = example_impl::RcuFooImpl
+  , typename interface = RcuFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
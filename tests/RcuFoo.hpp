@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/RcuPimpl.hpp>
+
+namespace example_impl {
+
+class RcuFooImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// readers do not lock, writers publish modified clone
+class RcuFoo {
+public:
+  RcuFoo();
+
+  ~RcuFoo();
+
+  // Will replace itself with generated code like:
+  // int route(int key) const;
+  // void setOffset(int offset);
+  template<typename impl = example_impl::RcuFooImpl>
+  class
+    _injectPimplMethodCalls(
+      "without_method_body"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::RcuPimpl<::example_impl::RcuFooImpl> impl_;
+  template<
+    typename impl = example_impl::RcuFooImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = rcu"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
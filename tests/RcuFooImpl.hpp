@@ -0,0 +1,31 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+namespace example_impl {
+
+// read-mostly impl, methods return values
+// (not references into impl)
+class RcuFooImpl
+{
+ public:
+  int route(int key) const
+  {
+    return key + offset_;
+  }
+
+  void setOffset(int offset)
+  {
+    offset_ = offset;
+  }
+
+ private:
+  int offset_ = 0;
+};
+
+template<typename impl = RcuFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+} // namespace example_impl
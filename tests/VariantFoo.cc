@@ -0,0 +1,40 @@
+#include "pimpl_annotations.hpp"
+
+#include "VariantFoo.hpp.generated.hpp"
+
+#include "VariantFooImpl.hpp.generated.hpp"
+
+#include <utility>
+
+namespace example_interface {
+
+// interface selects alternative
+VariantFoo::VariantFoo(bool fast)
+  : impl_(std::in_place_index<0>)
+{
+  if(fast) {
+    impl_.emplace<1>();
+  }
+}
+
+VariantFoo::~VariantFoo() {
+}
+
+// will replace itself with generated code like:
+// int VariantFoo::scale(int value) const
+// {
+//  switch(impl_.index()) {
+//   case 0: return impl_.get<0>().scale(value);
+//   default: return impl_.get<1>().scale(value);
+//  }
+// }
+template<
+  typename impl = example_impl::VariantFooImpl
+  , typename impl_1 = example_impl::VariantFooFastImpl
+  , typename interface = VariantFoo
+>
+class _injectPimplMethodCalls()
+  PimplMethodCallsInjector
+{};
+
+} // namespace example_interface
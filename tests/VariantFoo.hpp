@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <flex_pimpl_plugin/pimpl/VariantPimpl.hpp>
+
+#include <string>
+
+namespace example_impl {
+
+class VariantFooImpl;
+
+class VariantFooFastImpl;
+
+} // namespace example_impl
+
+namespace example_interface {
+
+// stores one of impls, chosen at runtime
+class VariantFoo {
+public:
+  explicit VariantFoo(bool fast = false);
+
+  ~VariantFoo();
+
+  // Will replace itself with generated code like:
+  // ::std::string name() const;
+  // int scale(int value) const;
+  template<
+    typename impl = example_impl::VariantFooImpl
+    , typename impl_1 = example_impl::VariantFooFastImpl
+  >
+  class
+    _injectPimplMethodCalls(
+      "without_method_body"
+    )
+  PimplMethodDeclsInjector
+  {};
+
+private:
+  // Will replace itself with generated code like:
+  // ::flex_pimpl_plugin::VariantPimpl<
+  //   /*Size*/ 1, /*Alignment*/ 1
+  //   , ::example_impl::VariantFooImpl
+  //   , ::example_impl::VariantFooFastImpl> impl_;
+  template<
+    typename impl = example_impl::VariantFooImpl
+    , typename impl_1 = example_impl::VariantFooFastImpl
+  >
+  class
+    _injectPimplStorage(
+      "storage = variant"
+    )
+  PimplStorageInjector
+  {};
+};
+
+} // namespace example_interface
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pimpl_annotations.hpp"
+
+#include <string>
+
+namespace example_impl {
+
+// alternatives of `storage = variant`,
+// methods with same signature are forwarded
+class VariantFooImpl
+{
+ public:
+  std::string name() const
+  {
+    return "slow";
+  }
+
+  int scale(int value) const
+  {
+    return value * 2;
+  }
+};
+
+class VariantFooFastImpl
+{
+ public:
+  std::string name() const
+  {
+    return "fast";
+  }
+
+  int scale(int value) const
+  {
+    return value << 1;
+  }
+};
+
+template<typename impl = VariantFooImpl>
+class _reflectForPimpl()
+  PimplReflector
+{};
+
+// each alternative is reflected separately
+template<typename impl = VariantFooFastImpl>
+class _reflectForPimpl()
+  PimplFastReflector
+{};
+
+} // namespace example_impl
@@ -0,0 +1,154 @@
+#include "testsCommon.h"
+
+#if !defined(USE_GTEST_TEST)
+#warning "use USE_GTEST_TEST"
+// default
+#define USE_GTEST_TEST 1
+#endif // !defined(USE_GTEST_TEST)
+
+#include <flex_pimpl_plugin/pimpl/ForwardingMutex.hpp>
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+
+#include <base/compiler_specific.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+static const int kCallsPerThread = 1 << 15;
+
+static const int kIterations = 5;
+
+// percent of calls that modify impl
+static const int kWritePercents[] = {0, 1, 10};
+
+struct BenchImpl {
+  // read of moderate cost, so readers overlap inside critical section
+  NOINLINE uint64_t score(int key) const
+  {
+    uint64_t hash = seed;
+    for(int i = 0; i < 64; i++) {
+      hash = (hash ^ static_cast<uint64_t>(key + i)) * 0x100000001b3;
+    }
+    return hash;
+  }
+
+  NOINLINE void reseed(int key)
+  {
+    seed ^= static_cast<uint64_t>(key);
+  }
+
+  uint64_t seed = 0xcbf29ce484222325;
+};
+
+// Same layout as generated interface with `storage = pool`
+// and methods with `locking = exclusive` (|Mutex| is ::std::mutex)
+// or `locking = shared` (|Mutex| is ::std::shared_mutex).
+// Forwarders are defined out-of-line (in Foo.cc),
+// so they can not be inlined into caller.
+template <typename Mutex>
+class BenchFoo {
+public:
+  NOINLINE uint64_t score(int key) const
+  {
+    // similar to code generated for const forwarder
+    if constexpr (std::is_same_v<Mutex, std::shared_mutex>) {
+      ::std::shared_lock implLock(implMutex_);
+      return impl_->score(key);
+    } else {
+      ::std::lock_guard implLock(implMutex_);
+      return impl_->score(key);
+    }
+  }
+
+  NOINLINE void reseed(int key)
+  {
+    ::std::lock_guard implLock(implMutex_);
+    return impl_->reseed(key);
+  }
+
+private:
+  ::flex_pimpl_plugin::PoolPimpl<BenchImpl> impl_;
+
+  mutable ::flex_pimpl_plugin::pimpl::ForwardingMutex<Mutex> implMutex_;
+};
+
+// All threads call same object,
+// |writePercent| calls of every hundred modify it.
+template <typename Mutex>
+double measureCalls(int threadCount, int writePercent)
+{
+  using clock = std::chrono::steady_clock;
+  clock::duration total{};
+  std::atomic<uint64_t> checksum{0};
+
+  for(int iteration = 0; iteration < kIterations; iteration++) {
+    BenchFoo<Mutex> foo;
+    std::atomic<bool> isStarted{false};
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < threadCount; t++) {
+      threads.emplace_back([&foo, &isStarted, &checksum, writePercent, t]() {
+        while(!isStarted.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        uint64_t sum = 0;
+        for(int i = 0; i < kCallsPerThread; i++) {
+          if((i % 100) < writePercent) {
+            foo.reseed(i + t);
+          } else {
+            sum += foo.score(i);
+          }
+        }
+        checksum.fetch_add(sum, std::memory_order_relaxed);
+      });
+    }
+
+    const clock::time_point start = clock::now();
+    isStarted.store(true, std::memory_order_release);
+    for(std::thread& thread : threads) {
+      thread.join();
+    }
+    total += clock::now() - start;
+  }
+
+  EXPECT_NE(checksum.load(), 0u);
+
+  return std::chrono::duration<double, std::milli>(total).count()
+    / kIterations;
+}
+
+} // namespace
+
+TEST(lockingBenchmark, readHeavyContention) {
+  const int threadCount = static_cast<int>(
+    std::max(2u, std::min(8u, std::thread::hardware_concurrency())));
+
+  for(const int writePercent : kWritePercents) {
+    const double exclusiveMs
+      = measureCalls<std::mutex>(threadCount, writePercent);
+    const double sharedMs
+      = measureCalls<std::shared_mutex>(threadCount, writePercent);
+
+    std::cout
+      << threadCount
+      << " threads, "
+      << writePercent
+      << "% writes: locking = exclusive "
+      << exclusiveMs
+      << " ms, locking = shared "
+      << sharedMs
+      << " ms"
+      << std::endl;
+  }
+}
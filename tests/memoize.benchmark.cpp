@@ -0,0 +1,130 @@
+#include "testsCommon.h"
+
+#if !defined(USE_GTEST_TEST)
+#warning "use USE_GTEST_TEST"
+// default
+#define USE_GTEST_TEST 1
+#endif // !defined(USE_GTEST_TEST)
+
+#include <flex_pimpl_plugin/pimpl/MemoCache.hpp>
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+
+#include <base/compiler_specific.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+static const int kCalls = 1 << 16;
+
+static const int kIterations = 10;
+
+// percent of calls that repeat recently used arguments
+static const int kHitPercents[] = {0, 50, 90, 99};
+
+struct BenchImpl {
+  // expensive pure function of arguments and impl
+  NOINLINE uint64_t score(int key) const
+  {
+    uint64_t hash = seed;
+    for(int i = 0; i < 512; i++) {
+      hash = (hash ^ static_cast<uint64_t>(key + i)) * 0x100000001b3;
+    }
+    return hash;
+  }
+
+  uint64_t seed = 0xcbf29ce484222325;
+};
+
+// Same layout as generated interface with `storage = pool`
+// and method with `memoize` policy.
+// Forwarders are defined out-of-line (in Foo.cc),
+// so they can not be inlined into caller.
+template <bool kMemoize>
+class BenchFoo {
+public:
+  NOINLINE uint64_t score(int key) const
+  {
+    if constexpr (kMemoize) {
+      // similar to code generated for memoized forwarder
+      const auto memoKey = ::std::forward_as_tuple(key);
+      if(const auto* cached = scoreMemo_.find(memoKey)) {
+        return *cached;
+      }
+      return scoreMemo_.insert(memoKey, [&]() {
+        return impl_->score(key);
+      }());
+    } else {
+      return impl_->score(key);
+    }
+  }
+
+  size_t hits() const
+  {
+    return scoreMemo_.hits();
+  }
+
+private:
+  ::flex_pimpl_plugin::PoolPimpl<BenchImpl> impl_;
+
+  mutable ::flex_pimpl_plugin::pimpl::MemoCache<
+    ::std::tuple<int>
+    , uint64_t
+    , ::flex_pimpl_plugin::pimpl::kDefaultMemoCapacity> scoreMemo_;
+};
+
+// First |hitPercent| calls of every hundred use same argument,
+// other calls use unique arguments (always miss).
+template <bool kMemoize>
+double measureCalls(int hitPercent, size_t* hits)
+{
+  using clock = std::chrono::steady_clock;
+  clock::duration total{};
+  uint64_t checksum = 0;
+
+  for(int iteration = 0; iteration < kIterations; iteration++) {
+    BenchFoo<kMemoize> foo;
+
+    const clock::time_point start = clock::now();
+    for(int i = 0; i < kCalls; i++) {
+      const int key = (i % 100) < hitPercent ? 0 : i + 1;
+      checksum += foo.score(key);
+    }
+    total += clock::now() - start;
+
+    *hits += foo.hits();
+  }
+
+  EXPECT_NE(checksum, 0u);
+
+  return std::chrono::duration<double, std::milli>(total).count()
+    / kIterations;
+}
+
+} // namespace
+
+TEST(memoizeBenchmark, hitRate) {
+  for(const int hitPercent : kHitPercents) {
+    size_t plainHits = 0;
+    size_t memoHits = 0;
+    const double plainMs = measureCalls<false>(hitPercent, &plainHits);
+    const double memoMs = measureCalls<true>(hitPercent, &memoHits);
+
+    EXPECT_EQ(plainHits, 0u);
+
+    std::cout
+      << "hit rate "
+      << (100.0 * memoHits) / (kCalls * kIterations)
+      << "%: plain forwarder "
+      << plainMs
+      << " ms, memoized forwarder "
+      << memoMs
+      << " ms"
+      << std::endl;
+  }
+}
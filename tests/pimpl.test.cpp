@@ -7,12 +7,16 @@
 #endif // !defined(USE_GTEST_TEST)
 
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <algorithm>
 
@@ -158,6 +162,19 @@
 
 #include <Foo.hpp.generated.hpp>
 #include <FooImpl.hpp.generated.hpp>
+#include <PmrFoo.hpp.generated.hpp>
+#include <PoolFoo.hpp.generated.hpp>
+#include <AutoFoo.hpp.generated.hpp>
+#include <AutoFooImpl.hpp.generated.hpp>
+#include <VariantFoo.hpp.generated.hpp>
+#include <IsaFoo.hpp.generated.hpp>
+#include <CowFoo.hpp.generated.hpp>
+#include <RcuFoo.hpp.generated.hpp>
+// includes generated LazyFoo.hpp and LazyFooImpl.hpp
+#include <LazyFoo.inl.generated.inl>
+
+// written by `c_api` of Foo.cc
+#include <example_interface_Foo_c_api.h>
 
 TEST(pimpl, pimplGeneration) {
   example_interface::Foo foo;
@@ -168,3 +185,386 @@ TEST(pimpl, pimplGeneration) {
 
   EXPECT_EQ(foo.baz(), "somedata");
 }
+
+TEST(pimpl, forwardersDoNotCopyArguments) {
+  example_interface::Foo foo;
+
+  CopyCounter::reset();
+
+  // by-value argument is moved from forwarder into impl
+  EXPECT_EQ(foo.store(CopyCounter{}), 0u);
+  EXPECT_EQ(CopyCounter::copies, 0u);
+  EXPECT_EQ(CopyCounter::moves, 2u);
+
+  CopyCounter::reset();
+
+  // rvalue reference is forwarded without temporaries
+  CopyCounter counter;
+  EXPECT_EQ(foo.consume(std::move(counter)), 0u);
+  EXPECT_EQ(CopyCounter::copies, 0u);
+  EXPECT_EQ(CopyCounter::moves, 1u);
+}
+
+TEST(pimpl, batchForwarderCallsMethodForEachObject) {
+  example_interface::Foo foos[3];
+
+  int out[3] = {0, 0, 0};
+
+  example_interface::Foo::multiply_batch(foos, 2, out);
+
+  // `somedata` has 8 characters
+  for(int result : out) {
+    EXPECT_EQ(result, 16);
+  }
+}
+
+// move operations are generated based on move traits of impl
+static_assert(
+  std::is_nothrow_move_constructible_v<example_interface::Foo>
+  , "vector of interfaces must move elements on reallocation");
+
+static_assert(
+  std::is_nothrow_move_assignable_v<example_interface::Foo>
+  , "generated move assignment must be noexcept");
+
+TEST(pimpl, generatedMoveOperationsAndSwap) {
+  example_interface::Foo foo;
+
+  example_interface::Foo moved(std::move(foo));
+  EXPECT_EQ(moved.baz(), "somedata");
+
+  swap(foo, moved);
+  EXPECT_EQ(foo.baz(), "somedata");
+
+  std::vector<example_interface::Foo> foos(2);
+  // reallocation moves elements
+  foos.reserve(foos.capacity() * 2 + 1);
+  EXPECT_EQ(foos.back().baz(), "somedata");
+}
+
+TEST(pimpl, forwardingConstructorBuildsImplInPlace) {
+  example_interface::Foo foo(std::string("custom"));
+  EXPECT_EQ(foo.baz(), "custom");
+
+  // reuses storage of impl
+  foo.emplace(std::string("other"));
+  EXPECT_EQ(foo.baz(), "other");
+}
+
+TEST(pimpl, memoizedForwarderCachesResults) {
+  example_interface::Foo foo(std::string("banana"));
+  const size_t callsBefore = example_impl::FooImpl::countCalls;
+
+  EXPECT_EQ(foo.count('a'), 3u);
+  EXPECT_EQ(foo.count('a'), 3u);
+  EXPECT_EQ(foo.count('n'), 2u);
+  EXPECT_EQ(example_impl::FooImpl::countCalls - callsBefore, 2u);
+
+  // impl is replaced, so cached results are dropped
+  foo.emplace("aaaa");
+  EXPECT_EQ(foo.count('a'), 4u);
+  EXPECT_EQ(example_impl::FooImpl::countCalls - callsBefore, 3u);
+
+  // any non-const forwarder may change impl
+  EXPECT_EQ(foo.baz(), "aaaa");
+  EXPECT_EQ(foo.count('a'), 4u);
+  EXPECT_EQ(example_impl::FooImpl::countCalls - callsBefore, 4u);
+}
+
+TEST(pimpl, templateForwarderIsInstantiatedInSourceFile) {
+  const example_interface::Foo foo(std::string("banana"));
+
+  // template forwarders are defined only in Foo.cc
+  EXPECT_EQ(foo.describe(1), sizeof(int) + 6);
+  EXPECT_EQ(foo.describe(std::string("x")), sizeof(std::string) + 6);
+}
+
+TEST(pimpl, snapshotRestoresImplState) {
+  const example_interface::Foo source(std::string("banana"));
+
+  // impl is not trivially copyable, so field is written with length
+  const size_t size = source.snapshotSize();
+  EXPECT_EQ(size, sizeof(uint64_t) + 6);
+  std::vector<char> buffer(size);
+  EXPECT_EQ(source.snapshot(buffer.data()), size);
+
+  example_interface::Foo restored;
+  EXPECT_EQ(restored.count('a'), 2u);
+  // truncated snapshot is rejected
+  EXPECT_EQ(restored.restore(buffer.data(), size - 1), 0u);
+  EXPECT_EQ(restored.restore(buffer.data(), size), size);
+  EXPECT_EQ(restored.baz(), "banana");
+  // restore clears cached results
+  EXPECT_EQ(restored.count('a'), 3u);
+
+  std::vector<example_interface::Foo> foos;
+  foos.emplace_back(std::string("first"));
+  foos.emplace_back(std::string("second"));
+  std::vector<char> bulk(example_interface::Foo::snapshotSize(foos));
+  EXPECT_EQ(example_interface::Foo::snapshot(foos, bulk.data()), bulk.size());
+
+  std::vector<example_interface::Foo> copies(2);
+  EXPECT_EQ(
+    example_interface::Foo::restore(copies, bulk.data(), bulk.size() - 1)
+    , 0u);
+  EXPECT_EQ(
+    example_interface::Foo::restore(copies, bulk.data(), bulk.size())
+    , bulk.size());
+  EXPECT_EQ(copies[0].baz(), "first");
+  EXPECT_EQ(copies[1].baz(), "second");
+}
+
+TEST(pimpl, cApiFacadeForwardsToInterface) {
+  const std::string data = "banana";
+  example_interface_Foo* foo
+    = example_interface_Foo_create_1(data.data(), data.size());
+  ASSERT_NE(foo, nullptr);
+
+  // `int&&` parameter of impl is passed by value
+  EXPECT_EQ(example_interface_Foo_foo(foo, 1, 2), 1234);
+  EXPECT_EQ(example_interface_Foo_count(foo, 'a'), 3u);
+  EXPECT_EQ(example_interface_Foo_multiply(foo, 2), 12);
+
+  // string returned by value is copied into buffer of caller,
+  // result is full size, so caller can retry with larger buffer
+  char small[3] = {};
+  EXPECT_EQ(
+    example_interface_Foo_baz(foo, small, sizeof(small))
+    , data.size());
+  EXPECT_EQ(std::string(small, sizeof(small)), "ban");
+  std::vector<char> buffer(data.size());
+  EXPECT_EQ(
+    example_interface_Foo_baz(foo, buffer.data(), buffer.size())
+    , data.size());
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), data);
+
+  example_interface_Foo_destroy(foo);
+
+  example_interface_Foo* defaultFoo = example_interface_Foo_create();
+  EXPECT_EQ(example_interface_Foo_multiply(defaultFoo, 1), 8);
+  example_interface_Foo_destroy(defaultFoo);
+}
+
+TEST(pimpl, policyOfMethodIsHonoured) {
+  example_interface::Foo foo;
+
+  // `async` policy, forwarder is called by task
+  std::future<std::string> result = foo.baz_async();
+  EXPECT_EQ(result.get(), "somedata");
+
+  // `locking = exclusive` policy of `baz`
+  // and `locking = shared` policy of const `foo`
+  std::vector<std::thread> threads;
+  for(int i = 0; i < 4; i++) {
+    threads.emplace_back([&foo]() {
+      for(int j = 0; j < 100; j++) {
+        EXPECT_EQ(foo.baz(), "somedata");
+      }
+    });
+    threads.emplace_back([&foo]() {
+      for(int j = 0; j < 100; j++) {
+        EXPECT_EQ(foo.foo(1, 2), 1234);
+      }
+    });
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(pimpl, generatedSwapLocksBothObjects) {
+  example_interface::Foo first;
+  example_interface::Foo second(std::string("custom"));
+
+  // forwarders see either impl, never impl that is being swapped
+  std::thread swapper([&first, &second]() {
+    for(int i = 0; i < 100; i++) {
+      swap(first, second);
+    }
+  });
+  for(int i = 0; i < 100; i++) {
+    const std::string result = first.baz();
+    EXPECT_TRUE(result == "somedata" || result == "custom") << result;
+  }
+  swapper.join();
+
+  // even number of swaps
+  EXPECT_EQ(first.baz(), "somedata");
+  EXPECT_EQ(second.baz(), "custom");
+}
+
+namespace {
+
+// counts allocations made by impls of pmr interface
+class CountingResource : public std::pmr::memory_resource {
+public:
+  size_t allocations = 0;
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override
+  {
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+  {
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  }
+
+  bool do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+} // namespace
+
+TEST(pimpl, pmrContainerPassesMemoryResourceToImpl) {
+  CountingResource resource;
+  std::pmr::vector<example_interface::PmrFoo> foos(&resource);
+  foos.reserve(4);
+  const size_t vectorAllocations = resource.allocations;
+
+  // constructed as `PmrFoo(::std::allocator_arg, alloc)`
+  foos.emplace_back();
+  EXPECT_EQ(resource.allocations - vectorAllocations, 1u);
+
+  // impl of element is copied or moved into memory resource of vector
+  example_interface::PmrFoo outside;
+  outside.append("!");
+  foos.push_back(outside);
+  const size_t copyAllocations = resource.allocations;
+  foos.push_back(std::move(outside));
+  EXPECT_GT(resource.allocations, copyAllocations);
+
+  // reallocation moves elements with allocator of vector
+  foos.emplace_back();
+  foos.emplace_back();
+  for(const example_interface::PmrFoo& foo : foos) {
+    EXPECT_EQ(foo.get_allocator().resource(), &resource);
+  }
+  EXPECT_EQ(foos[1].size(), foos[0].size() + 1);
+  EXPECT_EQ(foos[2].size(), foos[0].size() + 1);
+}
+
+TEST(pimpl, poolStorageFindsMethodByName) {
+  example_interface::PoolFoo foo;
+  foo.setBias(1);
+  EXPECT_EQ(foo.add(2, 3), 6);
+
+  // `by_name`
+  const ::flex_pimpl_plugin::pimpl::MethodEntry* entry
+    = example_interface::PoolFoo::findMethod("add");
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->arity, 2u);
+  EXPECT_TRUE(entry->isConst);
+  int lhs = 4;
+  int rhs = 5;
+  void* const args[] = {&lhs, &rhs};
+  int result = 0;
+  entry->invoke(&foo, args, &result);
+  EXPECT_EQ(result, 10);
+  EXPECT_FALSE(example_interface::PoolFoo::findMethod("missing"));
+
+  // moved-from interface must only be destroyed or assigned to
+  example_interface::PoolFoo moved(std::move(foo));
+  EXPECT_EQ(moved.add(0, 0), 1);
+  foo = example_interface::PoolFoo();
+  EXPECT_EQ(foo.add(0, 0), 0);
+}
+
+// impl is larger than `inlineBudget`, so pointer to pool is stored
+static_assert(
+  sizeof(example_interface::AutoFoo)
+    < sizeof(example_impl::AutoFooImpl)
+  , "storage = auto must select pool storage for large impl");
+
+TEST(pimpl, autoStorageCallsHotSwapTable) {
+  example_interface::AutoFoo foo;
+  foo.set(0, 2);
+  foo.set(63, 3);
+  EXPECT_EQ(foo.sum(), 5);
+
+  // table of same build has same layout
+  EXPECT_TRUE(example_interface::AutoFoo::swapImplTable(
+    example_interface::AutoFoo::builtinImplTable()));
+  EXPECT_EQ(foo.sum(), 5);
+}
+
+TEST(pimpl, lazyStorageConstructsImplOnFirstCall) {
+  const int constructions = example_impl::LazyFooImpl::constructions;
+
+  example_interface::LazyFoo foo;
+  EXPECT_EQ(example_impl::LazyFooImpl::constructions, constructions);
+  EXPECT_EQ(foo.value(), 1);
+  EXPECT_EQ(example_impl::LazyFooImpl::constructions, constructions + 1);
+
+  // `inline_forwarders`
+  example_interface::LazyFoo::Inline::increment(foo);
+  EXPECT_EQ(example_interface::LazyFoo::Inline::value(foo), 2);
+
+  // forwarding constructor and `emplace`
+  example_interface::LazyFoo other(5);
+  EXPECT_EQ(other.value(), 5);
+  other.emplace(7);
+  EXPECT_EQ(other.value(), 7);
+}
+
+TEST(pimpl, variantStorageForwardsToStoredAlternative) {
+  example_interface::VariantFoo slow;
+  EXPECT_EQ(slow.name(), "slow");
+  EXPECT_EQ(slow.scale(3), 6);
+
+  example_interface::VariantFoo fast(true);
+  EXPECT_EQ(fast.name(), "fast");
+  EXPECT_EQ(fast.scale(3), 6);
+
+  // copy keeps alternative
+  example_interface::VariantFoo copy(fast);
+  EXPECT_EQ(copy.name(), "fast");
+  swap(copy, slow);
+  EXPECT_EQ(copy.name(), "slow");
+  EXPECT_EQ(slow.name(), "fast");
+}
+
+TEST(pimpl, isaStorageSelectsAlternativeOnce) {
+  example_interface::IsaFoo foo;
+  const std::string isa = foo.isa();
+  EXPECT_TRUE(isa == "baseline" || isa == "avx2") << isa;
+  EXPECT_EQ(foo.sum(10), 45);
+
+  // every object uses alternative selected for host
+  example_interface::IsaFoo other;
+  EXPECT_EQ(other.isa(), isa);
+  example_interface::IsaFoo copy(foo);
+  EXPECT_EQ(copy.isa(), isa);
+}
+
+TEST(pimpl, cowStorageClonesImplOnWrite) {
+  example_interface::CowFoo original;
+  example_interface::CowFoo copy(original);
+  EXPECT_EQ(copy.text(), "cow");
+
+  copy.append("!");
+  EXPECT_EQ(copy.text(), "cow!");
+  EXPECT_EQ(original.text(), "cow");
+}
+
+TEST(pimpl, rcuStoragePublishesModifiedImpl) {
+  example_interface::RcuFoo foo;
+  EXPECT_EQ(foo.route(1), 1);
+
+  // readers see old or new impl, never partially modified impl
+  std::thread writer([&foo]() {
+    for(int i = 1; i <= 100; i++) {
+      foo.setOffset(i * 10);
+    }
+  });
+  for(int i = 0; i < 100; i++) {
+    EXPECT_EQ(foo.route(1) % 10, 1);
+  }
+  writer.join();
+  EXPECT_EQ(foo.route(1), 1001);
+}
@@ -5,6 +5,18 @@
 // ::basis::pimpl::FastPimpl<FooImpl, /*Size*/ 64, /*Alignment*/ 12> impl_;
 /// \note sizePadding adds extra bytes
 /// to aligned_storage used by fast PImpl
+/// \note "storage = pool" allocates impl from
+/// size-class pool instead of inline storage
+/// \note "storage = lazy" constructs impl on first use
+/// \note "storage = variant" stores one of impls passed as
+/// `impl`, `impl_1`, `impl_2`, etc. template parameters
+/// \note "storage = cow" shares impl between copies
+/// and clones it before modification (copy-on-write)
+/// \note "storage = rcu" publishes immutable impl atomically,
+/// const forwarders read it without locks,
+/// non-const forwarders modify and publish clone of impl
+/// \note "allocator = pmr" generates constructor from
+/// std::pmr::memory_resource that is passed to impl
 #define _injectPimplStorage(settings) \
   __attribute__((annotate("{gen};{funccall};inject_pimpl_storage(" settings ")")))
 
@@ -33,15 +45,155 @@
   class _injectPimplMethodCalls()
     PimplMethodCallsInjector
   {};
+ * EXAMPLE:
+  // "inline_forwarders" in header declares `struct Inline;`
+  // inside interface, same argument in `.inl` file
+  // (that includes impl) defines it:
+  // struct Foo::Inline {
+  //   static std::string baz(Foo& self) { return self.impl_->baz(); }
+  // };
+  template<
+    typename impl = example_impl::FooImpl
+    , typename interface = Foo
+  >
+  class _injectPimplMethodCalls("inline_forwarders")
+    PimplInlineForwardersInjector
+  {};
+ * EXAMPLE:
+  // "hot_swap" in header declares `struct ImplTable;`,
+  // `builtinImplTable()` and `swapImplTable(table)` inside interface,
+  // same argument in `.cc` file defines table of forwarders
+  // that are called via ::flex_pimpl_plugin::pimpl::HotSwapSlot
+  template<
+    typename impl = example_impl::FooImpl
+    , typename interface = Foo
+  >
+  class _injectPimplMethodCalls("hot_swap")
+    PimplMethodCallsInjector
+  {};
+ * EXAMPLE:
+  // "by_name" in header declares static `findMethod(name)` inside interface,
+  // same argument in `.cc` file defines perfect-hash table
+  // of ::flex_pimpl_plugin::pimpl::MethodEntry (overloaded
+  // and template methods are skipped)
+  template<
+    typename impl = example_impl::FooImpl
+    , typename interface = Foo
+  >
+  class _injectPimplMethodCalls("by_name")
+    PimplMethodCallsInjector
+  {};
+ * EXAMPLE:
+  // "c_api" in `.cc` file defines extern "C" facade
+  // (create, destroy and function for each method) and writes
+  // its declarations into `example_interface_Foo_c_api.h`
+  // in output directory, see <flex_pimpl_plugin/pimpl/CApi.h>
+  template<
+    typename impl = example_impl::FooImpl
+    , typename interface = Foo
+  >
+  class _injectPimplMethodCalls("c_api")
+    PimplMethodCallsInjector
+  {};
+ * EXAMPLE:
+  // "snapshot" in header declares `snapshotSize()`, `snapshot(out)`,
+  // `restore(in, size)` and their versions for span of objects,
+  // same argument in `.cc` file defines them via `memcpy` of impl
+  // or via ::flex_pimpl_plugin::pimpl::SnapshotTraits of each field
+  template<
+    typename impl = example_impl::FooImpl
+    , typename interface = Foo
+  >
+  class _injectPimplMethodCalls("snapshot")
+    PimplMethodCallsInjector
+  {};
  **/
 #define _injectPimplMethodCalls(settings) \
   __attribute__((annotate("{gen};{funccall};inject_pimpl_method_calls(" settings ")")))
 
+/**
+ * generates `extern template` declarations of special members
+ * of storage and their explicit instantiation with layout checks,
+ * so members of storage are instantiated only in one TU
+ * (copy operations only if impl is copyable).
+ * With `interface` parameter header also gets `extern template`
+ * declarations of forwarders listed by `_pimplInstantiate`.
+ * \note must be placed at global namespace scope
+ * after interface that stores impl.
+ * EXAMPLE (header):
+  template<typename impl = example_impl::FooImpl>
+  class _injectPimplExternTemplates("without_method_body")
+    PimplExternTemplatesInjector
+  {};
+ * EXAMPLE (source file, where impl is complete type):
+  template<typename impl = example_impl::FooImpl>
+  class _injectPimplExternTemplates()
+    PimplExternTemplatesInjector
+  {};
+ **/
+#define _injectPimplExternTemplates(settings) \
+  __attribute__((annotate("{gen};{funccall};inject_pimpl_extern_templates(" settings ")")))
+
 /// \note you must reflect PImpl implementation
 /// before using it by code generator.
+/// \note "locking = shared" (or "locking = exclusive") is `locking`
+/// policy of every non-static method without own `locking` policy
 #define _reflectForPimpl(settings) \
   __attribute__((annotate("{gen};{funccall};reflect_for_pimpl(" settings ")")))
 
 // skip injection of some methods from implementation
 #define _skipForPimpl() \
   __attribute__((annotate("skip_pimpl")))
+
+// generate static forwarder `foo_batch(::base::span<Foo>, ...)`
+// for method `foo` of implementation
+// (calls method for each object inside translation unit of interface)
+/// \note header of interface must include <base/containers/span.h>
+#define _pimplBatch() \
+  __attribute__((annotate("batch_pimpl")))
+
+// per-method policy of generated forwarders, settings:
+//  forwarding = inline | out_of_line
+//    (`inline_forwarders` always or never generates inline forwarder)
+//  section = hot | cold
+//    (`[[gnu::hot]]` or `[[gnu::cold]]`, overrides profile)
+//  locking = none | exclusive | shared
+//    (forwarder locks mutex of interface,
+//     `shared` locks it shared if const method is not memoized,
+//     header of interface must include
+//     <flex_pimpl_plugin/pimpl/ForwardingMutex.hpp>)
+//  memoize | memoize = <capacity>
+//    (const method is pure function of arguments and impl,
+//     interface caches results per object,
+//     header of interface must include
+//     <flex_pimpl_plugin/pimpl/MemoCache.hpp>)
+//  batch
+//    (same as `_pimplBatch()`)
+//  async
+//    (interface gets `foo_async` that returns ::std::future,
+//     header of interface must include <future>,
+//     requires `locking = exclusive` or `locking = shared`)
+// example: _pimplPolicy("section = hot, locking = exclusive")
+#define _pimplPolicy(settings) \
+  __attribute__((annotate("pimpl_policy(" settings ")")))
+
+// explicit instantiation of forwarder of method template
+// (forwarder defined in `.cc` file is not visible to callers),
+// one annotation for each set of template arguments,
+// types must be fully qualified
+/// \note `.cc` file of interface must include <type_traits>,
+/// `_injectPimplExternTemplates` with `interface` argument
+/// also declares `extern template` in header
+// example:
+//  template <typename T, int N>
+//  _pimplInstantiate(int, 4)
+//  _pimplInstantiate(::std::string, 8)
+//  size_t describe(const T& value) const;
+#define _pimplInstantiate(...) \
+  __attribute__((annotate("pimpl_instantiate(" #__VA_ARGS__ ")")))
+
+// mark implementation as trivially relocatable
+// (interface will be relocated via memcpy),
+// used if code generator can not detect it automatically
+#define _pimplTriviallyRelocatable() \
+  __attribute__((annotate("pimpl_trivially_relocatable")))
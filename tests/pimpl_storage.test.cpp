@@ -0,0 +1,699 @@
+#include "testsCommon.h"
+
+#if !defined(USE_GTEST_TEST)
+#warning "use USE_GTEST_TEST"
+// default
+#define USE_GTEST_TEST 1
+#endif // !defined(USE_GTEST_TEST)
+
+#include <flex_pimpl_plugin/pimpl/CApi.h>
+#include <flex_pimpl_plugin/pimpl/CowPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/CpuDispatchPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/ForwardingMutex.hpp>
+#include <flex_pimpl_plugin/pimpl/HotSwap.hpp>
+#include <flex_pimpl_plugin/pimpl/LazyPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/MemoCache.hpp>
+#include <flex_pimpl_plugin/pimpl/MethodTable.hpp>
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/RcuPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/Reconstruct.hpp>
+#include <flex_pimpl_plugin/pimpl/Snapshot.hpp>
+#include <flex_pimpl_plugin/pimpl/VariantPimpl.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// large enough to not share size class with other types in this file
+struct PooledImpl {
+  explicit PooledImpl(std::string data = "somedata")
+    : data_(std::move(data))
+  {}
+
+  std::string data_;
+
+  char payload_[4096];
+};
+
+struct CountedImpl {
+  CountedImpl()
+  {
+    constructed++;
+  }
+
+  ~CountedImpl()
+  {
+    destroyed++;
+  }
+
+  int value() const
+  {
+    return 42;
+  }
+
+  static int constructed;
+
+  static int destroyed;
+};
+
+int CountedImpl::constructed = 0;
+
+int CountedImpl::destroyed = 0;
+
+// impl that can be used with `allocator = pmr`
+struct PmrImpl {
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+  explicit PmrImpl(const allocator_type& alloc = {})
+    : data_("long enough to not fit into small string buffer", alloc)
+  {}
+
+  allocator_type get_allocator() const
+  {
+    return data_.get_allocator();
+  }
+
+  std::pmr::string data_;
+};
+
+struct SmallImpl {
+  int value() const
+  {
+    return 1;
+  }
+};
+
+struct LargeImpl {
+  explicit LargeImpl(std::string data = "large")
+    : data_(std::move(data))
+  {}
+
+  int value() const
+  {
+    return static_cast<int>(data_.size());
+  }
+
+  std::string data_;
+
+  double payload_[8] = {};
+};
+
+struct NothrowImpl {
+  explicit NothrowImpl(int value) noexcept
+    : value_(value)
+  {}
+
+  int value_;
+};
+
+} // namespace
+
+TEST(pimplStorage, poolReusesFreedSlots) {
+  using Storage = ::flex_pimpl_plugin::PoolPimpl<PooledImpl>;
+
+  const ::flex_pimpl_plugin::pimpl::PoolStats before
+    = Storage::stats();
+
+  {
+    std::vector<Storage> objects;
+    for(int i = 0; i < 8; i++) {
+      objects.emplace_back(std::to_string(i));
+    }
+    EXPECT_EQ(objects[3]->data_, "3");
+  }
+
+  {
+    Storage storage;
+    EXPECT_EQ(storage->data_, "somedata");
+  }
+
+  const ::flex_pimpl_plugin::pimpl::PoolStats after
+    = Storage::stats();
+
+  EXPECT_EQ(after.liveSlots, before.liveSlots);
+  EXPECT_EQ(after.allocations - before.allocations, 9u);
+  EXPECT_EQ(after.deallocations - before.deallocations, 9u);
+  // last allocation must be served from free list
+  EXPECT_GE(after.reusedSlots - before.reusedSlots, 1u);
+  EXPECT_GE(after.slotSize, sizeof(PooledImpl));
+}
+
+TEST(pimplStorage, poolHookRunsOutsideOfLock) {
+  using Storage = ::flex_pimpl_plugin::PoolPimpl<PooledImpl>;
+
+  struct HookState {
+    int calls = 0;
+    size_t liveSlotsInHook = 0;
+    size_t liveSlotsInStats = 0;
+  } state;
+
+  Storage::setStatsHook(
+    [](::flex_pimpl_plugin::pimpl::PoolEvent
+       , const ::flex_pimpl_plugin::pimpl::PoolStats& stats
+       , void* context)
+    {
+      HookState* hookState = static_cast<HookState*>(context);
+      if(hookState->calls++ > 0) {
+        return;
+      }
+      hookState->liveSlotsInHook = stats.liveSlots;
+      // pool must not be locked while hook runs
+      hookState->liveSlotsInStats = Storage::stats().liveSlots;
+      Storage nested("nested");
+    }
+    , &state);
+
+  {
+    // freed slot is reused by next allocation, so hook is called
+    Storage warmup;
+  }
+  Storage storage;
+  Storage::setStatsHook(nullptr, nullptr);
+
+  EXPECT_GE(state.calls, 1);
+  EXPECT_GE(state.liveSlotsInHook, 1u);
+  EXPECT_EQ(state.liveSlotsInStats, state.liveSlotsInHook);
+  EXPECT_EQ(storage->data_, "somedata");
+}
+
+TEST(pimplStorage, poolMoveKeepsPointer) {
+  using Storage = ::flex_pimpl_plugin::PoolPimpl<PooledImpl>;
+
+  Storage first("first");
+  const PooledImpl* ptr = &(*first);
+
+  Storage second(std::move(first));
+  EXPECT_EQ(&(*second), ptr);
+
+  Storage copy(second);
+  EXPECT_NE(&(*copy), ptr);
+  EXPECT_EQ(copy->data_, "first");
+
+  EXPECT_EQ(sizeof(Storage), sizeof(void*));
+}
+
+TEST(pimplStorage, lazyConstructsOnFirstUse) {
+  using Storage = ::flex_pimpl_plugin::LazyPimpl<
+    CountedImpl, sizeof(CountedImpl), alignof(CountedImpl)>;
+
+  CountedImpl::constructed = 0;
+  CountedImpl::destroyed = 0;
+
+  {
+    std::vector<Storage> untouched(16);
+    EXPECT_EQ(CountedImpl::constructed, 0);
+
+    const Storage& used = untouched[3];
+    EXPECT_FALSE(used.isConstructed());
+    EXPECT_EQ(used.get().value(), 42);
+    EXPECT_EQ(used->value(), 42);
+    EXPECT_TRUE(used.isConstructed());
+    EXPECT_EQ(CountedImpl::constructed, 1);
+
+    Storage copy(untouched[3]);
+    EXPECT_TRUE(copy.isConstructed());
+  }
+
+  EXPECT_EQ(CountedImpl::destroyed, 2);
+}
+
+TEST(pimplStorage, variantSwitchesAlternatives) {
+  using Storage = ::flex_pimpl_plugin::VariantPimpl<
+    sizeof(LargeImpl), alignof(LargeImpl), SmallImpl, LargeImpl>;
+
+  // same dispatch as generated forwarders
+  auto value = [](const Storage& storage) {
+    switch(storage.index()) {
+      case 0: return storage.get<0>().value();
+      default: return storage.get<1>().value();
+    }
+  };
+
+  Storage storage;
+  EXPECT_EQ(storage.index(), 0u);
+  EXPECT_TRUE(storage.holds<SmallImpl>());
+  EXPECT_EQ(value(storage), 1);
+
+  storage.emplace<LargeImpl>("four");
+  EXPECT_EQ(storage.index(), 1u);
+  EXPECT_EQ(value(storage), 4);
+
+  Storage copy(storage);
+  EXPECT_EQ(copy.get<LargeImpl>().data_, "four");
+
+  Storage other(std::in_place_type<SmallImpl>);
+  other = std::move(copy);
+  EXPECT_EQ(value(other), 4);
+
+  other = Storage(std::in_place_index<0>);
+  EXPECT_EQ(value(other), 1);
+}
+
+// same constructor call as generated by `allocator = pmr`
+TEST(pimplStorage, poolForwardsPmrAllocator) {
+  using Storage = ::flex_pimpl_plugin::PoolPimpl<PmrImpl>;
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  std::array<std::byte, 1024> buffer;
+  std::pmr::monotonic_buffer_resource arena(
+    buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+  Storage storage{allocator_type(&arena)};
+  EXPECT_EQ(storage->get_allocator().resource(), &arena);
+
+  const std::byte* data
+    = reinterpret_cast<const std::byte*>(storage->data_.data());
+  EXPECT_TRUE(data >= buffer.data()
+              && data < buffer.data() + buffer.size());
+}
+
+TEST(pimplStorage, cowClonesSharedImplOnWrite) {
+  using Storage = ::flex_pimpl_plugin::CowPimpl<LargeImpl>;
+
+  Storage original("shared");
+  Storage copy(original);
+  EXPECT_EQ(&original.read(), &copy.read());
+  EXPECT_EQ(original.useCount(), 2u);
+
+  // const access never copies impl
+  EXPECT_EQ(copy.read().value(), 6);
+  EXPECT_TRUE(copy.isShared());
+
+  copy.write().data_ = "modified";
+  EXPECT_NE(&original.read(), &copy.read());
+  EXPECT_EQ(original.read().data_, "shared");
+  EXPECT_FALSE(original.isShared());
+
+  // impl is not shared, so no clone
+  const LargeImpl* unique = &copy.read();
+  copy.write().data_ = "again";
+  EXPECT_EQ(&copy.read(), unique);
+
+  // shared impl is replaced, not cloned
+  Storage other(copy);
+  other.emplace("replaced");
+  EXPECT_EQ(other.read().data_, "replaced");
+  EXPECT_EQ(copy.read().data_, "again");
+  EXPECT_EQ(&copy.read(), unique);
+  EXPECT_FALSE(copy.isShared());
+
+  EXPECT_EQ(sizeof(Storage), sizeof(void*));
+}
+
+TEST(pimplStorage, rcuPublishesModifiedCloneAndDefersReclamation) {
+  using Storage = ::flex_pimpl_plugin::RcuPimpl<LargeImpl>;
+
+  Storage storage("first");
+  EXPECT_EQ(storage.read()->value(), 5);
+
+  {
+    // reader keeps impl that was published when it started
+    const auto reader = storage.read();
+    storage.write()->data_ = "second";
+    EXPECT_EQ(reader->data_, "first");
+    EXPECT_EQ(storage.read()->data_, "second");
+    EXPECT_EQ(storage.retiredCount(), 1u);
+  }
+
+  // old impl is not read anymore
+  storage.reclaim();
+  EXPECT_EQ(storage.retiredCount(), 0u);
+
+  // modified clone is discarded if method throws
+  try {
+    auto writer = storage.write();
+    writer->data_ = "discarded";
+    throw std::runtime_error("failed");
+  } catch(const std::runtime_error&) {
+  }
+  EXPECT_EQ(storage.read()->data_, "second");
+
+  storage.emplace("third");
+  Storage copy(storage);
+  storage.write()->data_ = "fourth";
+  EXPECT_EQ(copy.read()->data_, "third");
+
+  // readers never observe partially modified impl
+  // (first published impl already satisfies invariant)
+  {
+    auto writer = storage.write();
+    writer->data_.clear();
+    writer->payload_[0] = 0;
+  }
+  std::atomic<bool> isDone{false};
+  std::vector<std::thread> readers;
+  for(int i = 0; i < 2; i++) {
+    readers.emplace_back([&storage, &isDone]() {
+      while(!isDone.load()) {
+        const auto reader = storage.read();
+        EXPECT_EQ(reader->data_.size(), reader->payload_[0]);
+      }
+    });
+  }
+  for(int i = 0; i < 1000; i++) {
+    auto writer = storage.write();
+    writer->data_.assign(i % 16, 'x');
+    writer->payload_[0] = i % 16;
+  }
+  isDone.store(true);
+  for(std::thread& reader : readers) {
+    reader.join();
+  }
+}
+
+TEST(pimplStorage, reconstructReusesStorage) {
+  using Storage = ::flex_pimpl_plugin::PoolPimpl<PooledImpl>;
+
+  Storage storage("first");
+  const PooledImpl* impl = &*storage;
+  const size_t allocations = Storage::stats().allocations;
+
+  // constructor may throw, so impl is assigned from temporary
+  ::flex_pimpl_plugin::pimpl::reconstruct(*storage, "second");
+  EXPECT_EQ(&*storage, impl);
+  EXPECT_EQ(storage->data_, "second");
+  EXPECT_EQ(Storage::stats().allocations, allocations);
+
+  // constructed in place
+  NothrowImpl nothrow(1);
+  ::flex_pimpl_plugin::pimpl::reconstruct(nothrow, 2);
+  EXPECT_EQ(nothrow.value_, 2);
+}
+
+TEST(pimplStorage, memoCacheEvictsOldestEntry) {
+  using Cache = ::flex_pimpl_plugin::pimpl::MemoCache<
+    std::tuple<std::string, int>, int, 2>;
+
+  Cache cache;
+  const std::string key = "key";
+  EXPECT_EQ(cache.find(std::forward_as_tuple(key, 1)), nullptr);
+  EXPECT_EQ(cache.insert(std::forward_as_tuple(key, 1), 10), 10);
+  cache.insert(std::forward_as_tuple(key, 2), 20);
+  ASSERT_NE(cache.find(std::forward_as_tuple(key, 1)), nullptr);
+  EXPECT_EQ(*cache.find(std::forward_as_tuple(key, 2)), 20);
+
+  // capacity is 2, so first entry is replaced
+  cache.insert(std::forward_as_tuple(key, 3), 30);
+  EXPECT_EQ(cache.find(std::forward_as_tuple(key, 1)), nullptr);
+  EXPECT_EQ(*cache.find(std::forward_as_tuple(key, 3)), 30);
+  EXPECT_EQ(cache.hits(), 3u);
+  EXPECT_EQ(cache.misses(), 2u);
+
+  // results of moved-from impl are not valid
+  Cache moved(std::move(cache));
+  EXPECT_EQ(cache.find(std::forward_as_tuple(key, 3)), nullptr);
+  EXPECT_EQ(*moved.find(std::forward_as_tuple(key, 3)), 30);
+
+  moved.clear();
+  EXPECT_EQ(moved.find(std::forward_as_tuple(key, 3)), nullptr);
+}
+
+namespace {
+
+struct BaselineKernel {
+  int run() const { return 1; }
+};
+
+struct AvxKernel {
+  int run() const { return 2; }
+};
+
+} // namespace
+
+TEST(pimplStorage, cpuDispatchSelectsSupportedAlternative) {
+  using namespace ::flex_pimpl_plugin::pimpl;
+
+  // last supported alternative wins
+  EXPECT_EQ(selectCpuAlternative(
+    {kCpuBaseline, kCpuAvx2, kCpuAvx2 | kCpuAvx512f}
+    , kCpuAvx | kCpuAvx2), 1u);
+  EXPECT_EQ(selectCpuAlternative(
+    {kCpuBaseline, kCpuAvx2, kCpuAvx2 | kCpuAvx512f}
+    , kCpuAvx2 | kCpuAvx512f), 2u);
+  EXPECT_EQ(selectCpuAlternative(
+    {kCpuBaseline, kCpuAvx2}, kCpuBaseline), 0u);
+
+  // baseline is always supported
+  using Storage = ::flex_pimpl_plugin::CpuDispatchPimpl<
+    CpuFeatureList<kCpuBaseline, kCpuBaseline>
+    , sizeof(int), alignof(int), BaselineKernel, AvxKernel>;
+  Storage storage;
+  EXPECT_EQ(Storage::selectedIndex(), 1u);
+  EXPECT_EQ(storage.index(), 1u);
+  EXPECT_EQ(storage.get<1>().run(), 2);
+
+  const Storage copy(storage);
+  EXPECT_EQ(copy.index(), 1u);
+
+  storage.emplaceSelected();
+  EXPECT_EQ(storage.index(), 1u);
+}
+
+namespace {
+
+// same layout as table generated for `hot_swap`
+struct KernelTable {
+  ::flex_pimpl_plugin::pimpl::ImplLayout layout;
+  int (*run)(int arg);
+};
+
+constexpr KernelTable kOldKernel{
+  {sizeof(int), alignof(int), 1, 2}
+  , [](int arg) { return arg; }
+};
+
+constexpr KernelTable kNewKernel{
+  {sizeof(int), alignof(int), 1, 2}
+  , [](int arg) { return arg * 2; }
+};
+
+// fields of impl changed
+constexpr KernelTable kIncompatibleKernel{
+  {sizeof(int), alignof(int), 3, 2}
+  , [](int arg) { return arg * 3; }
+};
+
+} // namespace
+
+TEST(pimplStorage, hotSwapChecksLayout) {
+  ::flex_pimpl_plugin::pimpl::HotSwapSlot<KernelTable> slot(&kOldKernel);
+  EXPECT_EQ(slot.get().run(2), 2);
+
+  EXPECT_TRUE(slot.swap(&kNewKernel));
+  EXPECT_EQ(slot.get().run(2), 4);
+
+  EXPECT_FALSE(slot.swap(&kIncompatibleKernel));
+  EXPECT_EQ(slot.get().run(2), 4);
+}
+
+namespace {
+
+struct Adder {
+  int add(int lhs, const int& rhs) const
+  {
+    return base + lhs + rhs;
+  }
+
+  int base = 1;
+};
+
+constexpr size_t kAddSlot
+  = ::flex_pimpl_plugin::pimpl::methodNameHash("add", /*seed*/ 0) % 2;
+
+// same layout as table generated for `by_name`, with one empty slot
+constexpr std::array<::flex_pimpl_plugin::pimpl::MethodEntry, 2>
+  kAdderMethods = []() {
+    std::array<::flex_pimpl_plugin::pimpl::MethodEntry, 2> table{};
+    table[kAddSlot] = {"add"
+      , [](void* object, void* const* args, void* result) {
+          ::new (result) int(static_cast<const Adder*>(object)->add(
+            ::std::move(*static_cast<int*>(args[0]))
+            , *static_cast<const int*>(args[1])));
+        }
+      , 2, true};
+    return table;
+  }();
+
+} // namespace
+
+TEST(pimplStorage, methodTableFindsMethodByName) {
+  using ::flex_pimpl_plugin::pimpl::findMethodEntry;
+  using ::flex_pimpl_plugin::pimpl::MethodEntry;
+
+  const MethodEntry* entry = findMethodEntry(kAdderMethods, 0, "add");
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->arity, 2u);
+  EXPECT_TRUE(entry->isConst);
+
+  Adder adder;
+  int lhs = 2;
+  const int rhs = 3;
+  void* const args[] = {&lhs, const_cast<int*>(&rhs)};
+  int result = 0;
+  entry->invoke(&adder, args, &result);
+  EXPECT_EQ(result, 6);
+
+  // names that land in slot of other method or in empty slot
+  for(const std::string_view name : {"ad", "sub", "add ", "", "x"}) {
+    EXPECT_FALSE(findMethodEntry(kAdderMethods, 0, name)) << name;
+  }
+  EXPECT_FALSE(findMethodEntry(std::array<MethodEntry, 0>{}, 0, "add"));
+}
+
+TEST(pimplStorage, cApiCopiesStringIntoBufferOfCaller) {
+  using ::flex_pimpl_plugin::pimpl::copyToBuffer;
+
+  char buffer[4] = {'x', 'x', 'x', 'x'};
+
+  // caller can retry with buffer of returned size
+  EXPECT_EQ(copyToBuffer("somedata", buffer, sizeof(buffer)), 8u);
+  EXPECT_EQ(std::string(buffer, sizeof(buffer)), "some");
+
+  EXPECT_EQ(copyToBuffer("ab", buffer, sizeof(buffer)), 2u);
+  EXPECT_EQ(std::string(buffer, 2), "ab");
+
+  // size can be queried without buffer
+  EXPECT_EQ(copyToBuffer("somedata", nullptr, 0), 8u);
+
+  const std::string data = "somedata";
+  const flex_pimpl_string_view view{data.data(), data.size()};
+  EXPECT_EQ(view.data, data.data());
+}
+
+TEST(pimplStorage, snapshotOfFieldsRoundTrips) {
+  using ::flex_pimpl_plugin::pimpl::readSnapshot;
+  using ::flex_pimpl_plugin::pimpl::snapshotSize;
+  using ::flex_pimpl_plugin::pimpl::writeSnapshot;
+
+  struct Point {
+    int x;
+    double y;
+  };
+
+  const Point point{1, 2.5};
+  const std::string text = "somedata";
+  const std::vector<int> numbers = {1, 2, 3};
+  const std::vector<std::string> words = {"a", "", "bc"};
+
+  // trivially copyable values are copied as is
+  EXPECT_EQ(snapshotSize(point), sizeof(Point));
+  EXPECT_EQ(snapshotSize(text), sizeof(uint64_t) + 8);
+  EXPECT_EQ(snapshotSize(numbers), sizeof(uint64_t) + 3 * sizeof(int));
+  EXPECT_EQ(snapshotSize(words), sizeof(uint64_t) * 4 + 3);
+
+  std::vector<char> buffer(
+    snapshotSize(point)
+    + snapshotSize(text)
+    + snapshotSize(numbers)
+    + snapshotSize(words));
+  char* out = buffer.data();
+  out = writeSnapshot(point, out);
+  out = writeSnapshot(text, out);
+  out = writeSnapshot(numbers, out);
+  out = writeSnapshot(words, out);
+  EXPECT_EQ(out, buffer.data() + buffer.size());
+
+  Point restoredPoint{0, 0};
+  // existing elements are replaced
+  std::string restoredText = "old";
+  std::vector<int> restoredNumbers = {7, 7, 7, 7, 7};
+  std::vector<std::string> restoredWords;
+  const char* end = buffer.data() + buffer.size();
+  const char* in = buffer.data();
+  in = readSnapshot(restoredPoint, in, end);
+  in = readSnapshot(restoredText, in, end);
+  in = readSnapshot(restoredNumbers, in, end);
+  in = readSnapshot(restoredWords, in, end);
+  EXPECT_EQ(in, end);
+
+  EXPECT_EQ(restoredPoint.x, 1);
+  EXPECT_EQ(restoredPoint.y, 2.5);
+  EXPECT_EQ(restoredText, text);
+  EXPECT_EQ(restoredNumbers, numbers);
+  EXPECT_EQ(restoredWords, words);
+}
+
+TEST(pimplStorage, snapshotReadRejectsShortInput) {
+  using ::flex_pimpl_plugin::pimpl::readSnapshot;
+  using ::flex_pimpl_plugin::pimpl::writeSnapshot;
+
+  const std::vector<std::string> words = {"a", "", "bc"};
+  std::vector<char> buffer(
+    ::flex_pimpl_plugin::pimpl::snapshotSize(words));
+  writeSnapshot(words, buffer.data());
+
+  // every truncation of input is detected
+  for(size_t size = 0; size < buffer.size(); size++) {
+    std::vector<std::string> restored;
+    EXPECT_EQ(
+      readSnapshot(restored, buffer.data(), buffer.data() + size)
+      , nullptr);
+  }
+
+  // count that does not fit into input is not allocated
+  std::vector<char> garbage(sizeof(uint64_t), '\xff');
+  std::string text;
+  EXPECT_EQ(
+    readSnapshot(text, garbage.data(), garbage.data() + garbage.size())
+    , nullptr);
+  std::vector<int> numbers;
+  EXPECT_EQ(
+    readSnapshot(numbers, garbage.data(), garbage.data() + garbage.size())
+    , nullptr);
+
+  // failed read is propagated by chained reads
+  int value = 0;
+  EXPECT_EQ(readSnapshot(value, nullptr, nullptr), nullptr);
+}
+
+TEST(pimplStorage, sharedForwardingMutexAllowsConcurrentReaders) {
+  using Mutex
+    = ::flex_pimpl_plugin::pimpl::ForwardingMutex<std::shared_mutex>;
+
+  Mutex mutex;
+
+  // mutex must not be locked twice by same thread
+  auto tryFromOtherThread = [&mutex](bool isShared) {
+    bool isLocked = false;
+    std::thread([&mutex, &isLocked, isShared]() {
+      isLocked = isShared ? mutex.try_lock_shared() : mutex.try_lock();
+      if(isLocked) {
+        isShared ? mutex.unlock_shared() : mutex.unlock();
+      }
+    }).join();
+    return isLocked;
+  };
+
+  {
+    // similar to forwarders of const methods with `locking = shared`
+    std::shared_lock reader(mutex);
+    EXPECT_TRUE(tryFromOtherThread(true));
+    EXPECT_FALSE(tryFromOtherThread(false));
+  }
+
+  {
+    // forwarders of non-const methods
+    std::lock_guard writer(mutex);
+    EXPECT_FALSE(tryFromOtherThread(true));
+  }
+
+  // copy of interface gets own unlocked mutex
+  std::shared_lock reader(mutex);
+  Mutex copy(mutex);
+  EXPECT_TRUE(copy.try_lock());
+  copy.unlock();
+}
@@ -0,0 +1,178 @@
+#include "testsCommon.h"
+
+#if !defined(USE_GTEST_TEST)
+#warning "use USE_GTEST_TEST"
+// default
+#define USE_GTEST_TEST 1
+#endif // !defined(USE_GTEST_TEST)
+
+#include <flex_pimpl_plugin/pimpl/ForwardingMutex.hpp>
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/RcuPimpl.hpp>
+
+#include <base/compiler_specific.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+static const int kReadsPerThread = 1 << 18;
+
+static const int kIterations = 5;
+
+// writes performed by separate thread during measurement
+static const int kWriteCounts[] = {0, 100};
+
+// routing table: short lookups, rare updates
+struct BenchImpl {
+  NOINLINE uint64_t route(int key) const
+  {
+    return routes[static_cast<size_t>(key) % kRoutes] ^ version;
+  }
+
+  NOINLINE void update(int key)
+  {
+    routes[static_cast<size_t>(key) % kRoutes] += 1;
+    version++;
+  }
+
+  static constexpr size_t kRoutes = 16;
+
+  uint64_t routes[kRoutes] = {};
+
+  uint64_t version = 1;
+};
+
+// Same layout as generated interface with `storage = pool`
+// and `locking = shared` (readers lock shared mutex).
+// Forwarders are defined out-of-line (in Foo.cc),
+// so they can not be inlined into caller.
+class SharedMutexFoo {
+public:
+  NOINLINE uint64_t route(int key) const
+  {
+    ::std::shared_lock implLock(implMutex_);
+    return impl_->route(key);
+  }
+
+  NOINLINE void update(int key)
+  {
+    ::std::lock_guard implLock(implMutex_);
+    return impl_->update(key);
+  }
+
+private:
+  ::flex_pimpl_plugin::PoolPimpl<BenchImpl> impl_;
+
+  mutable ::flex_pimpl_plugin::pimpl::ForwardingMutex<
+    ::std::shared_mutex> implMutex_;
+};
+
+// Same layout as generated interface with `storage = rcu`.
+class RcuFoo {
+public:
+  NOINLINE uint64_t route(int key) const
+  {
+    return impl_.read()->route(key);
+  }
+
+  NOINLINE void update(int key)
+  {
+    return impl_.write()->update(key);
+  }
+
+private:
+  ::flex_pimpl_plugin::RcuPimpl<BenchImpl> impl_;
+};
+
+// All reader threads call same object,
+// writer thread spreads |writeCount| updates over measurement.
+template <typename Foo>
+double measureReads(int threadCount, int writeCount)
+{
+  using clock = std::chrono::steady_clock;
+  clock::duration total{};
+  std::atomic<uint64_t> checksum{0};
+
+  for(int iteration = 0; iteration < kIterations; iteration++) {
+    Foo foo;
+    std::atomic<bool> isStarted{false};
+    std::atomic<int> activeReaders{threadCount};
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < threadCount; t++) {
+      threads.emplace_back([&foo, &isStarted, &checksum, &activeReaders]() {
+        while(!isStarted.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        uint64_t sum = 0;
+        for(int i = 0; i < kReadsPerThread; i++) {
+          sum += foo.route(i);
+        }
+        checksum.fetch_add(sum, std::memory_order_relaxed);
+        activeReaders.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    std::thread writer([&foo, &isStarted, &activeReaders, writeCount]() {
+      while(!isStarted.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for(int i = 0;
+          i < writeCount && activeReaders.load(std::memory_order_acquire);
+          i++)
+      {
+        foo.update(i);
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    });
+
+    const clock::time_point start = clock::now();
+    isStarted.store(true, std::memory_order_release);
+    for(std::thread& thread : threads) {
+      thread.join();
+    }
+    total += clock::now() - start;
+    writer.join();
+  }
+
+  EXPECT_NE(checksum.load(), 0u);
+
+  return std::chrono::duration<double, std::milli>(total).count()
+    / kIterations;
+}
+
+} // namespace
+
+TEST(rcuBenchmark, multiCoreReads) {
+  const int maxThreads = static_cast<int>(
+    std::max(2u, std::thread::hardware_concurrency()));
+
+  for(const int writeCount : kWriteCounts) {
+    for(int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+      const double sharedMs
+        = measureReads<SharedMutexFoo>(threadCount, writeCount);
+      const double rcuMs
+        = measureReads<RcuFoo>(threadCount, writeCount);
+
+      std::cout
+        << threadCount
+        << " reader threads, "
+        << writeCount
+        << " writes: locking = shared "
+        << sharedMs
+        << " ms, storage = rcu "
+        << rcuMs
+        << " ms"
+        << std::endl;
+    }
+  }
+}
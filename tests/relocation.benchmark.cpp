@@ -0,0 +1,121 @@
+#include "testsCommon.h"
+
+#if !defined(USE_GTEST_TEST)
+#warning "use USE_GTEST_TEST"
+// default
+#define USE_GTEST_TEST 1
+#endif // !defined(USE_GTEST_TEST)
+
+#include <flex_pimpl_plugin/pimpl/PoolPimpl.hpp>
+#include <flex_pimpl_plugin/pimpl/Relocatable.hpp>
+
+#include <base/compiler_specific.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace {
+
+static const size_t kElementCount = 1 << 16;
+
+static const int kIterations = 20;
+
+struct BenchImpl {
+  std::unique_ptr<int> value = std::make_unique<int>(1);
+};
+
+// Same layout as generated interface with `storage = pool`.
+// Special members of pimpl interface are defined out-of-line
+// (in Foo.cc), so they can not be inlined into container code.
+template <bool kMarkRelocatable>
+class BenchFoo {
+public:
+  // similar to code generated if interface is trivially relocatable
+  using IsRelocatable
+    = std::integral_constant<bool, kMarkRelocatable>;
+
+  NOINLINE BenchFoo() = default;
+
+  NOINLINE BenchFoo(BenchFoo&& other) noexcept
+    : impl_(std::move(other.impl_))
+  {}
+
+  NOINLINE ~BenchFoo() {}
+
+  int value() const
+  {
+    return *impl_->value;
+  }
+
+private:
+  ::flex_pimpl_plugin::PoolPimpl<BenchImpl> impl_;
+};
+
+// Grows buffer same way as std::vector does on reallocation,
+// but relocates elements via memcpy if type allows it.
+template <typename T>
+double measureGrowth()
+{
+  using clock = std::chrono::steady_clock;
+  clock::duration total{};
+
+  for(int iteration = 0; iteration < kIterations; iteration++) {
+    size_t capacity = 1;
+    size_t size = 0;
+    T* buffer = static_cast<T*>(::operator new(sizeof(T) * capacity));
+
+    for(size_t i = 0; i < kElementCount; i++) {
+      if(size == capacity) {
+        T* grown = static_cast<T*>(
+          ::operator new(sizeof(T) * capacity * 2));
+        const clock::time_point start = clock::now();
+        ::flex_pimpl_plugin::pimpl::relocate(buffer, size, grown);
+        total += clock::now() - start;
+        ::operator delete(buffer);
+        buffer = grown;
+        capacity *= 2;
+      }
+      ::new (static_cast<void*>(buffer + size)) T();
+      size++;
+    }
+
+    EXPECT_EQ(buffer[size - 1].value(), 1);
+
+    for(size_t i = 0; i < size; i++) {
+      buffer[i].~T();
+    }
+    ::operator delete(buffer);
+  }
+
+  return std::chrono::duration<double, std::milli>(total).count()
+    / kIterations;
+}
+
+} // namespace
+
+TEST(relocationBenchmark, vectorGrowth) {
+  static_assert(
+    !::flex_pimpl_plugin::pimpl::kIsTriviallyRelocatable<BenchFoo<false>>
+    , "expected move + destroy on growth");
+  static_assert(
+    ::flex_pimpl_plugin::pimpl::kIsTriviallyRelocatable<BenchFoo<true>>
+    , "expected memcpy on growth");
+
+  const double moveMs = measureGrowth<BenchFoo<false>>();
+  const double relocateMs = measureGrowth<BenchFoo<true>>();
+
+  std::cout
+    << "growth to "
+    << kElementCount
+    << " elements: move + destroy "
+    << moveMs
+    << " ms, memcpy relocation "
+    << relocateMs
+    << " ms"
+    << std::endl;
+}